@@ -2,11 +2,18 @@
 
 #pragma once
 
+class AnimationScheduler;
+class JobSystem;
+
 class Application
 {
 private:
     Application(const Application&);
     Application& operator=(const Application&);
+
+protected:
+    AnimationScheduler* mAnimationScheduler = 0;
+    JobSystem* mJobSystem = 0;
     
 public:
     Application() = default;
@@ -15,4 +22,11 @@ public:
     virtual void Update(float inDeltaTime) {}
     virtual void Render(float inAspectRatio) {}
     virtual void Shutdown() {}
+
+    // Set by the main loop before Initialize. Per character animation work is
+    // registered with it and run within its budget after Update each frame.
+    void SetAnimationScheduler(AnimationScheduler* inScheduler) { mAnimationScheduler = inScheduler; }
+    // Set by the main loop before Initialize. Update can fan per character work
+    // out with ParallelFor or job trees and wait on it before returning.
+    void SetJobSystem(JobSystem* inJobSystem) { mJobSystem = inJobSystem; }
 };
@@ -6,10 +6,17 @@
 #define WIN32_EXTRA_LEAN
 
 #include "glad/glad.h"
+#include "glad/glad_lazy.h"
 #undef APIENTRY
 #include <windows.h>
+#include <mmsystem.h>
 #include <iostream>
 #include "Application.h"
+#include "anim/AnimationScheduler.h"
+#include "core/FramePacer.h"
+#include "core/JobSystem.h"
+#include "render/FrameFences.h"
+#include "render/GLTrace.h"
 
 int WINAPI WinMain(HINSTANCE, HINSTANCE, PSTR, int);
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
@@ -23,6 +30,7 @@ int main(int argc, const char** argv) {
 #pragma comment( linker, "/subsystem:windows" )
 #endif
 #pragma comment(lib, "opengl32.lib")
+#pragma comment(lib, "winmm.lib")
 
 #define WGL_CONTEXT_MAJOR_VERSION_ARB     0x2091
 #define WGL_CONTEXT_MINOR_VERSION_ARB     0x2092
@@ -35,11 +43,47 @@ typedef const char* (WINAPI* PFNWGLGETEXTENSIONSSTRINGEXTPROC) (void);
 typedef BOOL(WINAPI* PFNWGLSWAPINTERVALEXTPROC) (int);
 typedef int (WINAPI* PFNWGLGETSWAPINTERVALEXTPROC) (void);
 
+// GL_LOADER_FULL resolves every GL 3.3 entry point up front (stock glad).
+// GL_LOADER_LAZY resolves allow-listed entry points on first call.
+// GL_LOADER_ALLOWLIST resolves only the allow-listed entry points, up front.
+// Functions missing from the allow-list stay null in the last two, so only
+// build with them after "python tools/gen_glad_allowlist.py --check" passes.
+#define GL_LOADER_FULL 0
+#define GL_LOADER_LAZY 1
+#define GL_LOADER_ALLOWLIST 2
+#ifndef GL_LOADER_MODE
+#define GL_LOADER_MODE GL_LOADER_FULL
+#endif
+
+#define TARGET_FRAME_RATE 60.0f
+#define MINIMIZED_FRAME_RATE 10.0f
+#define MAX_FRAMES_IN_FLIGHT 2
+// Milliseconds of animation work per frame before characters are deferred
+#define ANIMATION_BUDGET_MS 2.0f
+
 Application* gApplication = 0;
 GLuint gVertexArrayObject = 0;
+FrameFences gFrameFences;
+
+// GL 1.1 entry points are only exported by opengl32.dll, everything newer
+// comes from the driver through wglGetProcAddress.
+void* GetGLProcAddress(const char* name) {
+	void* proc = (void*)wglGetProcAddress(name);
+	if (proc == 0 || proc == (void*)0x1 || proc == (void*)0x2 || proc == (void*)0x3 || proc == (void*)-1) {
+		proc = (void*)GetProcAddress(GetModuleHandleA("opengl32.dll"), name);
+	}
+	return proc;
+}
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine, int iCmdShow) {
+	SystemFrameClock frameClock;
+	double startTime = frameClock.Now();
+	AnimationScheduler animationScheduler(&frameClock);
+	animationScheduler.SetBudget(ANIMATION_BUDGET_MS);
+	JobSystem jobSystem;
 	gApplication = new Application();
+	gApplication->SetAnimationScheduler(&animationScheduler);
+	gApplication->SetJobSystem(&jobSystem);
 	WNDCLASSEX wndclass;
 	wndclass.cbSize = sizeof(WNDCLASSEX);
 	wndclass.style = CS_HREDRAW | CS_VREDRAW;
@@ -99,13 +143,31 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 	wglDeleteContext(tempRC);
 	wglMakeCurrent(hdc, hglrc);
 
-	if (!gladLoadGL()) {
+	double loadStart = frameClock.Now();
+#if GL_LOADER_MODE == GL_LOADER_LAZY
+	int glLoaded = gladLoadGLLazy(GetGLProcAddress);
+#elif GL_LOADER_MODE == GL_LOADER_ALLOWLIST
+	int glLoaded = gladLoadGLAllowList(GetGLProcAddress);
+#else
+	int glLoaded = gladLoadGL();
+#endif
+	double loadTime = frameClock.Now() - loadStart;
+	std::cout << "GL loader took " << loadTime * 1000.0 << "ms\n";
+	if (!glLoaded) {
 		std::cout << "Could not initialize GLAD\n";
 	}
 	else {
 		std::cout << "OpenGL Version " << GLVersion.major << "." << GLVersion.minor << " loaded\n";
 	}
 
+#if GL_TRACE
+	if (strstr(szCmdLine, "--gltrace") != 0) {
+		if (GLTraceBegin("gltrace.bin")) {
+			std::cout << "Tracing GL calls to gltrace.bin\n";
+		}
+	}
+#endif
+
 	PFNWGLGETEXTENSIONSSTRINGEXTPROC _wglGetExtensionsStringEXT = (PFNWGLGETEXTENSIONSSTRINGEXTPROC)wglGetProcAddress("wglGetExtensionsStringEXT");
 	bool swapControlSupported = strstr(_wglGetExtensionsStringEXT(), "WGL_EXT_swap_control") != 0;
 
@@ -133,21 +195,48 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 	UpdateWindow(hwnd);
 	gApplication->Initialize();
 
-	DWORD lastTick = GetTickCount();
+	// 1ms scheduler resolution so the pacer can sleep instead of spinning
+	timeBeginPeriod(1);
+	FramePacer framePacer(&frameClock);
+	framePacer.SetTargetRate(vsynch != 0 ? 0.0f : TARGET_FRAME_RATE);
+	gFrameFences.SetMaxFramesInFlight(MAX_FRAMES_IN_FLIGHT);
+
+	double lastTime = frameClock.Now();
+	bool minimized = false;
+	bool firstFrame = true;
 	MSG msg;
-	while (true) {
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+	bool quit = false;
+	while (!quit) {
+		// Drain every pending message so input queued during a long frame isn't
+		// spread out one message per frame
+		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
 			if (msg.message == WM_QUIT) {
+				quit = true;
 				break;
 			}
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
-		DWORD thisTick = GetTickCount();
-		float deltaTime = float(thisTick - lastTick) * 0.001f;
-		lastTick = thisTick;
+		if (quit) {
+			break;
+		}
+		// Nothing is presented while minimized, so vsync can't pace the loop
+		bool isIconic = IsIconic(hwnd) != 0;
+		if (isIconic != minimized) {
+			minimized = isIconic;
+			if (minimized) {
+				framePacer.SetTargetRate(MINIMIZED_FRAME_RATE);
+			}
+			else {
+				framePacer.SetTargetRate(vsynch != 0 ? 0.0f : TARGET_FRAME_RATE);
+			}
+		}
+		double thisTime = frameClock.Now();
+		float deltaTime = float(thisTime - lastTime);
+		lastTime = thisTime;
 		if (gApplication != 0) {
 			gApplication->Update(deltaTime);
+			animationScheduler.Run(deltaTime);
 		}
 		if (gApplication != 0) {
 			RECT clientRect;
@@ -168,11 +257,43 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 		}
 		if (gApplication != 0) {
 			SwapBuffers(hdc);
-			if (vsynch != 0) {
-				glFinish();
+			gFrameFences.EndFrame();
+#if GL_TRACE
+			GLTraceFrame();
+#endif
+			if (firstFrame) {
+				firstFrame = false;
+				std::cout << "Time to first frame: " << (frameClock.Now() - startTime) * 1000.0 << "ms";
+#if GL_LOADER_MODE != GL_LOADER_FULL
+				std::cout << " (" << gladLazyResolvedCount() << " of " << gladLazyListSize() << " GL functions resolved)";
+#endif
+				std::cout << "\n";
 			}
 		}
+		framePacer.Wait();
 	} // End of game loop
+	timeEndPeriod(1);
+#if GL_TRACE
+	GLTraceEnd();
+#endif
+
+	FramePacerStats pacing = framePacer.GetStats();
+	std::cout << "Frames: " << pacing.frames
+		<< ", average frame time: " << pacing.averageFrameTime * 1000.0 << "ms"
+		<< ", jitter: " << pacing.jitter * 1000.0 << "ms"
+		<< ", worst deviation: " << pacing.maxDeviation * 1000.0 << "ms"
+		<< ", CPU utilisation: " << pacing.cpuUtilisation * 100.0 << "%"
+		<< ", GPU stalls: " << gFrameFences.GetStallCount() << "\n";
+
+	const AnimationSchedulerStats& animation = animationScheduler.GetStats();
+	std::cout << "Animation: " << animation.totalDeferred << " deferred updates"
+		<< ", longest deferral: " << animation.maxDeferredFrames << " frames"
+		<< ", over budget on " << animation.framesOverBudget << " of " << animation.frames << " frames"
+		<< ", worst overrun: " << animation.maxOverrun * 1000.0 << "ms\n";
+
+	JobSystemStats jobs = jobSystem.GetStats();
+	std::cout << "Jobs: " << jobs.executed << " executed, " << jobs.stolen << " stolen"
+		<< " on " << jobSystem.GetWorkerCount() + 1 << " threads\n";
 
 	if (gApplication != 0) {
 		std::cout << "Expected application to be null on exit\n";
@@ -199,6 +320,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT iMsg, WPARAM wParam, LPARAM lParam) {
 			HDC hdc = GetDC(hwnd);
 			HGLRC hglrc = wglGetCurrentContext();
 
+			gFrameFences.Release();
 			glBindVertexArray(0);
 			glDeleteVertexArrays(1, &gVertexArrayObject);
 			gVertexArrayObject = 0;
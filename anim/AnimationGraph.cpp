@@ -0,0 +1,604 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "AnimationGraph.h"
+#include "Blending.h"
+
+unsigned int AnimationGraphDesc::AddParameter(const std::string& name, float value)
+{
+    mParameterNames.push_back(name);
+    mParameterDefaults.push_back(value);
+    return (unsigned int)mParameterNames.size() - 1;
+}
+
+unsigned int AnimationGraphDesc::AddClip(const BakedClip* clip, float speed)
+{
+    AnimationGraphNode node;
+    node.mType = AnimationGraphNodeType::Clip;
+    node.mBakedClip = clip;
+    node.mSpeed = speed;
+    mNodes.push_back(node);
+    return (unsigned int)mNodes.size() - 1;
+}
+
+unsigned int AnimationGraphDesc::AddClip(const CompressedClip* clip, float speed)
+{
+    AnimationGraphNode node;
+    node.mType = AnimationGraphNodeType::Clip;
+    node.mCompressedClip = clip;
+    node.mSpeed = speed;
+    mNodes.push_back(node);
+    return (unsigned int)mNodes.size() - 1;
+}
+
+unsigned int AnimationGraphDesc::AddBlend(unsigned int a, unsigned int b, unsigned int parameter)
+{
+    AnimationGraphNode node;
+    node.mType = AnimationGraphNodeType::Blend;
+    node.mInputs[0] = a;
+    node.mInputs[1] = b;
+    node.mParameter = (int)parameter;
+    mNodes.push_back(node);
+    return (unsigned int)mNodes.size() - 1;
+}
+
+unsigned int AnimationGraphDesc::AddBlend(unsigned int a, unsigned int b, unsigned int parameter, const std::vector<float>& mask)
+{
+    unsigned int result = AddBlend(a, b, parameter);
+    mMasks.push_back(mask);
+    mNodes[result].mMask = (int)mMasks.size() - 1;
+    return result;
+}
+
+unsigned int AnimationGraphDesc::AddAdditive(unsigned int base, unsigned int delta, unsigned int parameter)
+{
+    AnimationGraphNode node;
+    node.mType = AnimationGraphNodeType::Add;
+    node.mInputs[0] = base;
+    node.mInputs[1] = delta;
+    node.mParameter = (int)parameter;
+    mNodes.push_back(node);
+    return (unsigned int)mNodes.size() - 1;
+}
+
+unsigned int AnimationGraphDesc::AddBlendSpace(const BlendSpace2D* space, unsigned int x, unsigned int y, float speed)
+{
+    AnimationGraphNode node;
+    node.mType = AnimationGraphNodeType::BlendSpace;
+    node.mBlendSpace = space;
+    node.mParameter = (int)x;
+    node.mParameterY = (int)y;
+    node.mSpeed = speed;
+    mNodes.push_back(node);
+    return (unsigned int)mNodes.size() - 1;
+}
+
+unsigned int AnimationGraphDesc::AddStateMachine()
+{
+    AnimationGraphNode node;
+    node.mType = AnimationGraphNodeType::StateMachine;
+    node.mMachine = (unsigned int)mMachines.size();
+    mMachines.push_back(AnimationStateMachine());
+    mNodes.push_back(node);
+    return (unsigned int)mNodes.size() - 1;
+}
+
+AnimationStateMachine& AnimationGraphDesc::GetMachine(unsigned int node)
+{
+    return mMachines[mNodes[node].mMachine];
+}
+
+unsigned int AnimationGraphDesc::AddState(unsigned int machineNode, const std::string& name, unsigned int node)
+{
+    AnimationStateMachine& machine = GetMachine(machineNode);
+    machine.mStates.push_back(node);
+    machine.mStateNames.push_back(name);
+    return (unsigned int)machine.mStates.size() - 1;
+}
+
+void AnimationGraphDesc::AddTransition(unsigned int machineNode, const AnimationTransition& transition)
+{
+    GetMachine(machineNode).mTransitions.push_back(transition);
+}
+
+void AnimationGraphInstance::SetParameter(unsigned int parameter, float value)
+{
+    if (parameter < mParameters.size())
+    {
+        mParameters[parameter] = value;
+    }
+}
+
+float AnimationGraphInstance::GetParameter(unsigned int parameter) const
+{
+    if (parameter < mParameters.size())
+    {
+        return mParameters[parameter];
+    }
+    return 0.0f;
+}
+
+unsigned int AnimationGraphInstance::GetState(unsigned int machine) const
+{
+    const MachineState& state = mMachines[machine];
+    return state.mNext >= 0 ? (unsigned int)state.mNext : state.mCurrent;
+}
+
+bool AnimationGraphInstance::IsInTransition(unsigned int machine) const
+{
+    return mMachines[machine].mNext >= 0;
+}
+
+const AnimationGraphStats& AnimationGraphInstance::GetStats() const
+{
+    return mStats;
+}
+
+void AnimationGraphInstance::ResetStats()
+{
+    mStats = AnimationGraphStats();
+}
+
+AnimationGraph::AnimationGraph()
+{
+    mSlotCount = 0;
+}
+
+int AnimationGraph::Emit(const AnimationGraphDesc& desc, unsigned int node, unsigned int slot, std::vector<bool>& visiting)
+{
+    if (node >= desc.mNodes.size())
+    {
+        std::cout << "WARNING: Animation graph references missing node " << node << "\n";
+        return -1;
+    }
+    if (visiting[node])
+    {
+        std::cout << "WARNING: Animation graph node " << node << " is part of a cycle\n";
+        return -1;
+    }
+    if (slot + 1 > mSlotCount)
+    {
+        mSlotCount = slot + 1;
+    }
+
+    const AnimationGraphNode& source = desc.mNodes[node];
+    Instruction instruction;
+    instruction.mFirst = (unsigned int)mInstructions.size();
+    instruction.mSlot = slot;
+    instruction.mInputs[0] = 0;
+    instruction.mInputs[1] = 0;
+    instruction.mIndex = -1;
+    instruction.mParameter = source.mParameter;
+    instruction.mSpeed = source.mSpeed;
+
+    visiting[node] = true;
+    bool valid = true;
+    switch (source.mType)
+    {
+    case AnimationGraphNodeType::Clip:
+    {
+        if ((source.mBakedClip == 0) == (source.mCompressedClip == 0))
+        {
+            std::cout << "WARNING: Animation graph clip node " << node << " needs exactly one clip\n";
+            valid = false;
+            break;
+        }
+        instruction.mOp = AnimationGraphOp::Clip;
+        ClipSource clip;
+        clip.mBaked = source.mBakedClip;
+        clip.mCompressed = source.mCompressedClip;
+        instruction.mIndex = (int)mClips.size();
+        mClips.push_back(clip);
+        break;
+    }
+    case AnimationGraphNodeType::Blend:
+    case AnimationGraphNodeType::Add:
+    {
+        if (source.mParameter < 0 || source.mParameter >= (int)mParameterNames.size())
+        {
+            std::cout << "WARNING: Animation graph node " << node << " has no valid parameter\n";
+            valid = false;
+            break;
+        }
+        instruction.mOp = source.mType == AnimationGraphNodeType::Blend ? AnimationGraphOp::Blend : AnimationGraphOp::Add;
+        if (source.mMask >= 0)
+        {
+            if (source.mMask >= (int)desc.mMasks.size() || desc.mMasks[source.mMask].size() < mRestPose.Size())
+            {
+                std::cout << "WARNING: Animation graph node " << node << " has an invalid mask\n";
+                valid = false;
+                break;
+            }
+            instruction.mIndex = (int)mMasks.size();
+            mMasks.push_back(desc.mMasks[source.mMask]);
+        }
+        // Inputs go to consecutive slots from this node's, so a's result
+        // survives while b is evaluated and the blend can run in place in a's slot
+        for (unsigned int i = 0; i < 2 && valid; ++i)
+        {
+            int input = Emit(desc, source.mInputs[i], slot + i, visiting);
+            valid = input >= 0;
+            instruction.mInputs[i] = (unsigned int)input;
+        }
+        break;
+    }
+    case AnimationGraphNodeType::BlendSpace:
+    {
+        int parameters = (int)mParameterNames.size();
+        if (source.mBlendSpace == 0 || source.mBlendSpace->GetTriangleCount() == 0 ||
+            source.mParameter < 0 || source.mParameter >= parameters ||
+            source.mParameterY < 0 || source.mParameterY >= parameters)
+        {
+            std::cout << "WARNING: Animation graph blend space node " << node << " needs a built space and two parameters\n";
+            valid = false;
+            break;
+        }
+        instruction.mOp = AnimationGraphOp::BlendSpace;
+        instruction.mIndex = (int)mBlendSpaces.size();
+        BlendSpaceSource space;
+        space.mSpace = source.mBlendSpace;
+        space.mParameterY = source.mParameterY;
+        mBlendSpaces.push_back(space);
+        // Its clips are sampled into this slot and the next
+        if (slot + 2 > mSlotCount)
+        {
+            mSlotCount = slot + 2;
+        }
+        break;
+    }
+    case AnimationGraphNodeType::StateMachine:
+    {
+        if (source.mMachine >= desc.mMachines.size() || desc.mMachines[source.mMachine].mStates.empty())
+        {
+            std::cout << "WARNING: Animation graph state machine node " << node << " has no states\n";
+            valid = false;
+            break;
+        }
+        const AnimationStateMachine& sourceMachine = desc.mMachines[source.mMachine];
+        unsigned int stateCount = (unsigned int)sourceMachine.mStates.size();
+        for (unsigned int i = 0, size = (unsigned int)sourceMachine.mTransitions.size(); i < size; ++i)
+        {
+            const AnimationTransition& transition = sourceMachine.mTransitions[i];
+            if (transition.mFrom >= stateCount || transition.mTo >= stateCount || transition.mParameter >= mParameterNames.size())
+            {
+                std::cout << "WARNING: Animation graph state machine node " << node << " has an invalid transition\n";
+                valid = false;
+            }
+        }
+        if (!valid)
+        {
+            break;
+        }
+        instruction.mOp = AnimationGraphOp::StateMachine;
+        instruction.mIndex = (int)mMachines.size();
+        mMachines.push_back(Machine());
+
+        // State i is evaluated into slot + i: any two can be live at once
+        std::vector<unsigned int> states(stateCount);
+        for (unsigned int i = 0; i < stateCount && valid; ++i)
+        {
+            int state = Emit(desc, sourceMachine.mStates[i], slot + i, visiting);
+            valid = state >= 0;
+            states[i] = (unsigned int)state;
+        }
+        Machine& machine = mMachines[instruction.mIndex];
+        machine.mStates = states;
+        machine.mStateNames = sourceMachine.mStateNames;
+        machine.mStateNames.resize(stateCount);
+        machine.mTransitions = sourceMachine.mTransitions;
+        machine.mDefaultState = sourceMachine.mDefaultState < stateCount ? sourceMachine.mDefaultState : 0;
+        break;
+    }
+    }
+    visiting[node] = false;
+
+    if (!valid)
+    {
+        return -1;
+    }
+    mInstructions.push_back(instruction);
+    return (int)mInstructions.size() - 1;
+}
+
+bool AnimationGraph::Compile(const AnimationGraphDesc& desc, unsigned int output, const Pose& restPose)
+{
+    mInstructions.clear();
+    mClips.clear();
+    mMasks.clear();
+    mMachines.clear();
+    mBlendSpaces.clear();
+    mParameterNames = desc.mParameterNames;
+    mParameterDefaults = desc.mParameterDefaults;
+    mRestPose = restPose;
+    mSlotCount = 0;
+
+    std::vector<bool> visiting(desc.mNodes.size(), false);
+    if (Emit(desc, output, 0, visiting) < 0)
+    {
+        mInstructions.clear();
+        mClips.clear();
+        mMasks.clear();
+        mMachines.clear();
+        mBlendSpaces.clear();
+        mSlotCount = 0;
+        return false;
+    }
+    return true;
+}
+
+void AnimationGraph::CreateInstance(AnimationGraphInstance& outInstance) const
+{
+    outInstance.mSlots.assign(mSlotCount, mRestPose);
+    outInstance.mParameters = mParameterDefaults;
+    outInstance.mTimes.assign(mInstructions.size(), 0.0f);
+    outInstance.mWeights.assign(mInstructions.size(), 0.0f);
+    outInstance.mMachines.resize(mMachines.size());
+    for (unsigned int i = 0, size = (unsigned int)mMachines.size(); i < size; ++i)
+    {
+        outInstance.mMachines[i] = AnimationGraphInstance::MachineState();
+        outInstance.mMachines[i].mCurrent = mMachines[i].mDefaultState;
+    }
+    outInstance.ResetStats();
+}
+
+float AnimationGraph::GetParameter(const AnimationGraphInstance& instance, int parameter) const
+{
+    float value = instance.mParameters[parameter];
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+void AnimationGraph::ResetTimes(AnimationGraphInstance& instance, unsigned int root) const
+{
+    for (unsigned int i = mInstructions[root].mFirst; i <= root; ++i)
+    {
+        instance.mTimes[i] = 0.0f;
+    }
+}
+
+void AnimationGraph::UpdateMachines(AnimationGraphInstance& instance, float deltaTime) const
+{
+    for (unsigned int m = 0, size = (unsigned int)mMachines.size(); m < size; ++m)
+    {
+        const Machine& machine = mMachines[m];
+        AnimationGraphInstance::MachineState& state = instance.mMachines[m];
+
+        if (state.mNext >= 0)
+        {
+            state.mElapsed += deltaTime;
+            if (state.mElapsed >= state.mDuration)
+            {
+                state.mCurrent = (unsigned int)state.mNext;
+                state.mNext = -1;
+            }
+            // No new transition until this one is done
+            continue;
+        }
+
+        for (unsigned int t = 0, count = (unsigned int)machine.mTransitions.size(); t < count; ++t)
+        {
+            const AnimationTransition& transition = machine.mTransitions[t];
+            if (transition.mFrom != state.mCurrent || transition.mTo == state.mCurrent)
+            {
+                continue;
+            }
+            float value = instance.mParameters[transition.mParameter];
+            bool taken = transition.mCondition == AnimationCondition::Greater ?
+                value > transition.mThreshold : value < transition.mThreshold;
+            if (!taken)
+            {
+                continue;
+            }
+
+            ResetTimes(instance, machine.mStates[transition.mTo]);
+            if (transition.mDuration > 0.0f)
+            {
+                state.mNext = (int)transition.mTo;
+                state.mElapsed = 0.0f;
+                state.mDuration = transition.mDuration;
+            }
+            else
+            {
+                state.mCurrent = transition.mTo;
+            }
+            break;
+        }
+    }
+}
+
+void AnimationGraph::PropagateWeights(AnimationGraphInstance& instance) const
+{
+    unsigned int count = (unsigned int)mInstructions.size();
+    float* weights = &instance.mWeights[0];
+    memset(weights, 0, sizeof(float) * count);
+    weights[count - 1] = 1.0f;
+
+    // Inputs always come before the instruction using them, so one backwards
+    // pass reaches every instruction after all of its users
+    for (unsigned int i = count; i-- > 0;)
+    {
+        float weight = weights[i];
+        if (weight <= 0.0f)
+        {
+            continue;
+        }
+        const Instruction& instruction = mInstructions[i];
+        switch (instruction.mOp)
+        {
+        case AnimationGraphOp::Clip:
+        case AnimationGraphOp::BlendSpace:
+            break;
+        case AnimationGraphOp::Blend:
+        {
+            float t = GetParameter(instance, instruction.mParameter);
+            // A masked blend keeps a on joints outside the mask, whatever t is
+            weights[instruction.mInputs[0]] = instruction.mIndex >= 0 ? weight : weight * (1.0f - t);
+            weights[instruction.mInputs[1]] = weight * t;
+            break;
+        }
+        case AnimationGraphOp::Add:
+            weights[instruction.mInputs[0]] = weight;
+            weights[instruction.mInputs[1]] = weight * GetParameter(instance, instruction.mParameter);
+            break;
+        case AnimationGraphOp::StateMachine:
+        {
+            const Machine& machine = mMachines[instruction.mIndex];
+            const AnimationGraphInstance::MachineState& state = instance.mMachines[instruction.mIndex];
+            float t = 0.0f;
+            if (state.mNext >= 0)
+            {
+                t = state.mDuration > 0.0f ? state.mElapsed / state.mDuration : 1.0f;
+                t = t > 1.0f ? 1.0f : t;
+                weights[machine.mStates[state.mNext]] = weight * t;
+            }
+            weights[machine.mStates[state.mCurrent]] = weight * (1.0f - t);
+            break;
+        }
+        }
+    }
+}
+
+void AnimationGraph::Evaluate(AnimationGraphInstance& instance, float deltaTime, Pose& outPose) const
+{
+    if (mInstructions.empty())
+    {
+        return;
+    }
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    UpdateMachines(instance, deltaTime);
+    PropagateWeights(instance);
+
+    unsigned int run = 0;
+    for (unsigned int i = 0, count = (unsigned int)mInstructions.size(); i < count; ++i)
+    {
+        if (instance.mWeights[i] <= 0.0f)
+        {
+            continue;
+        }
+        ++run;
+        const Instruction& instruction = mInstructions[i];
+        Pose& slot = instance.mSlots[instruction.mSlot];
+        switch (instruction.mOp)
+        {
+        case AnimationGraphOp::Clip:
+        {
+            const ClipSource& clip = mClips[instruction.mIndex];
+            float time = instance.mTimes[i] + deltaTime * instruction.mSpeed;
+            if (clip.mBaked != 0)
+            {
+                instance.mTimes[i] = clip.mBaked->Sample(slot, time);
+            }
+            else
+            {
+                instance.mTimes[i] = clip.mCompressed->Sample(slot, time);
+            }
+            break;
+        }
+        case AnimationGraphOp::Blend:
+        {
+            // a is in this slot; when its weight is 0, t is 1 and b is copied over
+            const Pose& b = instance.mSlots[instruction.mSlot + 1];
+            float t = GetParameter(instance, instruction.mParameter);
+            if (instruction.mIndex >= 0)
+            {
+                Blend(slot, slot, b, t, mMasks[instruction.mIndex]);
+            }
+            else
+            {
+                Blend(slot, slot, b, t);
+            }
+            break;
+        }
+        case AnimationGraphOp::Add:
+            Add(slot, slot, instance.mSlots[instruction.mSlot + 1], GetParameter(instance, instruction.mParameter));
+            break;
+        case AnimationGraphOp::BlendSpace:
+        {
+            const BlendSpaceSource& source = mBlendSpaces[instruction.mIndex];
+            BlendSpaceWeights weights = source.mSpace->GetWeights(
+                instance.mParameters[instruction.mParameter], instance.mParameters[source.mParameterY]);
+            float phase = source.mSpace->AdvancePhase(weights, instance.mTimes[i], deltaTime * instruction.mSpeed);
+            source.mSpace->Sample(&slot, weights, phase);
+            instance.mTimes[i] = phase;
+            break;
+        }
+        case AnimationGraphOp::StateMachine:
+        {
+            const AnimationGraphInstance::MachineState& state = instance.mMachines[instruction.mIndex];
+            const Pose& current = instance.mSlots[instruction.mSlot + state.mCurrent];
+            if (state.mNext >= 0)
+            {
+                const Pose& next = instance.mSlots[instruction.mSlot + state.mNext];
+                float t = state.mDuration > 0.0f ? state.mElapsed / state.mDuration : 1.0f;
+                Blend(slot, current, next, t);
+            }
+            else if (&current != &slot)
+            {
+                memcpy(slot.GetLocalTransforms(), current.GetLocalTransforms(), sizeof(Transform) * slot.Size());
+            }
+            break;
+        }
+        }
+    }
+
+    const Pose& result = instance.mSlots[mInstructions.back().mSlot];
+    if (outPose.Size() != result.Size())
+    {
+        outPose = result;
+    }
+    else if (result.Size() > 0)
+    {
+        memcpy(outPose.GetLocalTransforms(), result.GetLocalTransforms(), sizeof(Transform) * result.Size());
+    }
+
+    instance.mStats.evaluations += 1;
+    instance.mStats.instructionsRun += run;
+    instance.mStats.instructionsSkipped += mInstructions.size() - run;
+    instance.mStats.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int AnimationGraph::FindParameter(const std::string& name) const
+{
+    for (unsigned int i = 0, size = (unsigned int)mParameterNames.size(); i < size; ++i)
+    {
+        if (mParameterNames[i] == name)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int AnimationGraph::FindState(unsigned int machine, const std::string& name) const
+{
+    if (machine >= mMachines.size())
+    {
+        return -1;
+    }
+    const std::vector<std::string>& names = mMachines[machine].mStateNames;
+    for (unsigned int i = 0, size = (unsigned int)names.size(); i < size; ++i)
+    {
+        if (names[i] == name)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+unsigned int AnimationGraph::GetInstructionCount() const
+{
+    return (unsigned int)mInstructions.size();
+}
+
+unsigned int AnimationGraph::GetSlotCount() const
+{
+    return mSlotCount;
+}
+
+unsigned int AnimationGraph::GetMachineCount() const
+{
+    return (unsigned int)mMachines.size();
+}
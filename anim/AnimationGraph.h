@@ -0,0 +1,234 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "BakedClip.h"
+#include "BlendSpace.h"
+#include "CompressedClip.h"
+#include "Pose.h"
+
+enum class AnimationGraphNodeType
+{
+    Clip,
+    Blend,
+    Add,
+    StateMachine,
+    BlendSpace
+};
+
+enum class AnimationCondition
+{
+    Greater,
+    Less
+};
+
+struct AnimationGraphNode
+{
+    AnimationGraphNodeType mType = AnimationGraphNodeType::Clip;
+    // Clip: one of the two is set
+    const BakedClip* mBakedClip = 0;
+    const CompressedClip* mCompressedClip = 0;
+    float mSpeed = 1.0f;
+    // Blend: a and b. Add: base and additive delta.
+    unsigned int mInputs[2] = { 0, 0 };
+    // Blend factor or additive weight. BlendSpace: x, with mParameterY for y.
+    int mParameter = -1;
+    int mParameterY = -1;
+    const BlendSpace2D* mBlendSpace = 0;
+    // Blend: index into the description's masks, or -1 for the whole pose
+    int mMask = -1;
+    // StateMachine: index into the description's machines
+    unsigned int mMachine = 0;
+};
+
+struct AnimationTransition
+{
+    unsigned int mFrom = 0;
+    unsigned int mTo = 0;
+    // Taken when the parameter compares to the threshold
+    unsigned int mParameter = 0;
+    AnimationCondition mCondition = AnimationCondition::Greater;
+    float mThreshold = 0.0f;
+    // Crossfade length in seconds
+    float mDuration = 0.2f;
+};
+
+struct AnimationStateMachine
+{
+    // Node evaluated for each state
+    std::vector<unsigned int> mStates;
+    std::vector<std::string> mStateNames;
+    // Checked in order; the first that holds is taken
+    std::vector<AnimationTransition> mTransitions;
+    unsigned int mDefaultState = 0;
+};
+
+// Authoring side of an animation graph: nodes referencing each other by index,
+// built in code or from data at load time and then compiled.
+class AnimationGraphDesc
+{
+public:
+    std::vector<AnimationGraphNode> mNodes;
+    std::vector<AnimationStateMachine> mMachines;
+    std::vector<std::vector<float>> mMasks;
+    std::vector<std::string> mParameterNames;
+    std::vector<float> mParameterDefaults;
+
+    unsigned int AddParameter(const std::string& name, float value = 0.0f);
+    unsigned int AddClip(const BakedClip* clip, float speed = 1.0f);
+    unsigned int AddClip(const CompressedClip* clip, float speed = 1.0f);
+    // mix(a, b, parameter), optionally per joint through a mask (see MakeBoneMask)
+    unsigned int AddBlend(unsigned int a, unsigned int b, unsigned int parameter);
+    unsigned int AddBlend(unsigned int a, unsigned int b, unsigned int parameter, const std::vector<float>& mask);
+    // base with the additive clip layer delta on top, weighted by parameter
+    unsigned int AddAdditive(unsigned int base, unsigned int delta, unsigned int parameter);
+    // Phase synchronised blend of the space's clips around (x, y). The space must
+    // be built and outlive the compiled graph.
+    unsigned int AddBlendSpace(const BlendSpace2D* space, unsigned int x, unsigned int y, float speed = 1.0f);
+
+    // Returns the node; states and transitions refer to it through GetMachine
+    unsigned int AddStateMachine();
+    AnimationStateMachine& GetMachine(unsigned int node);
+    unsigned int AddState(unsigned int machineNode, const std::string& name, unsigned int node);
+    void AddTransition(unsigned int machineNode, const AnimationTransition& transition);
+};
+
+struct AnimationGraphStats
+{
+    // Since ResetStats
+    unsigned long long evaluations = 0;
+    unsigned long long instructionsRun = 0;
+    unsigned long long instructionsSkipped = 0;
+    double seconds = 0.0;
+
+    double GetSecondsPerEvaluation() const { return evaluations > 0 ? seconds / evaluations : 0.0; }
+};
+
+class AnimationGraph;
+
+// Everything one character needs to evaluate a compiled graph: parameter values,
+// playback times, state machine progress and the pose slots, all sized once by
+// AnimationGraph::CreateInstance.
+class AnimationGraphInstance
+{
+    friend class AnimationGraph;
+
+protected:
+    struct MachineState
+    {
+        unsigned int mCurrent = 0;
+        int mNext = -1;
+        float mElapsed = 0.0f;
+        float mDuration = 0.0f;
+    };
+
+    std::vector<Pose> mSlots;
+    std::vector<float> mParameters;
+    // Per instruction: playback time of clips, phase of blend spaces
+    std::vector<float> mTimes;
+    // Per instruction: share of the output, 0 for skipped branches
+    std::vector<float> mWeights;
+    std::vector<MachineState> mMachines;
+    AnimationGraphStats mStats;
+
+public:
+    void SetParameter(unsigned int parameter, float value);
+    float GetParameter(unsigned int parameter) const;
+    // State the machine is in, or heading to during a transition
+    unsigned int GetState(unsigned int machine) const;
+    bool IsInTransition(unsigned int machine) const;
+
+    const AnimationGraphStats& GetStats() const;
+    void ResetStats();
+};
+
+enum class AnimationGraphOp
+{
+    Clip,
+    Blend,
+    Add,
+    StateMachine,
+    BlendSpace
+};
+
+// A graph compiled to a flat list of instructions in evaluation order (every
+// node after its inputs). Each instruction writes one pose slot; inputs are
+// evaluated into consecutive slots starting at their parent's, so slots are
+// reused like a stack and a graph needs as many as its deepest branch.
+//
+// Evaluate first pushes weights from the output down to the inputs, then runs
+// the list forward, skipping every instruction whose weight is zero: the unused
+// side of a blend, inactive states. There are no virtual calls and nothing is
+// allocated. The compiled graph is read only and shared by every character
+// using it.
+class AnimationGraph
+{
+protected:
+    struct Instruction
+    {
+        AnimationGraphOp mOp;
+        // First instruction of the subtree ending here
+        unsigned int mFirst;
+        unsigned int mSlot;
+        // Instructions producing the inputs
+        unsigned int mInputs[2];
+        // Clip, mask, machine or blend space index
+        int mIndex;
+        int mParameter;
+        float mSpeed;
+    };
+
+    struct ClipSource
+    {
+        const BakedClip* mBaked;
+        const CompressedClip* mCompressed;
+    };
+
+    struct BlendSpaceSource
+    {
+        const BlendSpace2D* mSpace;
+        int mParameterY;
+    };
+
+    struct Machine
+    {
+        // Root instruction of each state
+        std::vector<unsigned int> mStates;
+        std::vector<std::string> mStateNames;
+        std::vector<AnimationTransition> mTransitions;
+        unsigned int mDefaultState;
+    };
+
+    std::vector<Instruction> mInstructions;
+    std::vector<ClipSource> mClips;
+    std::vector<std::vector<float>> mMasks;
+    std::vector<Machine> mMachines;
+    std::vector<BlendSpaceSource> mBlendSpaces;
+    std::vector<std::string> mParameterNames;
+    std::vector<float> mParameterDefaults;
+    Pose mRestPose;
+    unsigned int mSlotCount;
+
+    int Emit(const AnimationGraphDesc& desc, unsigned int node, unsigned int slot, std::vector<bool>& visiting);
+    void ResetTimes(AnimationGraphInstance& instance, unsigned int root) const;
+    void UpdateMachines(AnimationGraphInstance& instance, float deltaTime) const;
+    void PropagateWeights(AnimationGraphInstance& instance) const;
+    float GetParameter(const AnimationGraphInstance& instance, int parameter) const;
+
+public:
+    AnimationGraph();
+
+    // Flattens the graph reachable from output. restPose sizes the slots and
+    // fills joints a clip doesn't animate. Returns false for invalid graphs.
+    bool Compile(const AnimationGraphDesc& desc, unsigned int output, const Pose& restPose);
+
+    void CreateInstance(AnimationGraphInstance& outInstance) const;
+    // Advances the instance by deltaTime and writes the graph's output pose
+    void Evaluate(AnimationGraphInstance& instance, float deltaTime, Pose& outPose) const;
+
+    int FindParameter(const std::string& name) const;
+    int FindState(unsigned int machine, const std::string& name) const;
+    unsigned int GetInstructionCount() const;
+    unsigned int GetSlotCount() const;
+    unsigned int GetMachineCount() const;
+};
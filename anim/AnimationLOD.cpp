@@ -0,0 +1,215 @@
+#include <iostream>
+#include <utility>
+
+#include "AnimationLOD.h"
+
+AnimationLOD::AnimationLOD()
+{
+    mFrame = 0;
+    for (unsigned int i = 0; i < ANIMLOD_BUCKET_COUNT; ++i)
+    {
+        mNextPhase[i] = 0;
+    }
+}
+
+void AnimationLOD::SetSettings(const AnimationLODSettings& settings)
+{
+    mSettings = settings;
+}
+
+const AnimationLODSettings& AnimationLOD::GetSettings() const
+{
+    return mSettings;
+}
+
+unsigned int AnimationLOD::Register()
+{
+    unsigned int handle = 0;
+    if (!mFree.empty())
+    {
+        handle = mFree.back();
+        mFree.pop_back();
+    }
+    else
+    {
+        handle = (unsigned int)mInstances.size();
+        mInstances.push_back(Instance());
+    }
+
+    Instance& instance = mInstances[handle];
+    instance = Instance();
+    instance.mActive = true;
+    AssignBucket(instance, 0);
+    return handle;
+}
+
+void AnimationLOD::Unregister(unsigned int handle)
+{
+    if (handle >= mInstances.size() || !mInstances[handle].mActive)
+    {
+        std::cout << "WARNING: Unregistering unknown animation LOD handle " << handle << "\n";
+        return;
+    }
+    Instance& instance = mInstances[handle];
+    mStats.instances[instance.mBucket] -= 1;
+    instance = Instance();
+    mFree.push_back(handle);
+}
+
+unsigned int AnimationLOD::PickBucket(const Instance& instance, float screenSize) const
+{
+    for (unsigned int b = 0; b < ANIMLOD_BUCKET_COUNT - 1; ++b)
+    {
+        // Moving to a finer bucket takes clearly exceeding its threshold,
+        // leaving the current one takes clearly dropping below it
+        float margin = b < instance.mBucket ? 1.0f + ANIMLOD_HYSTERESIS : 1.0f - ANIMLOD_HYSTERESIS;
+        if (screenSize >= mSettings.bucketScreenSize[b] * margin)
+        {
+            return b;
+        }
+    }
+    return ANIMLOD_BUCKET_COUNT - 1;
+}
+
+void AnimationLOD::AssignBucket(Instance& instance, unsigned int bucket)
+{
+    instance.mBucket = bucket;
+    // Round robin phases spread each bucket evenly across its period
+    unsigned int period = 1u << bucket;
+    instance.mPhase = mNextPhase[bucket];
+    mNextPhase[bucket] = (mNextPhase[bucket] + 1) % period;
+    mStats.instances[bucket] += 1;
+}
+
+void AnimationLOD::BeginFrame(float deltaTime)
+{
+    mFrame += 1;
+    mStats.frames += 1;
+    for (unsigned int i = 0, size = (unsigned int)mInstances.size(); i < size; ++i)
+    {
+        if (mInstances[i].mActive)
+        {
+            mInstances[i].mSinceUpdate += deltaTime;
+        }
+    }
+}
+
+void AnimationLOD::SetScreenSize(unsigned int handle, float screenSize)
+{
+    Instance& instance = mInstances[handle];
+    instance.mScreenSize = screenSize;
+
+    unsigned int bucket = PickBucket(instance, screenSize);
+    if (bucket != instance.mBucket)
+    {
+        mStats.instances[instance.mBucket] -= 1;
+        AssignBucket(instance, bucket);
+    }
+
+    if (screenSize >= mSettings.precisionScreenSize[0])
+    {
+        instance.mPrecision = AnimationPrecision::Full;
+    }
+    else if (screenSize >= mSettings.precisionScreenSize[1])
+    {
+        instance.mPrecision = AnimationPrecision::Baked;
+    }
+    else
+    {
+        instance.mPrecision = AnimationPrecision::Compressed;
+    }
+}
+
+bool AnimationLOD::ShouldUpdate(unsigned int handle, float& outDeltaTime)
+{
+    Instance& instance = mInstances[handle];
+    unsigned int period = 1u << instance.mBucket;
+    // Always update until there are two poses to extrapolate from
+    bool due = instance.mHistory < 2 || ((mFrame + instance.mPhase) % period) == 0;
+    if (!due)
+    {
+        outDeltaTime = 0.0f;
+        return false;
+    }
+
+    outDeltaTime = instance.mSinceUpdate;
+    instance.mLastInterval = instance.mSinceUpdate;
+    instance.mSinceUpdate = 0.0f;
+    mStats.updates[instance.mBucket] += 1;
+    return true;
+}
+
+void AnimationLOD::Submit(unsigned int handle, const Pose& pose)
+{
+    Instance& instance = mInstances[handle];
+    // Swap so both history poses keep their allocations
+    std::swap(instance.mPrevious, instance.mLast);
+    instance.mLast = pose;
+    if (instance.mHistory < 2)
+    {
+        instance.mHistory += 1;
+    }
+}
+
+void AnimationLOD::Extrapolate(unsigned int handle, Pose& outPose)
+{
+    Instance& instance = mInstances[handle];
+    mStats.extrapolated[instance.mBucket] += 1;
+    if (instance.mHistory == 0)
+    {
+        return;
+    }
+    if (instance.mHistory == 1 || instance.mLastInterval <= 0.0f || instance.mPrevious.Size() != instance.mLast.Size())
+    {
+        outPose = instance.mLast;
+        return;
+    }
+
+    // Extrapolation is only trusted for one update interval
+    float ratio = instance.mSinceUpdate / instance.mLastInterval;
+    if (ratio > 1.0f)
+    {
+        ratio = 1.0f;
+    }
+    if (outPose.Size() != instance.mLast.Size())
+    {
+        outPose = instance.mLast;
+    }
+    const Transform* previous = instance.mPrevious.GetLocalTransforms();
+    const Transform* last = instance.mLast.GetLocalTransforms();
+    Transform* out = outPose.GetLocalTransforms();
+    for (unsigned int i = 0, size = instance.mLast.Size(); i < size; ++i)
+    {
+        out[i] = mix(previous[i], last[i], 1.0f + ratio);
+    }
+}
+
+unsigned int AnimationLOD::GetBucket(unsigned int handle) const
+{
+    return mInstances[handle].mBucket;
+}
+
+unsigned int AnimationLOD::GetUpdatePeriod(unsigned int handle) const
+{
+    return 1u << mInstances[handle].mBucket;
+}
+
+AnimationPrecision AnimationLOD::GetPrecision(unsigned int handle) const
+{
+    return mInstances[handle].mPrecision;
+}
+
+const AnimationLODStats& AnimationLOD::GetStats() const
+{
+    return mStats;
+}
+
+void AnimationLOD::ResetStats()
+{
+    for (unsigned int i = 0; i < ANIMLOD_BUCKET_COUNT; ++i)
+    {
+        mStats.updates[i] = 0;
+        mStats.extrapolated[i] = 0;
+    }
+    mStats.frames = 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "Pose.h"
+
+// Update periods 1, 2, 4 and 8 frames
+#define ANIMLOD_BUCKET_COUNT 4
+// Fraction of the bucket's threshold a character must cross back over before it
+// changes bucket again, so one hovering at a threshold doesn't flip every frame
+#define ANIMLOD_HYSTERESIS 0.1f
+
+// Which sampler a character should use, finest first: the authored Clip, the
+// BakedClip, the CompressedClip
+enum class AnimationPrecision
+{
+    Full,
+    Baked,
+    Compressed
+};
+
+struct AnimationLODSettings
+{
+    // Minimum screen size (projected height / viewport height) for buckets 0..2;
+    // anything smaller goes in the last bucket
+    float bucketScreenSize[ANIMLOD_BUCKET_COUNT - 1] = { 0.25f, 0.1f, 0.03f };
+    // Minimum screen size for Full and Baked precision
+    float precisionScreenSize[2] = { 0.4f, 0.08f };
+};
+
+struct AnimationLODStats
+{
+    unsigned int instances[ANIMLOD_BUCKET_COUNT] = { 0 };
+    // Since the last ResetStats
+    unsigned int updates[ANIMLOD_BUCKET_COUNT] = { 0 };
+    unsigned int extrapolated[ANIMLOD_BUCKET_COUNT] = { 0 };
+    unsigned int frames = 0;
+};
+
+// Reduces how often small, distant characters are animated. Each character is
+// put in a bucket by screen size; bucket b updates every 2^b frames. Characters
+// within a bucket are given staggered phases so each frame updates an even share
+// of them rather than all of them every 2^b frames. On frames a character is not
+// updated its pose is extrapolated from its last two updates.
+//
+// Per frame: BeginFrame, then for each character SetScreenSize and ShouldUpdate;
+// sample with the returned delta time and Submit the pose, or call Extrapolate.
+class AnimationLOD
+{
+protected:
+    struct Instance
+    {
+        Pose mPrevious;
+        Pose mLast;
+        float mLastInterval = 0.0f;
+        float mSinceUpdate = 0.0f;
+        float mScreenSize = 1.0f;
+        unsigned int mBucket = 0;
+        unsigned int mPhase = 0;
+        unsigned int mHistory = 0;
+        AnimationPrecision mPrecision = AnimationPrecision::Full;
+        bool mActive = false;
+    };
+
+    std::vector<Instance> mInstances;
+    std::vector<unsigned int> mFree;
+    AnimationLODSettings mSettings;
+    AnimationLODStats mStats;
+    unsigned int mFrame;
+    // Next phase handed out per bucket
+    unsigned int mNextPhase[ANIMLOD_BUCKET_COUNT];
+
+    unsigned int PickBucket(const Instance& instance, float screenSize) const;
+    void AssignBucket(Instance& instance, unsigned int bucket);
+
+public:
+    AnimationLOD();
+
+    void SetSettings(const AnimationLODSettings& settings);
+    const AnimationLODSettings& GetSettings() const;
+
+    unsigned int Register();
+    void Unregister(unsigned int handle);
+
+    void BeginFrame(float deltaTime);
+    void SetScreenSize(unsigned int handle, float screenSize);
+    // True if the character is due this frame. outDeltaTime is the time since
+    // its last update, to advance playback by.
+    bool ShouldUpdate(unsigned int handle, float& outDeltaTime);
+    // Records the pose sampled after ShouldUpdate returned true
+    void Submit(unsigned int handle, const Pose& pose);
+    // Continues the motion between the last two submitted poses to now
+    void Extrapolate(unsigned int handle, Pose& outPose);
+
+    unsigned int GetBucket(unsigned int handle) const;
+    unsigned int GetUpdatePeriod(unsigned int handle) const;
+    AnimationPrecision GetPrecision(unsigned int handle) const;
+
+    const AnimationLODStats& GetStats() const;
+    void ResetStats();
+};
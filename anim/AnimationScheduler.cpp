@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <iostream>
+
+#include "AnimationScheduler.h"
+#include "../core/FramePacer.h"
+
+AnimationScheduler::AnimationScheduler(FrameClock* inClock)
+{
+    mClock = inClock;
+    mBudget = ANIMSCHEDULER_DEFAULT_BUDGET / 1000.0;
+}
+
+void AnimationScheduler::SetBudget(float inMilliseconds)
+{
+    mBudget = inMilliseconds > 0.0f ? inMilliseconds / 1000.0 : 0.0;
+}
+
+float AnimationScheduler::GetBudget() const
+{
+    return (float)(mBudget * 1000.0);
+}
+
+unsigned int AnimationScheduler::Add(AnimationTask* task)
+{
+    unsigned int handle = 0;
+    if (!mFree.empty())
+    {
+        handle = mFree.back();
+        mFree.pop_back();
+    }
+    else
+    {
+        handle = (unsigned int)mEntries.size();
+        mEntries.push_back(Entry());
+    }
+    mEntries[handle] = Entry();
+    mEntries[handle].mTask = task;
+    return handle;
+}
+
+void AnimationScheduler::Remove(unsigned int handle)
+{
+    if (handle >= mEntries.size() || mEntries[handle].mTask == 0)
+    {
+        std::cout << "WARNING: Removing unknown animation task " << handle << "\n";
+        return;
+    }
+    mEntries[handle] = Entry();
+    mFree.push_back(handle);
+}
+
+void AnimationScheduler::SetVisibility(unsigned int handle, bool onScreen, float distance)
+{
+    mEntries[handle].mOnScreen = onScreen;
+    mEntries[handle].mDistance = distance < 0.0f ? 0.0f : distance;
+}
+
+void AnimationScheduler::Run(float inDeltaTime)
+{
+    double start = mClock->Now();
+
+    mOrder.clear();
+    for (unsigned int i = 0, size = (unsigned int)mEntries.size(); i < size; ++i)
+    {
+        Entry& entry = mEntries[i];
+        if (entry.mTask == 0)
+        {
+            continue;
+        }
+        entry.mPendingTime += inDeltaTime;
+        // Lower runs first
+        entry.mPriority = entry.mDistance / (float)(1 + entry.mDeferredFrames);
+        mOrder.push_back(i);
+    }
+    // On screen tasks sort before every off screen one, then by priority
+    std::sort(mOrder.begin(), mOrder.end(), [this](unsigned int a, unsigned int b) {
+        const Entry& left = mEntries[a];
+        const Entry& right = mEntries[b];
+        if (left.mOnScreen != right.mOnScreen)
+        {
+            return left.mOnScreen;
+        }
+        return left.mPriority < right.mPriority;
+    });
+
+    unsigned int run = 0;
+    unsigned int deferred = 0;
+    double now = start;
+    for (unsigned int i = 0, size = (unsigned int)mOrder.size(); i < size; ++i)
+    {
+        Entry& entry = mEntries[mOrder[i]];
+        bool overBudget = now - start >= mBudget;
+        if (overBudget && entry.mDeferredFrames < ANIMSCHEDULER_MAX_DEFERRED_FRAMES)
+        {
+            entry.mDeferredFrames += 1;
+            mStats.maxDeferredFrames = std::max(mStats.maxDeferredFrames, entry.mDeferredFrames);
+            deferred += 1;
+            continue;
+        }
+
+        float pending = entry.mPendingTime;
+        entry.mPendingTime = 0.0f;
+        entry.mDeferredFrames = 0;
+        entry.mTask->Animate(pending);
+        run += 1;
+        now = mClock->Now();
+    }
+
+    double elapsed = now - start;
+    mStats.run = run;
+    mStats.deferred = deferred;
+    mStats.elapsed = elapsed;
+    mStats.overrun = elapsed > mBudget ? elapsed - mBudget : 0.0;
+    mStats.frames += 1;
+    mStats.totalDeferred += deferred;
+    if (mStats.overrun > 0.0)
+    {
+        mStats.framesOverBudget += 1;
+        mStats.maxOverrun = std::max(mStats.maxOverrun, mStats.overrun);
+    }
+}
+
+const AnimationSchedulerStats& AnimationScheduler::GetStats() const
+{
+    return mStats;
+}
+
+void AnimationScheduler::ResetStats()
+{
+    mStats = AnimationSchedulerStats();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+class FrameClock;
+
+// Default per frame budget for animation work, in milliseconds
+#define ANIMSCHEDULER_DEFAULT_BUDGET 2.0f
+// A task deferred this many frames in a row runs regardless of the budget
+#define ANIMSCHEDULER_MAX_DEFERRED_FRAMES 8
+
+// One character's animation update. Animate receives all time accumulated since
+// it last ran, so deferred characters catch up instead of slowing down. A task
+// that is deferred simply keeps showing its previous pose.
+class AnimationTask
+{
+public:
+    virtual ~AnimationTask() = default;
+    virtual void Animate(float inDeltaTime) = 0;
+};
+
+struct AnimationSchedulerStats
+{
+    // Last frame
+    unsigned int run = 0;
+    unsigned int deferred = 0;
+    double elapsed = 0.0;
+    // Time spent past the budget, in seconds
+    double overrun = 0.0;
+
+    // Since ResetStats
+    unsigned int frames = 0;
+    unsigned int framesOverBudget = 0;
+    unsigned long long totalDeferred = 0;
+    unsigned int maxDeferredFrames = 0;
+    double maxOverrun = 0.0;
+};
+
+// Runs animation tasks within a per frame time budget. Tasks are ordered by
+// priority: on screen before off screen, then nearest first, with a task's
+// distance divided down for every frame it has waited so nothing starves. Once
+// the budget is spent the remaining tasks are deferred to the next frame.
+class AnimationScheduler
+{
+private:
+    AnimationScheduler(const AnimationScheduler&);
+    AnimationScheduler& operator=(const AnimationScheduler&);
+
+protected:
+    struct Entry
+    {
+        AnimationTask* mTask = 0;
+        float mDistance = 0.0f;
+        float mPendingTime = 0.0f;
+        float mPriority = 0.0f;
+        unsigned int mDeferredFrames = 0;
+        bool mOnScreen = true;
+    };
+
+    FrameClock* mClock;
+    std::vector<Entry> mEntries;
+    std::vector<unsigned int> mFree;
+    std::vector<unsigned int> mOrder;
+    double mBudget;
+    AnimationSchedulerStats mStats;
+
+public:
+    AnimationScheduler(FrameClock* inClock);
+
+    void SetBudget(float inMilliseconds);
+    float GetBudget() const;
+
+    unsigned int Add(AnimationTask* task);
+    void Remove(unsigned int handle);
+    void SetVisibility(unsigned int handle, bool onScreen, float distance);
+
+    // Call once per frame
+    void Run(float inDeltaTime);
+
+    const AnimationSchedulerStats& GetStats() const;
+    void ResetStats();
+};
@@ -0,0 +1,283 @@
+#include <cmath>
+#include <iostream>
+
+#include "BakedClip.h"
+
+// Floats per joint per frame: position, rotation, scale
+#define BAKEDCLIP_STRIDE 10
+
+BakedClip::BakedClip()
+{
+    mName = "No name given";
+    mJointCount = 0;
+    mFrameCount = 0;
+    mStartTime = 0.0f;
+    mDuration = 0.0f;
+    mFrameTime = 0.0f;
+    mInvFrameTime = 0.0f;
+    mLooping = true;
+    mAdditive = false;
+}
+
+void BakedClip::Bake(const Clip& clip, const Transform* restPose, unsigned int jointCount, float sampleRate)
+{
+    mName = clip.GetName();
+    mLooping = clip.GetLooping();
+    mJointCount = jointCount;
+    mStartTime = clip.GetStartTime();
+    mDuration = clip.GetDuration();
+    mAdditive = false;
+
+    // Round to a whole number of uniform intervals so the last frame lands on the end
+    unsigned int intervals = (unsigned int)(mDuration * sampleRate + 0.5f);
+    if (intervals < 1)
+    {
+        intervals = 1;
+    }
+    mFrameCount = intervals + 1;
+    mFrameTime = mDuration / (float)intervals;
+    mInvFrameTime = mFrameTime > 0.0f ? 1.0f / mFrameTime : 0.0f;
+
+    mData.resize((size_t)mFrameCount * mJointCount * BAKEDCLIP_STRIDE);
+
+    std::vector<Transform> joints(mJointCount);
+    for (unsigned int frame = 0; frame < mFrameCount; ++frame)
+    {
+        float time = mStartTime + mFrameTime * (float)frame;
+        if (frame == mFrameCount - 1)
+        {
+            time = mStartTime + mDuration;
+        }
+
+        for (unsigned int j = 0; j < mJointCount; ++j)
+        {
+            joints[j] = restPose[j];
+        }
+        // Sample without wrapping so the final frame is the true end pose
+        for (unsigned int i = 0, size = clip.Size(); i < size; ++i)
+        {
+            const TransformTrack* track = clip.GetTrack(clip.GetIdAtIndex(i));
+            unsigned int j = track->GetId();
+            if (j < mJointCount)
+            {
+                joints[j] = track->Sample(joints[j], time, false);
+            }
+        }
+
+        vec3* positions = GetPositions(frame);
+        quat* rotations = GetRotations(frame);
+        vec3* scales = GetScales(frame);
+        const quat* previous = frame > 0 ? GetRotations(frame - 1) : 0;
+        for (unsigned int j = 0; j < mJointCount; ++j)
+        {
+            positions[j] = joints[j].position;
+            rotations[j] = normalized(joints[j].rotation);
+            if (previous != 0 && dot(previous[j], rotations[j]) < 0.0f)
+            {
+                rotations[j] = -rotations[j];
+            }
+            scales[j] = joints[j].scale;
+        }
+    }
+}
+
+void BakedClip::Bake(const Clip& clip, const Pose& restPose, float sampleRate)
+{
+    Bake(clip, restPose.GetLocalTransforms(), restPose.Size(), sampleRate);
+}
+
+void BakedClip::MakeAdditive(const Transform* reference)
+{
+    if (mAdditive)
+    {
+        std::cout << "WARNING: " << mName << " is already additive\n";
+        return;
+    }
+
+    std::vector<quat> invRotations(mJointCount);
+    for (unsigned int j = 0; j < mJointCount; ++j)
+    {
+        invRotations[j] = inverse(reference[j].rotation);
+    }
+
+    for (unsigned int frame = 0; frame < mFrameCount; ++frame)
+    {
+        vec3* positions = GetPositions(frame);
+        quat* rotations = GetRotations(frame);
+        vec3* scales = GetScales(frame);
+        for (unsigned int j = 0; j < mJointCount; ++j)
+        {
+            positions[j] = positions[j] - reference[j].position;
+            // Multiplying every frame by the same quaternion keeps the
+            // frame to frame hemisphere alignment done in Bake
+            rotations[j] = normalized(invRotations[j] * rotations[j]);
+            scales[j] = scales[j] - reference[j].scale;
+        }
+    }
+    mAdditive = true;
+}
+
+void BakedClip::MakeAdditive(const Pose& reference)
+{
+    if (reference.Size() < mJointCount)
+    {
+        std::cout << "WARNING: Additive reference has " << reference.Size() << " joints, " << mName << " has " << mJointCount << "\n";
+        return;
+    }
+    MakeAdditive(reference.GetLocalTransforms());
+}
+
+bool BakedClip::IsAdditive() const
+{
+    return mAdditive;
+}
+
+float BakedClip::AdjustTimeToFitRange(float time) const
+{
+    if (mLooping)
+    {
+        if (mDuration <= 0.0f)
+        {
+            return mStartTime;
+        }
+        time = fmodf(time - mStartTime, mDuration);
+        if (time < 0.0f)
+        {
+            time += mDuration;
+        }
+        return time + mStartTime;
+    }
+
+    if (time < mStartTime)
+    {
+        time = mStartTime;
+    }
+    if (time > mStartTime + mDuration)
+    {
+        time = mStartTime + mDuration;
+    }
+    return time;
+}
+
+float BakedClip::Sample(Transform* outJoints, float time) const
+{
+    if (mFrameCount == 0 || mJointCount == 0)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+
+    float frameTime = (time - mStartTime) * mInvFrameTime;
+    unsigned int frame = (unsigned int)frameTime;
+    if (frame > mFrameCount - 2)
+    {
+        frame = mFrameCount - 2;
+    }
+    float t = frameTime - (float)frame;
+
+    const vec3* p0 = GetPositions(frame);
+    const vec3* p1 = GetPositions(frame + 1);
+    const quat* r0 = GetRotations(frame);
+    const quat* r1 = GetRotations(frame + 1);
+    const vec3* s0 = GetScales(frame);
+    const vec3* s1 = GetScales(frame + 1);
+
+    for (unsigned int j = 0; j < mJointCount; ++j)
+    {
+        Transform& out = outJoints[j];
+        out.position = lerp(p0[j], p1[j], t);
+        out.rotation = nlerp(r0[j], r1[j], t);
+        out.scale = lerp(s0[j], s1[j], t);
+    }
+    return time;
+}
+
+float BakedClip::Sample(Pose& outPose, float time) const
+{
+    return Sample(outPose.GetLocalTransforms(), time);
+}
+
+const vec3* BakedClip::GetPositions(unsigned int frame) const
+{
+    return (const vec3*)&mData[(size_t)frame * mJointCount * BAKEDCLIP_STRIDE];
+}
+
+const quat* BakedClip::GetRotations(unsigned int frame) const
+{
+    return (const quat*)&mData[(size_t)frame * mJointCount * BAKEDCLIP_STRIDE + mJointCount * 3];
+}
+
+const vec3* BakedClip::GetScales(unsigned int frame) const
+{
+    return (const vec3*)&mData[(size_t)frame * mJointCount * BAKEDCLIP_STRIDE + mJointCount * 7];
+}
+
+vec3* BakedClip::GetPositions(unsigned int frame)
+{
+    return (vec3*)&mData[(size_t)frame * mJointCount * BAKEDCLIP_STRIDE];
+}
+
+quat* BakedClip::GetRotations(unsigned int frame)
+{
+    return (quat*)&mData[(size_t)frame * mJointCount * BAKEDCLIP_STRIDE + mJointCount * 3];
+}
+
+vec3* BakedClip::GetScales(unsigned int frame)
+{
+    return (vec3*)&mData[(size_t)frame * mJointCount * BAKEDCLIP_STRIDE + mJointCount * 7];
+}
+
+unsigned int BakedClip::GetJointCount() const
+{
+    return mJointCount;
+}
+
+unsigned int BakedClip::GetFrameCount() const
+{
+    return mFrameCount;
+}
+
+float BakedClip::GetFrameTime() const
+{
+    return mFrameTime;
+}
+
+float BakedClip::GetStartTime() const
+{
+    return mStartTime;
+}
+
+float BakedClip::GetEndTime() const
+{
+    return mStartTime + mDuration;
+}
+
+float BakedClip::GetDuration() const
+{
+    return mDuration;
+}
+
+bool BakedClip::GetLooping() const
+{
+    return mLooping;
+}
+
+void BakedClip::SetLooping(bool inLooping)
+{
+    mLooping = inLooping;
+}
+
+const std::string& BakedClip::GetName() const
+{
+    return mName;
+}
+
+void BakedClip::SetName(const std::string& inNewName)
+{
+    mName = inNewName;
+}
+
+unsigned int BakedClip::GetMemoryBytes() const
+{
+    return (unsigned int)(sizeof(BakedClip) + mName.capacity() + mData.capacity() * sizeof(float));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Clip.h"
+
+#define BAKEDCLIP_DEFAULT_RATE 30.0f
+
+// A clip resampled offline at a fixed rate. Every frame stores all joints,
+// structure of arrays: positions (3 floats per joint), then rotations (4),
+// then scales (3). Sampling is a direct frame index plus one lerp per channel,
+// with no key search. Rotations are stored in the same hemisphere as the
+// previous frame, so no neighborhood check is needed at runtime.
+class BakedClip
+{
+protected:
+    std::vector<float> mData;
+    std::string mName;
+    unsigned int mJointCount;
+    unsigned int mFrameCount;
+    float mStartTime;
+    float mDuration;
+    float mFrameTime;
+    float mInvFrameTime;
+    bool mLooping;
+    bool mAdditive;
+
+public:
+    BakedClip();
+
+    // restPose holds jointCount transforms, used for joints the clip doesn't animate
+    void Bake(const Clip& clip, const Transform* restPose, unsigned int jointCount, float sampleRate = BAKEDCLIP_DEFAULT_RATE);
+
+    void Bake(const Clip& clip, const Pose& restPose, float sampleRate = BAKEDCLIP_DEFAULT_RATE);
+
+    // Converts every frame, once at load time, to its difference from reference
+    // (jointCount transforms, usually the clip's first frame or the rest pose).
+    // Sample then yields deltas to be layered with Add (see Blending.h), so no
+    // reference pose is sampled or subtracted at runtime.
+    void MakeAdditive(const Transform* reference);
+    void MakeAdditive(const Pose& reference);
+    bool IsAdditive() const;
+
+    // Writes all jointCount joints. Returns the time fit to the clip.
+    float Sample(Transform* outJoints, float time) const;
+    float Sample(Pose& outPose, float time) const;
+    float AdjustTimeToFitRange(float time) const;
+
+    // Direct access to the baked data of one frame
+    const vec3* GetPositions(unsigned int frame) const;
+    const quat* GetRotations(unsigned int frame) const;
+    const vec3* GetScales(unsigned int frame) const;
+    vec3* GetPositions(unsigned int frame);
+    quat* GetRotations(unsigned int frame);
+    vec3* GetScales(unsigned int frame);
+
+    unsigned int GetJointCount() const;
+    unsigned int GetFrameCount() const;
+    float GetFrameTime() const;
+    float GetStartTime() const;
+    float GetEndTime() const;
+    float GetDuration() const;
+    bool GetLooping() const;
+    void SetLooping(bool inLooping);
+    const std::string& GetName() const;
+    void SetName(const std::string& inNewName);
+    unsigned int GetMemoryBytes() const;
+};
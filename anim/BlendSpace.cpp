@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "BlendSpace.h"
+#include "Blending.h"
+
+// Points closer than this (in the unit square) count as the same sample
+#define BLENDSPACE_EPSILON 0.000001f
+
+namespace
+{
+    float Cross(const float* a, const float* b, const float* c)
+    {
+        return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+    }
+
+    // p strictly inside the circle through a, b, c (counter clockwise)
+    bool InCircumcircle(const float* a, const float* b, const float* c, const float* p)
+    {
+        double ax = a[0] - p[0], ay = a[1] - p[1];
+        double bx = b[0] - p[0], by = b[1] - p[1];
+        double cx = c[0] - p[0], cy = c[1] - p[1];
+        double det = (ax * ax + ay * ay) * (bx * cy - cx * by) -
+            (bx * bx + by * by) * (ax * cy - cx * ay) +
+            (cx * cx + cy * cy) * (ax * by - bx * ay);
+        return det > 0.0;
+    }
+
+    // Barycentric weights of the point of triangle abc closest to p. Returns the
+    // squared distance from p to that point, 0 when p is inside.
+    float ClosestBarycentric(const float* p, const float* a, const float* b, const float* c, float* outWeights)
+    {
+        float area = Cross(a, b, c);
+        float wa = Cross(p, b, c) / area;
+        float wb = Cross(a, p, c) / area;
+        float wc = 1.0f - wa - wb;
+        if (wa >= 0.0f && wb >= 0.0f && wc >= 0.0f)
+        {
+            outWeights[0] = wa;
+            outWeights[1] = wb;
+            outWeights[2] = wc;
+            return 0.0f;
+        }
+
+        const float* corners[3] = { a, b, c };
+        float best = 3.402823466e+38f;
+        for (unsigned int edge = 0; edge < 3; ++edge)
+        {
+            const float* from = corners[edge];
+            const float* to = corners[(edge + 1) % 3];
+            float dx = to[0] - from[0], dy = to[1] - from[1];
+            float lenSq = dx * dx + dy * dy;
+            float t = lenSq > 0.0f ? ((p[0] - from[0]) * dx + (p[1] - from[1]) * dy) / lenSq : 0.0f;
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+            float ex = from[0] + dx * t - p[0], ey = from[1] + dy * t - p[1];
+            float distSq = ex * ex + ey * ey;
+            if (distSq < best)
+            {
+                best = distSq;
+                outWeights[edge] = 1.0f - t;
+                outWeights[(edge + 1) % 3] = t;
+                outWeights[(edge + 2) % 3] = 0.0f;
+            }
+        }
+        return best;
+    }
+}
+
+BlendSpace2D::BlendSpace2D()
+{
+    mGridSize = 0;
+    mMin[0] = mMin[1] = 0.0f;
+    mMax[0] = mMax[1] = 0.0f;
+    mScale[0] = mScale[1] = 1.0f;
+}
+
+unsigned int BlendSpace2D::AddSample(float x, float y, const BakedClip* clip)
+{
+    SamplePoint sample;
+    sample.mX = x;
+    sample.mY = y;
+    sample.mBaked = clip;
+    sample.mCompressed = 0;
+    mSamples.push_back(sample);
+    return (unsigned int)mSamples.size() - 1;
+}
+
+unsigned int BlendSpace2D::AddSample(float x, float y, const CompressedClip* clip)
+{
+    SamplePoint sample;
+    sample.mX = x;
+    sample.mY = y;
+    sample.mBaked = 0;
+    sample.mCompressed = clip;
+    mSamples.push_back(sample);
+    return (unsigned int)mSamples.size() - 1;
+}
+
+// Bowyer-Watson: insert the points one at a time into a triangle enclosing them
+// all, replacing the triangles whose circumcircle holds the new point
+void BlendSpace2D::Triangulate()
+{
+    unsigned int count = (unsigned int)mSamples.size();
+    const std::vector<float>& points = mPoints;
+    std::vector<float> vertices = points;
+    vertices.push_back(-100.0f); vertices.push_back(-100.0f);
+    vertices.push_back(300.0f); vertices.push_back(-100.0f);
+    vertices.push_back(-100.0f); vertices.push_back(300.0f);
+
+    std::vector<unsigned int> triangles;
+    triangles.push_back(count);
+    triangles.push_back(count + 1);
+    triangles.push_back(count + 2);
+
+    std::vector<unsigned int> edges;
+    std::vector<unsigned int> kept;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const float* p = &vertices[i * 2];
+        edges.clear();
+        kept.clear();
+        for (unsigned int t = 0, size = (unsigned int)triangles.size(); t < size; t += 3)
+        {
+            const unsigned int* tri = &triangles[t];
+            if (!InCircumcircle(&vertices[tri[0] * 2], &vertices[tri[1] * 2], &vertices[tri[2] * 2], p))
+            {
+                kept.insert(kept.end(), tri, tri + 3);
+                continue;
+            }
+            for (unsigned int e = 0; e < 3; ++e)
+            {
+                edges.push_back(tri[e]);
+                edges.push_back(tri[(e + 1) % 3]);
+            }
+        }
+
+        // Edges shared by two removed triangles are interior to the hole
+        triangles.swap(kept);
+        for (unsigned int e = 0, size = (unsigned int)edges.size(); e < size; e += 2)
+        {
+            bool shared = false;
+            for (unsigned int o = 0; o < size && !shared; o += 2)
+            {
+                shared = o != e && edges[o] == edges[e + 1] && edges[o + 1] == edges[e];
+            }
+            if (!shared)
+            {
+                triangles.push_back(edges[e]);
+                triangles.push_back(edges[e + 1]);
+                triangles.push_back(i);
+            }
+        }
+    }
+
+    mTriangles.clear();
+    for (unsigned int t = 0, size = (unsigned int)triangles.size(); t < size; t += 3)
+    {
+        const unsigned int* tri = &triangles[t];
+        if (tri[0] >= count || tri[1] >= count || tri[2] >= count)
+        {
+            continue;
+        }
+        if (fabsf(Cross(&points[tri[0] * 2], &points[tri[1] * 2], &points[tri[2] * 2])) <= BLENDSPACE_EPSILON)
+        {
+            continue;
+        }
+        mTriangles.insert(mTriangles.end(), tri, tri + 3);
+    }
+}
+
+void BlendSpace2D::BakeGrid()
+{
+    const std::vector<float>& points = mPoints;
+    unsigned int triangleCount = (unsigned int)mTriangles.size() / 3;
+    float cellSize = 1.0f / (float)mGridSize;
+    float diagonal = cellSize * sqrtf(2.0f);
+
+    mCellStarts.assign(mGridSize * mGridSize + 1, 0);
+    mCellTriangles.clear();
+    std::vector<float> distances(triangleCount);
+    float weights[3];
+
+    for (unsigned int y = 0; y < mGridSize; ++y)
+    {
+        for (unsigned int x = 0; x < mGridSize; ++x)
+        {
+            float cellMin[2] = { x * cellSize, y * cellSize };
+            float center[2] = { cellMin[0] + cellSize * 0.5f, cellMin[1] + cellSize * 0.5f };
+            float nearest = 3.402823466e+38f;
+            for (unsigned int t = 0; t < triangleCount; ++t)
+            {
+                const unsigned int* tri = &mTriangles[t * 3];
+                distances[t] = sqrtf(ClosestBarycentric(center, &points[tri[0] * 2], &points[tri[1] * 2], &points[tri[2] * 2], weights));
+                nearest = std::min(nearest, distances[t]);
+            }
+
+            // A triangle overlapping the cell may contain any of its points. One
+            // that doesn't can still be the closest to a point outside the
+            // triangulation, but only if it is within a cell diagonal of the
+            // closest triangle to the cell's center.
+            for (unsigned int t = 0; t < triangleCount; ++t)
+            {
+                const unsigned int* tri = &mTriangles[t * 3];
+                float lo[2] = { points[tri[0] * 2], points[tri[0] * 2 + 1] };
+                float hi[2] = { lo[0], lo[1] };
+                for (unsigned int v = 1; v < 3; ++v)
+                {
+                    for (unsigned int axis = 0; axis < 2; ++axis)
+                    {
+                        lo[axis] = std::min(lo[axis], points[tri[v] * 2 + axis]);
+                        hi[axis] = std::max(hi[axis], points[tri[v] * 2 + axis]);
+                    }
+                }
+                bool overlaps = lo[0] <= cellMin[0] + cellSize && hi[0] >= cellMin[0] &&
+                    lo[1] <= cellMin[1] + cellSize && hi[1] >= cellMin[1];
+                if (overlaps || distances[t] <= nearest + diagonal)
+                {
+                    mCellTriangles.push_back(t);
+                }
+            }
+            mCellStarts[y * mGridSize + x + 1] = (unsigned int)mCellTriangles.size();
+        }
+    }
+}
+
+bool BlendSpace2D::Build(unsigned int gridSize)
+{
+    mTriangles.clear();
+    mCellStarts.clear();
+    mCellTriangles.clear();
+    mGridSize = gridSize > 0 ? gridSize : 1;
+
+    unsigned int count = (unsigned int)mSamples.size();
+    if (count < 3)
+    {
+        std::cout << "WARNING: Blend space needs at least three samples, has " << count << "\n";
+        return false;
+    }
+
+    mMin[0] = mMax[0] = mSamples[0].mX;
+    mMin[1] = mMax[1] = mSamples[0].mY;
+    for (unsigned int i = 1; i < count; ++i)
+    {
+        mMin[0] = std::min(mMin[0], mSamples[i].mX);
+        mMin[1] = std::min(mMin[1], mSamples[i].mY);
+        mMax[0] = std::max(mMax[0], mSamples[i].mX);
+        mMax[1] = std::max(mMax[1], mSamples[i].mY);
+    }
+    for (unsigned int axis = 0; axis < 2; ++axis)
+    {
+        float extent = mMax[axis] - mMin[axis];
+        mScale[axis] = extent > 0.0f ? 1.0f / extent : 1.0f;
+    }
+
+    std::vector<float>& points = mPoints;
+    points.resize(count * 2);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        points[i * 2] = (mSamples[i].mX - mMin[0]) * mScale[0];
+        points[i * 2 + 1] = (mSamples[i].mY - mMin[1]) * mScale[1];
+        for (unsigned int j = 0; j < i; ++j)
+        {
+            float dx = points[i * 2] - points[j * 2], dy = points[i * 2 + 1] - points[j * 2 + 1];
+            if (dx * dx + dy * dy <= BLENDSPACE_EPSILON)
+            {
+                std::cout << "WARNING: Blend space samples " << j << " and " << i << " are at the same point\n";
+                return false;
+            }
+        }
+    }
+
+    Triangulate();
+    if (mTriangles.empty())
+    {
+        std::cout << "WARNING: Blend space samples are all on one line\n";
+        return false;
+    }
+    BakeGrid();
+    return true;
+}
+
+BlendSpaceWeights BlendSpace2D::GetWeights(float x, float y) const
+{
+    BlendSpaceWeights result;
+    if (mTriangles.empty())
+    {
+        result.mWeights[0] = mSamples.empty() ? 0.0f : 1.0f;
+        return result;
+    }
+
+    float p[2] = { (x - mMin[0]) * mScale[0], (y - mMin[1]) * mScale[1] };
+    p[0] = p[0] < 0.0f ? 0.0f : (p[0] > 1.0f ? 1.0f : p[0]);
+    p[1] = p[1] < 0.0f ? 0.0f : (p[1] > 1.0f ? 1.0f : p[1]);
+    unsigned int cellX = std::min((unsigned int)(p[0] * mGridSize), mGridSize - 1);
+    unsigned int cellY = std::min((unsigned int)(p[1] * mGridSize), mGridSize - 1);
+    unsigned int cell = cellY * mGridSize + cellX;
+
+    float best = 3.402823466e+38f;
+    float weights[3];
+    for (unsigned int i = mCellStarts[cell], end = mCellStarts[cell + 1]; i < end; ++i)
+    {
+        const unsigned int* tri = &mTriangles[mCellTriangles[i] * 3];
+        float distSq = ClosestBarycentric(p, &mPoints[tri[0] * 2], &mPoints[tri[1] * 2], &mPoints[tri[2] * 2], weights);
+        if (distSq < best)
+        {
+            best = distSq;
+            for (unsigned int v = 0; v < 3; ++v)
+            {
+                result.mSamples[v] = tri[v];
+                result.mWeights[v] = weights[v];
+            }
+            if (distSq <= 0.0f)
+            {
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+float BlendSpace2D::GetDuration(const BlendSpaceWeights& weights) const
+{
+    float duration = 0.0f;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        if (weights.mWeights[i] <= 0.0f)
+        {
+            continue;
+        }
+        const SamplePoint& sample = mSamples[weights.mSamples[i]];
+        duration += weights.mWeights[i] * (sample.mBaked != 0 ? sample.mBaked->GetDuration() : sample.mCompressed->GetDuration());
+    }
+    return duration;
+}
+
+void BlendSpace2D::Sample(Pose* poses, const BlendSpaceWeights& weights, float phase) const
+{
+    // Blending in sequence, each with its share of the total so far, gives every
+    // sample its own weight without a third pose
+    float total = 0.0f;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        float weight = weights.mWeights[i];
+        if (weight <= 0.0f)
+        {
+            continue;
+        }
+        const SamplePoint& sample = mSamples[weights.mSamples[i]];
+        Pose& target = total > 0.0f ? poses[1] : poses[0];
+        if (sample.mBaked != 0)
+        {
+            sample.mBaked->Sample(target, sample.mBaked->GetStartTime() + phase * sample.mBaked->GetDuration());
+        }
+        else
+        {
+            sample.mCompressed->Sample(target, sample.mCompressed->GetStartTime() + phase * sample.mCompressed->GetDuration());
+        }
+        total += weight;
+        if (&target != &poses[0])
+        {
+            Blend(poses[0], poses[0], poses[1], weight / total);
+        }
+    }
+}
+
+float BlendSpace2D::AdvancePhase(const BlendSpaceWeights& weights, float phase, float deltaTime) const
+{
+    float duration = GetDuration(weights);
+    if (duration <= 0.0f)
+    {
+        return phase;
+    }
+    phase += deltaTime / duration;
+    return phase - floorf(phase);
+}
+
+unsigned int BlendSpace2D::GetSampleCount() const
+{
+    return (unsigned int)mSamples.size();
+}
+
+unsigned int BlendSpace2D::GetTriangleCount() const
+{
+    return (unsigned int)mTriangles.size() / 3;
+}
+
+unsigned int BlendSpace2D::GetMemoryBytes() const
+{
+    return (unsigned int)(sizeof(SamplePoint) * mSamples.size() +
+        sizeof(float) * mPoints.size() +
+        sizeof(unsigned int) * (mTriangles.size() + mCellStarts.size() + mCellTriangles.size()));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include "BakedClip.h"
+#include "CompressedClip.h"
+#include "Pose.h"
+
+// Cells per axis of the lookup grid baked by Build
+#define BLENDSPACE_DEFAULT_GRID 32
+
+// Up to three samples and their weights (summing to one) for a point in the space.
+// Unused entries have a weight of 0.
+struct BlendSpaceWeights
+{
+    unsigned int mSamples[3] = { 0, 0, 0 };
+    float mWeights[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// Clips placed on a 2D plane (e.g. speed by direction), blended by the triangle
+// around a point. Build triangulates the samples (Delaunay) and bakes a uniform
+// grid over their bounds that lists the triangles overlapping each cell, so
+// finding the triangle and its barycentric weights at runtime is one cell lookup
+// and a couple of point-in-triangle tests, independent of the sample count.
+// Points outside the triangulation snap to its closest edge.
+//
+// Clips are played phase synchronised: all samples share one normalized phase,
+// advanced at the rate of the weighted duration, so feet land together whatever
+// the clips' lengths.
+class BlendSpace2D
+{
+protected:
+    struct SamplePoint
+    {
+        float mX;
+        float mY;
+        const BakedClip* mBaked;
+        const CompressedClip* mCompressed;
+    };
+
+    std::vector<SamplePoint> mSamples;
+    // Sample coordinates scaled to the unit square, x and y per sample
+    std::vector<float> mPoints;
+    // Three sample indices per triangle, counter clockwise
+    std::vector<unsigned int> mTriangles;
+    // Per cell, a range into mCellTriangles
+    std::vector<unsigned int> mCellStarts;
+    std::vector<unsigned int> mCellTriangles;
+    unsigned int mGridSize;
+    float mMin[2];
+    float mMax[2];
+    // Scaling to the unit square makes axes with different units weigh the same
+    float mScale[2];
+
+    void Triangulate();
+    void BakeGrid();
+
+public:
+    BlendSpace2D();
+
+    // Returns the sample index. Clips should loop and share a phase layout
+    // (e.g. left foot down at the start).
+    unsigned int AddSample(float x, float y, const BakedClip* clip);
+    unsigned int AddSample(float x, float y, const CompressedClip* clip);
+
+    // Once, at load time, after all samples are added. Needs three samples not
+    // all on one line.
+    bool Build(unsigned int gridSize = BLENDSPACE_DEFAULT_GRID);
+
+    BlendSpaceWeights GetWeights(float x, float y) const;
+    // Weighted duration of the blend, the time one phase takes
+    float GetDuration(const BlendSpaceWeights& weights) const;
+    // Samples the weighted clips at phase (0 to 1) and blends them into poses[0].
+    // poses[1] is used as scratch; both match the clips' rig.
+    void Sample(Pose* poses, const BlendSpaceWeights& weights, float phase) const;
+    // Advances phase by deltaTime at the weighted duration and wraps it to [0, 1)
+    float AdvancePhase(const BlendSpaceWeights& weights, float phase, float deltaTime) const;
+
+    unsigned int GetSampleCount() const;
+    unsigned int GetTriangleCount() const;
+    unsigned int GetMemoryBytes() const;
+};
@@ -0,0 +1,330 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "Blending.h"
+#include "../math/simd.h"
+
+// The span kernel treats a joint as ten packed floats:
+// position xyz, rotation xyzw, scale xyz
+static_assert(sizeof(Transform) == 10 * sizeof(float), "Transform must be ten packed floats");
+
+namespace
+{
+#if MATH_SSE
+    inline void BlendTransform(float* out, const float* a, const float* b, float t)
+    {
+        // Rotation occupies lane 3 of the first register and lanes 0-2 of the second
+        const __m128 rotMask0 = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+        const __m128 rotMask1 = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+
+        __m128 a0 = _mm_loadu_ps(a);
+        __m128 a1 = _mm_loadu_ps(a + 4);
+        __m128 a2 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(a + 8));
+        __m128 b0 = _mm_loadu_ps(b);
+        __m128 b1 = _mm_loadu_ps(b + 4);
+        __m128 b2 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(b + 8));
+
+        // Neighborhood: negate b's rotation lanes when the quaternions are more than 90 degrees apart
+        float d = a[3] * b[3] + a[4] * b[4] + a[5] * b[5] + a[6] * b[6];
+        __m128 sign = _mm_and_ps(_mm_set1_ps(d), signBit);
+        b0 = _mm_xor_ps(b0, _mm_and_ps(sign, rotMask0));
+        b1 = _mm_xor_ps(b1, _mm_and_ps(sign, rotMask1));
+
+        __m128 vt = _mm_set1_ps(t);
+        __m128 r0 = _mm_add_ps(a0, _mm_mul_ps(_mm_sub_ps(b0, a0), vt));
+        __m128 r1 = _mm_add_ps(a1, _mm_mul_ps(_mm_sub_ps(b1, a1), vt));
+        __m128 r2 = _mm_add_ps(a2, _mm_mul_ps(_mm_sub_ps(b2, a2), vt));
+
+        float lanes[8];
+        _mm_storeu_ps(lanes, r0);
+        _mm_storeu_ps(lanes + 4, r1);
+        float lenSq = lanes[3] * lanes[3] + lanes[4] * lanes[4] + lanes[5] * lanes[5] + lanes[6] * lanes[6];
+        float invLen = lenSq > 0.000001f ? 1.0f / sqrtf(lenSq) : 1.0f;
+        __m128 scale = _mm_set1_ps(invLen);
+        __m128 one = _mm_set1_ps(1.0f);
+        r0 = _mm_mul_ps(r0, _mm_or_ps(_mm_and_ps(rotMask0, scale), _mm_andnot_ps(rotMask0, one)));
+        r1 = _mm_mul_ps(r1, _mm_or_ps(_mm_and_ps(rotMask1, scale), _mm_andnot_ps(rotMask1, one)));
+
+        _mm_storeu_ps(out, r0);
+        _mm_storeu_ps(out + 4, r1);
+        _mm_storel_pi((__m64*)(out + 8), r2);
+    }
+
+    // Rotation applied as in * delta (delta after in, see quat operator*):
+    // the Hamilton product delta * in, with the delta already weighted
+    inline void AddTransform(float* out, const float* in, const float* delta, float w)
+    {
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 signYW = _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0, 0x80000000, 0));
+        const __m128 signZW = _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0x80000000, 0, 0));
+        const __m128 signXW = _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0, 0, 0x80000000));
+        const __m128 identity = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+        __m128 vw = _mm_set1_ps(w);
+        __m128 position = _mm_add_ps(_mm_loadu_ps(in), _mm_mul_ps(_mm_loadu_ps(delta), vw));
+        __m128 scale = _mm_add_ps(_mm_loadu_ps(in + 6), _mm_mul_ps(_mm_loadu_ps(delta + 6), vw));
+        __m128 b = _mm_loadu_ps(in + 3);
+
+        // nlerp from identity, taking the short way round when the delta's w is negative
+        __m128 d = _mm_loadu_ps(delta + 3);
+        __m128 sign = _mm_and_ps(_mm_set1_ps(delta[6]), signBit);
+        d = _mm_xor_ps(d, sign);
+        d = _mm_add_ps(identity, _mm_mul_ps(_mm_sub_ps(d, identity), vw));
+        float lanes[4];
+        _mm_storeu_ps(lanes, d);
+        float lenSq = lanes[0] * lanes[0] + lanes[1] * lanes[1] + lanes[2] * lanes[2] + lanes[3] * lanes[3];
+        d = _mm_mul_ps(d, _mm_set1_ps(lenSq > 0.000001f ? 1.0f / sqrtf(lenSq) : 1.0f));
+
+        __m128 dx = _mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 dy = _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 dz = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 dw = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 rotation = _mm_mul_ps(dw, b);
+        rotation = _mm_add_ps(rotation, _mm_mul_ps(dx, _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)), signYW)));
+        rotation = _mm_add_ps(rotation, _mm_mul_ps(dy, _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), signZW)));
+        rotation = _mm_add_ps(rotation, _mm_mul_ps(dz, _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), signXW)));
+
+        // The position and scale registers spill into the rotation lanes, so the rotation is stored last
+        _mm_storeu_ps(out, position);
+        _mm_storeu_ps(out + 6, scale);
+        _mm_storeu_ps(out + 3, rotation);
+    }
+#else
+    inline void BlendTransform(float* out, const float* a, const float* b, float t)
+    {
+        float d = a[3] * b[3] + a[4] * b[4] + a[5] * b[5] + a[6] * b[6];
+        float rotSign = d < 0.0f ? -1.0f : 1.0f;
+        float result[10];
+        for (unsigned int i = 0; i < 10; ++i)
+        {
+            float target = (i >= 3 && i < 7) ? b[i] * rotSign : b[i];
+            result[i] = a[i] + (target - a[i]) * t;
+        }
+        float lenSq = result[3] * result[3] + result[4] * result[4] + result[5] * result[5] + result[6] * result[6];
+        float invLen = lenSq > 0.000001f ? 1.0f / sqrtf(lenSq) : 1.0f;
+        for (unsigned int i = 3; i < 7; ++i)
+        {
+            result[i] *= invLen;
+        }
+        memcpy(out, result, sizeof(result));
+    }
+
+    inline void AddTransform(float* out, const float* in, const float* delta, float w)
+    {
+        const Transform& input = *(const Transform*)in;
+        const Transform& d = *(const Transform*)delta;
+        Transform result;
+        result.position = input.position + d.position * w;
+        result.scale = input.scale + d.scale * w;
+        quat rotation = d.rotation.w < 0.0f ? -d.rotation : d.rotation;
+        rotation = nlerp(quat(), rotation, w);
+        result.rotation = input.rotation * rotation;
+        memcpy(out, &result, sizeof(Transform));
+    }
+#endif
+}
+
+bool IsInHierarchy(const Pose& pose, unsigned int root, unsigned int search)
+{
+    if (search == root)
+    {
+        return true;
+    }
+    int p = pose.GetParent(search);
+    while (p >= 0)
+    {
+        if (p == (int)root)
+        {
+            return true;
+        }
+        p = pose.GetParent(p);
+    }
+    return false;
+}
+
+void MakeBoneMask(const Pose& pose, unsigned int root, std::vector<float>& outMask, float weight)
+{
+    unsigned int size = pose.Size();
+    outMask.assign(size, 0.0f);
+    if (root >= size)
+    {
+        return;
+    }
+    if (!pose.IsTopologicallySorted())
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            outMask[i] = IsInHierarchy(pose, root, i) ? weight : 0.0f;
+        }
+        return;
+    }
+
+    // Parents precede children, so one forward pass marks the whole subtree
+    const int* parents = pose.GetParents();
+    outMask[root] = weight;
+    for (unsigned int i = root + 1; i < size; ++i)
+    {
+        if (parents[i] >= (int)root && outMask[parents[i]] != 0.0f)
+        {
+            outMask[i] = weight;
+        }
+    }
+}
+
+void BlendTransforms(Transform* out, const Transform* a, const Transform* b, float t, const float* weights, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float w = weights != 0 ? t * weights[i] : t;
+        if (w <= 0.0f)
+        {
+            if (out != a)
+            {
+                out[i] = a[i];
+            }
+        }
+        else if (w >= 1.0f)
+        {
+            if (out != b)
+            {
+                out[i] = b[i];
+            }
+        }
+        else
+        {
+            BlendTransform((float*)&out[i], (const float*)&a[i], (const float*)&b[i], w);
+        }
+    }
+}
+
+static bool PrepareBlend(Pose& output, const Pose& a, const Pose& b)
+{
+    if (a.Size() != b.Size())
+    {
+        std::cout << "WARNING: Blending poses with " << a.Size() << " and " << b.Size() << " joints\n";
+        return false;
+    }
+    if (output.Size() != a.Size())
+    {
+        output = a;
+    }
+    return true;
+}
+
+void Blend(Pose& output, const Pose& a, const Pose& b, float t)
+{
+    if (!PrepareBlend(output, a, b))
+    {
+        return;
+    }
+    // Whole-input skips: no per-joint work at all
+    if (t <= 0.0f)
+    {
+        if (&output != &a)
+        {
+            memcpy(output.GetLocalTransforms(), a.GetLocalTransforms(), sizeof(Transform) * a.Size());
+        }
+        return;
+    }
+    if (t >= 1.0f)
+    {
+        if (&output != &b)
+        {
+            memcpy(output.GetLocalTransforms(), b.GetLocalTransforms(), sizeof(Transform) * b.Size());
+        }
+        return;
+    }
+    if (a.Size() > 0)
+    {
+        BlendTransforms(output.GetLocalTransforms(), a.GetLocalTransforms(), b.GetLocalTransforms(), t, 0, a.Size());
+    }
+}
+
+void Blend(Pose& output, const Pose& a, const Pose& b, float t, const std::vector<float>& mask)
+{
+    if (mask.size() < a.Size())
+    {
+        std::cout << "WARNING: Bone mask has " << mask.size() << " weights for " << a.Size() << " joints\n";
+        return;
+    }
+    if (!PrepareBlend(output, a, b))
+    {
+        return;
+    }
+    if (t <= 0.0f)
+    {
+        if (&output != &a)
+        {
+            memcpy(output.GetLocalTransforms(), a.GetLocalTransforms(), sizeof(Transform) * a.Size());
+        }
+        return;
+    }
+    if (a.Size() > 0)
+    {
+        BlendTransforms(output.GetLocalTransforms(), a.GetLocalTransforms(), b.GetLocalTransforms(), t, &mask[0], a.Size());
+    }
+}
+
+void AddTransforms(Transform* out, const Transform* in, const Transform* delta, float weight, const float* weights, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float w = weights != 0 ? weight * weights[i] : weight;
+        if (w <= 0.0f)
+        {
+            if (out != in)
+            {
+                out[i] = in[i];
+            }
+            continue;
+        }
+        AddTransform((float*)&out[i], (const float*)&in[i], (const float*)&delta[i], w > 1.0f ? 1.0f : w);
+    }
+}
+
+void Add(Pose& output, const Pose& in, const Pose& delta, float weight)
+{
+    if (!PrepareBlend(output, in, delta))
+    {
+        return;
+    }
+    if (weight <= 0.0f)
+    {
+        if (&output != &in)
+        {
+            memcpy(output.GetLocalTransforms(), in.GetLocalTransforms(), sizeof(Transform) * in.Size());
+        }
+        return;
+    }
+    if (in.Size() > 0)
+    {
+        AddTransforms(output.GetLocalTransforms(), in.GetLocalTransforms(), delta.GetLocalTransforms(), weight, 0, in.Size());
+    }
+}
+
+void Add(Pose& output, const Pose& in, const Pose& delta, float weight, const std::vector<float>& mask)
+{
+    if (mask.size() < in.Size())
+    {
+        std::cout << "WARNING: Bone mask has " << mask.size() << " weights for " << in.Size() << " joints\n";
+        return;
+    }
+    if (!PrepareBlend(output, in, delta))
+    {
+        return;
+    }
+    if (weight <= 0.0f)
+    {
+        if (&output != &in)
+        {
+            memcpy(output.GetLocalTransforms(), in.GetLocalTransforms(), sizeof(Transform) * in.Size());
+        }
+        return;
+    }
+    if (in.Size() > 0)
+    {
+        AddTransforms(output.GetLocalTransforms(), in.GetLocalTransforms(), delta.GetLocalTransforms(), weight, &mask[0], in.Size());
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include "Pose.h"
+
+// True if search is root or one of its descendants
+bool IsInHierarchy(const Pose& pose, unsigned int root, unsigned int search);
+
+// Per joint weights: 1 for root and everything below it, 0 elsewhere. Computed
+// once (e.g. an upper body mask) and passed to Blend every frame.
+void MakeBoneMask(const Pose& pose, unsigned int root, std::vector<float>& outMask, float weight = 1.0f);
+
+// Blends a contiguous span of transforms in one pass: positions and scales are
+// lerped, rotations are nlerped with the neighborhood check. weights scales t per
+// joint and may be null. Joints with an effective weight of 0 copy a (or are left
+// untouched when out aliases a), joints with a weight of 1 copy b. out may alias a or b.
+void BlendTransforms(Transform* out, const Transform* a, const Transform* b, float t, const float* weights, unsigned int count);
+
+// output = mix(a, b, t). t == 0 and t == 1 skip the blend entirely. output takes
+// a's parents if its size does not match.
+void Blend(Pose& output, const Pose& a, const Pose& b, float t);
+// mask holds one weight per joint, see MakeBoneMask
+void Blend(Pose& output, const Pose& a, const Pose& b, float t, const std::vector<float>& mask);
+
+// Layers deltas (from an additive BakedClip, see BakedClip::MakeAdditive) on top
+// of in: positions and scales add delta * weight, rotations are multiplied by the
+// delta rotation nlerped from identity by weight. weights scales weight per joint
+// and may be null; joints with an effective weight of 0 are skipped. out may alias in.
+void AddTransforms(Transform* out, const Transform* in, const Transform* delta, float weight, const float* weights, unsigned int count);
+
+// A weight of 0 skips the layer entirely
+void Add(Pose& output, const Pose& in, const Pose& delta, float weight);
+void Add(Pose& output, const Pose& in, const Pose& delta, float weight, const std::vector<float>& mask);
@@ -0,0 +1,112 @@
+#include <chrono>
+
+#include "CCDSolver.h"
+
+CCDSolver::CCDSolver()
+{
+    mNumSteps = IK_DEFAULT_STEPS;
+    mThreshold = IK_DEFAULT_THRESHOLD;
+}
+
+unsigned int CCDSolver::Size() const
+{
+    return (unsigned int)mIKChain.size();
+}
+
+void CCDSolver::Resize(unsigned int newSize)
+{
+    mIKChain.resize(newSize);
+}
+
+Transform& CCDSolver::operator[](unsigned int index)
+{
+    return mIKChain[index];
+}
+
+Transform CCDSolver::GetGlobalTransform(unsigned int index) const
+{
+    Transform world = mIKChain[0];
+    for (unsigned int i = 1; i <= index; ++i)
+    {
+        world = combine(world, mIKChain[i]);
+    }
+    return world;
+}
+
+unsigned int CCDSolver::GetNumSteps() const
+{
+    return mNumSteps;
+}
+
+void CCDSolver::SetNumSteps(unsigned int numSteps)
+{
+    mNumSteps = numSteps;
+}
+
+float CCDSolver::GetThreshold() const
+{
+    return mThreshold;
+}
+
+void CCDSolver::SetThreshold(float value)
+{
+    mThreshold = value;
+}
+
+bool CCDSolver::Converged(const vec3& goal) const
+{
+    vec3 effector = GetGlobalTransform(Size() - 1).position;
+    return lenSq(goal - effector) < mThreshold * mThreshold;
+}
+
+bool CCDSolver::Solve(const Transform& target)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    mStats = IKSolveStats();
+
+    unsigned int size = Size();
+    if (size == 0)
+    {
+        return false;
+    }
+    unsigned int last = size - 1;
+    vec3 goal = target.position;
+
+    mStats.converged = Converged(goal);
+    while (!mStats.converged && mStats.iterations < mNumSteps)
+    {
+        mStats.iterations += 1;
+        for (int j = (int)size - 2; j >= 0; --j)
+        {
+            vec3 effector = GetGlobalTransform(last).position;
+            Transform world = GetGlobalTransform((unsigned int)j);
+            vec3 toEffector = effector - world.position;
+            vec3 toGoal = goal - world.position;
+
+            quat effectorToGoal;
+            if (lenSq(toGoal) > VEC3_EPSILON)
+            {
+                effectorToGoal = fromTo(toEffector, toGoal);
+            }
+            // Express the world space rotation in the joint's local space
+            quat worldRotated = world.rotation * effectorToGoal;
+            quat localRotate = worldRotated * inverse(world.rotation);
+            mIKChain[j].rotation = normalized(localRotate * mIKChain[j].rotation);
+
+            if (Converged(goal))
+            {
+                mStats.converged = true;
+                break;
+            }
+        }
+    }
+
+    mStats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return mStats.converged;
+}
+
+const IKSolveStats& CCDSolver::GetStats() const
+{
+    return mStats;
+}
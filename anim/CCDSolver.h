@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include "IKSolver.h"
+#include "../math/Transform.h"
+
+// Cyclic coordinate descent. Each step rotates every joint, end to root, so the
+// end effector points at the goal. The first transform of the chain is in model
+// space, the rest are local to the one before.
+class CCDSolver
+{
+protected:
+    std::vector<Transform> mIKChain;
+    unsigned int mNumSteps;
+    float mThreshold;
+    IKSolveStats mStats;
+
+    bool Converged(const vec3& goal) const;
+
+public:
+    CCDSolver();
+
+    unsigned int Size() const;
+    void Resize(unsigned int newSize);
+    Transform& operator[](unsigned int index);
+    Transform GetGlobalTransform(unsigned int index) const;
+
+    unsigned int GetNumSteps() const;
+    void SetNumSteps(unsigned int numSteps);
+    float GetThreshold() const;
+    void SetThreshold(float value);
+
+    // True once the end effector is within the threshold of the target
+    bool Solve(const Transform& target);
+    const IKSolveStats& GetStats() const;
+};
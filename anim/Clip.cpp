@@ -0,0 +1,206 @@
+#include <cmath>
+
+#include "Clip.h"
+
+Clip::Clip()
+{
+    mName = "No name given";
+    mStartTime = 0.0f;
+    mEndTime = 0.0f;
+    mLooping = true;
+}
+
+float Clip::Sample(Transform* outJoints, float time) const
+{
+    if (GetDuration() == 0.0f)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+
+    unsigned int size = (unsigned int)mTracks.size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int j = mTracks[i].GetId();
+        outJoints[j] = mTracks[i].Sample(outJoints[j], time, mLooping);
+    }
+    return time;
+}
+
+float Clip::Sample(Transform* outJoints, float time, TransformTrackCursor* cursors) const
+{
+    if (GetDuration() == 0.0f)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+
+    unsigned int size = (unsigned int)mTracks.size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int j = mTracks[i].GetId();
+        outJoints[j] = mTracks[i].Sample(outJoints[j], time, mLooping, cursors[i]);
+    }
+    return time;
+}
+
+float Clip::Sample(Pose& outPose, float time) const
+{
+    return Sample(outPose.GetLocalTransforms(), time);
+}
+
+float Clip::Sample(Pose& outPose, float time, TransformTrackCursor* cursors) const
+{
+    return Sample(outPose.GetLocalTransforms(), time, cursors);
+}
+
+float Clip::AdjustTimeToFitRange(float inTime) const
+{
+    if (mLooping)
+    {
+        float duration = mEndTime - mStartTime;
+        if (duration <= 0)
+        {
+            return 0.0f;
+        }
+        inTime = fmodf(inTime - mStartTime, mEndTime - mStartTime);
+        if (inTime < 0.0f)
+        {
+            inTime += mEndTime - mStartTime;
+        }
+        inTime = inTime + mStartTime;
+    }
+    else
+    {
+        if (inTime < mStartTime)
+        {
+            inTime = mStartTime;
+        }
+        if (inTime > mEndTime)
+        {
+            inTime = mEndTime;
+        }
+    }
+    return inTime;
+}
+
+void Clip::RecalculateDuration()
+{
+    mStartTime = 0.0f;
+    mEndTime = 0.0f;
+    bool startSet = false;
+    bool endSet = false;
+    unsigned int tracksSize = (unsigned int)mTracks.size();
+    for (unsigned int i = 0; i < tracksSize; ++i)
+    {
+        if (mTracks[i].IsValid())
+        {
+            float trackStartTime = mTracks[i].GetStartTime();
+            float trackEndTime = mTracks[i].GetEndTime();
+
+            if (trackStartTime < mStartTime || !startSet)
+            {
+                mStartTime = trackStartTime;
+                startSet = true;
+            }
+
+            if (trackEndTime > mEndTime || !endSet)
+            {
+                mEndTime = trackEndTime;
+                endSet = true;
+            }
+        }
+    }
+}
+
+TransformTrack& Clip::operator[](unsigned int joint)
+{
+    for (unsigned int i = 0, size = (unsigned int)mTracks.size(); i < size; ++i)
+    {
+        if (mTracks[i].GetId() == joint)
+        {
+            return mTracks[i];
+        }
+    }
+
+    mTracks.push_back(TransformTrack());
+    mTracks[mTracks.size() - 1].SetId(joint);
+    return mTracks[mTracks.size() - 1];
+}
+
+const TransformTrack* Clip::GetTrack(unsigned int joint) const
+{
+    for (unsigned int i = 0, size = (unsigned int)mTracks.size(); i < size; ++i)
+    {
+        if (mTracks[i].GetId() == joint)
+        {
+            return &mTracks[i];
+        }
+    }
+    return 0;
+}
+
+std::string& Clip::GetName()
+{
+    return mName;
+}
+
+const std::string& Clip::GetName() const
+{
+    return mName;
+}
+
+unsigned int Clip::GetIdAtIndex(unsigned int index) const
+{
+    return mTracks[index].GetId();
+}
+
+unsigned int Clip::Size() const
+{
+    return (unsigned int)mTracks.size();
+}
+
+float Clip::GetDuration() const
+{
+    return mEndTime - mStartTime;
+}
+
+float Clip::GetStartTime() const
+{
+    return mStartTime;
+}
+
+float Clip::GetEndTime() const
+{
+    return mEndTime;
+}
+
+bool Clip::GetLooping() const
+{
+    return mLooping;
+}
+
+void Clip::SetName(const std::string& inNewName)
+{
+    mName = inNewName;
+}
+
+void Clip::SetIdAtIndex(unsigned int index, unsigned int id)
+{
+    return mTracks[index].SetId(id);
+}
+
+void Clip::SetLooping(bool inLooping)
+{
+    mLooping = inLooping;
+}
+
+unsigned int Clip::GetMemoryBytes() const
+{
+    unsigned int result = sizeof(Clip) + (unsigned int)mName.capacity();
+    for (unsigned int i = 0, size = (unsigned int)mTracks.size(); i < size; ++i)
+    {
+        result += mTracks[i].GetMemoryBytes();
+    }
+    return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TransformTrack.h"
+#include "Pose.h"
+
+class Clip
+{
+protected:
+    std::vector<TransformTrack> mTracks;
+    std::string mName;
+    float mStartTime;
+    float mEndTime;
+    bool mLooping;
+
+public:
+    Clip();
+    unsigned int GetIdAtIndex(unsigned int index) const;
+    void SetIdAtIndex(unsigned int index, unsigned int id);
+    unsigned int Size() const;
+    // Writes every animated joint into outJoints, which is indexed by joint id.
+    // Joints without a track are left untouched. Returns the time fit to the clip.
+    float Sample(Transform* outJoints, float time) const;
+    // Same, with one cursor per track (Size() entries) owned by the animated instance
+    float Sample(Transform* outJoints, float time, TransformTrackCursor* cursors) const;
+    float Sample(Pose& outPose, float time) const;
+    float Sample(Pose& outPose, float time, TransformTrackCursor* cursors) const;
+    float AdjustTimeToFitRange(float time) const;
+    TransformTrack& operator[](unsigned int joint);
+    const TransformTrack* GetTrack(unsigned int joint) const;
+    void RecalculateDuration();
+    std::string& GetName();
+    const std::string& GetName() const;
+    void SetName(const std::string& inNewName);
+    float GetDuration() const;
+    float GetStartTime() const;
+    float GetEndTime() const;
+    bool GetLooping() const;
+    void SetLooping(bool inLooping);
+    unsigned int GetMemoryBytes() const;
+};
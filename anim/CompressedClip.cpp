@@ -0,0 +1,453 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "CompressedClip.h"
+#include "../math/simd.h"
+
+// Channels within these of their first frame for the whole clip are stored once
+#define COMPRESSEDCLIP_CONSTANT_POSITION 0.00001f
+#define COMPRESSEDCLIP_CONSTANT_ROTATION 0.0000001f
+#define COMPRESSEDCLIP_CONSTANT_SCALE 0.00001f
+
+#define COMPRESSEDCLIP_SQRT2 1.41421356f
+#define COMPRESSEDCLIP_INV_SQRT2 0.70710678f
+
+namespace
+{
+    void EncodeQuat(const quat& in, unsigned short* out)
+    {
+        quat q = normalized(in);
+        unsigned int largest = 0;
+        for (unsigned int i = 1; i < 4; ++i)
+        {
+            if (fabsf(q.v[i]) > fabsf(q.v[largest]))
+            {
+                largest = i;
+            }
+        }
+        if (q.v[largest] < 0.0f)
+        {
+            q = -q;
+        }
+
+        unsigned long long bits = (unsigned long long)largest << 45;
+        unsigned int shift = 30;
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+            // [-1/sqrt(2), 1/sqrt(2)] to [0, 32767]
+            float unit = q.v[i] * COMPRESSEDCLIP_SQRT2 * 0.5f + 0.5f;
+            unit = unit < 0.0f ? 0.0f : (unit > 1.0f ? 1.0f : unit);
+            bits |= (unsigned long long)(unit * 32767.0f + 0.5f) << shift;
+            shift -= 15;
+        }
+        out[0] = (unsigned short)(bits >> 32);
+        out[1] = (unsigned short)(bits >> 16);
+        out[2] = (unsigned short)bits;
+    }
+
+    inline quat DecodeQuat(const unsigned short* in)
+    {
+        unsigned long long bits = ((unsigned long long)in[0] << 32) | ((unsigned int)in[1] << 16) | in[2];
+        unsigned int largest = (unsigned int)(bits >> 45) & 3;
+        float a = ((float)((bits >> 30) & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * COMPRESSEDCLIP_INV_SQRT2;
+        float b = ((float)((bits >> 15) & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * COMPRESSEDCLIP_INV_SQRT2;
+        float c = ((float)(bits & 0x7FFF) * (2.0f / 32767.0f) - 1.0f) * COMPRESSEDCLIP_INV_SQRT2;
+        float sq = 1.0f - a * a - b * b - c * c;
+        float d = sq > 0.0f ? sqrtf(sq) : 0.0f;
+
+        switch (largest)
+        {
+        case 0: return quat(d, a, b, c);
+        case 1: return quat(a, d, b, c);
+        case 2: return quat(a, b, d, c);
+        default: return quat(a, b, c, d);
+        }
+    }
+
+    // Bounds of one vec3 channel of one joint over every frame
+    void ChannelBounds(const BakedClip& clip, unsigned int joint, bool scale, vec3& outMin, vec3& outMax)
+    {
+        for (unsigned int f = 0, frames = clip.GetFrameCount(); f < frames; ++f)
+        {
+            const vec3& v = scale ? clip.GetScales(f)[joint] : clip.GetPositions(f)[joint];
+            if (f == 0)
+            {
+                outMin = v;
+                outMax = v;
+                continue;
+            }
+            outMin = vec3(fminf(outMin.x, v.x), fminf(outMin.y, v.y), fminf(outMin.z, v.z));
+            outMax = vec3(fmaxf(outMax.x, v.x), fmaxf(outMax.y, v.y), fmaxf(outMax.z, v.z));
+        }
+    }
+
+    void AddRange(std::vector<float>& ranges, const vec3& min, const vec3& max)
+    {
+        vec3 extent = max - min;
+        ranges.push_back(min.x);
+        ranges.push_back(min.y);
+        ranges.push_back(min.z);
+        ranges.push_back(0.0f);
+        ranges.push_back(extent.x / 65535.0f);
+        ranges.push_back(extent.y / 65535.0f);
+        ranges.push_back(extent.z / 65535.0f);
+        ranges.push_back(0.0f);
+    }
+
+    inline unsigned short Quantize(float value, float min, float step)
+    {
+        if (step <= 0.0f)
+        {
+            return 0;
+        }
+        float q = (value - min) / step + 0.5f;
+        q = q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q);
+        return (unsigned short)q;
+    }
+
+    // Dequantizes and lerps one 16 bit vec3 between two frames. Reads four
+    // shorts from each frame; the buffer is padded so the last read stays in bounds.
+    inline void DecodeVec3(const unsigned short* q0, const unsigned short* q1, const float* range, float t, vec3& out)
+    {
+#if MATH_SSE
+        const __m128i zero = _mm_setzero_si128();
+        __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)q0), zero));
+        __m128 f1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)q1), zero));
+        __m128 f = _mm_add_ps(f0, _mm_mul_ps(_mm_sub_ps(f1, f0), _mm_set1_ps(t)));
+        f = _mm_add_ps(_mm_loadu_ps(range), _mm_mul_ps(f, _mm_loadu_ps(range + 4)));
+        float lanes[4];
+        _mm_storeu_ps(lanes, f);
+        out.x = lanes[0];
+        out.y = lanes[1];
+        out.z = lanes[2];
+#else
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            float f = (float)q0[i] + ((float)q1[i] - (float)q0[i]) * t;
+            out.v[i] = range[i] + f * range[4 + i];
+        }
+#endif
+    }
+}
+
+CompressedClip::CompressedClip()
+{
+    mName = "No name given";
+    mJointCount = 0;
+    mFrameCount = 0;
+    mFrameStride = 0;
+    mStartTime = 0.0f;
+    mDuration = 0.0f;
+    mFrameTime = 0.0f;
+    mInvFrameTime = 0.0f;
+    mLooping = true;
+    mSourceBytes = 0;
+    mMaxError = 0.0f;
+}
+
+void CompressedClip::Compress(const BakedClip& clip, const Pose& restPose, float vertexDistance)
+{
+    mName = clip.GetName();
+    mLooping = clip.GetLooping();
+    mJointCount = clip.GetJointCount();
+    mFrameCount = clip.GetFrameCount();
+    mStartTime = clip.GetStartTime();
+    mDuration = clip.GetDuration();
+    mFrameTime = clip.GetFrameTime();
+    mInvFrameTime = mFrameTime > 0.0f ? 1.0f / mFrameTime : 0.0f;
+    mSourceBytes = clip.GetMemoryBytes();
+    mMaxError = 0.0f;
+
+    mConstant.assign(mJointCount, Transform());
+    mRotationJoints.clear();
+    mPositionJoints.clear();
+    mScaleJoints.clear();
+    mPositionRanges.clear();
+    mScaleRanges.clear();
+    mData.clear();
+    if (mFrameCount == 0 || mJointCount == 0)
+    {
+        mFrameCount = 0;
+        return;
+    }
+
+    // Classify every channel as constant or animated
+    for (unsigned int j = 0; j < mJointCount; ++j)
+    {
+        mConstant[j].position = clip.GetPositions(0)[j];
+        mConstant[j].rotation = normalized(clip.GetRotations(0)[j]);
+        mConstant[j].scale = clip.GetScales(0)[j];
+
+        vec3 min, max;
+        ChannelBounds(clip, j, false, min, max);
+        vec3 extent = max - min;
+        if (fmaxf(extent.x, fmaxf(extent.y, extent.z)) > COMPRESSEDCLIP_CONSTANT_POSITION)
+        {
+            mPositionJoints.push_back(j);
+            AddRange(mPositionRanges, min, max);
+        }
+
+        ChannelBounds(clip, j, true, min, max);
+        extent = max - min;
+        if (fmaxf(extent.x, fmaxf(extent.y, extent.z)) > COMPRESSEDCLIP_CONSTANT_SCALE)
+        {
+            mScaleJoints.push_back(j);
+            AddRange(mScaleRanges, min, max);
+        }
+
+        for (unsigned int f = 1; f < mFrameCount; ++f)
+        {
+            float d = fabsf(dot(mConstant[j].rotation, normalized(clip.GetRotations(f)[j])));
+            if (1.0f - d > COMPRESSEDCLIP_CONSTANT_ROTATION)
+            {
+                mRotationJoints.push_back(j);
+                break;
+            }
+        }
+    }
+
+    unsigned int rotations = (unsigned int)mRotationJoints.size();
+    unsigned int positions = (unsigned int)mPositionJoints.size();
+    unsigned int scales = (unsigned int)mScaleJoints.size();
+    mFrameStride = (rotations + positions + scales) * 3;
+    // One short of padding for the four-wide vec3 loads of the last track
+    mData.resize((size_t)mFrameStride * mFrameCount + 1, 0);
+
+    for (unsigned int f = 0; f < mFrameCount; ++f)
+    {
+        unsigned short* out = &mData[(size_t)f * mFrameStride];
+        for (unsigned int i = 0; i < rotations; ++i, out += 3)
+        {
+            EncodeQuat(clip.GetRotations(f)[mRotationJoints[i]], out);
+        }
+        for (unsigned int i = 0; i < positions; ++i, out += 3)
+        {
+            const vec3& v = clip.GetPositions(f)[mPositionJoints[i]];
+            const float* range = &mPositionRanges[i * 8];
+            for (unsigned int c = 0; c < 3; ++c)
+            {
+                out[c] = Quantize(v.v[c], range[c], range[4 + c]);
+            }
+        }
+        for (unsigned int i = 0; i < scales; ++i, out += 3)
+        {
+            const vec3& v = clip.GetScales(f)[mScaleJoints[i]];
+            const float* range = &mScaleRanges[i * 8];
+            for (unsigned int c = 0; c < 3; ++c)
+            {
+                out[c] = Quantize(v.v[c], range[c], range[4 + c]);
+            }
+        }
+    }
+
+    mData.shrink_to_fit();
+    MeasureError(clip, restPose, vertexDistance);
+}
+
+void CompressedClip::MeasureError(const BakedClip& clip, const Pose& restPose, float vertexDistance)
+{
+    if (restPose.Size() != mJointCount)
+    {
+        std::cout << "WARNING: " << mName << " has " << mJointCount << " joints, the rest pose has " << restPose.Size() << ", error not measured\n";
+        return;
+    }
+
+    Pose source = restPose;
+    Pose decoded = restPose;
+    std::vector<Transform> sourceGlobal(mJointCount);
+    std::vector<Transform> decodedGlobal(mJointCount);
+    const vec3 offsets[3] = { vec3(vertexDistance, 0, 0), vec3(0, vertexDistance, 0), vec3(0, 0, vertexDistance) };
+
+    for (unsigned int f = 0; f < mFrameCount; ++f)
+    {
+        Transform* src = source.GetLocalTransforms();
+        for (unsigned int j = 0; j < mJointCount; ++j)
+        {
+            src[j] = Transform(clip.GetPositions(f)[j], clip.GetRotations(f)[j], clip.GetScales(f)[j]);
+        }
+        if (f + 1 < mFrameCount)
+        {
+            DecodeFrames(decoded.GetLocalTransforms(), f, 0.0f);
+        }
+        else
+        {
+            DecodeFrames(decoded.GetLocalTransforms(), f - (f > 0 ? 1 : 0), f > 0 ? 1.0f : 0.0f);
+        }
+
+        source.GetGlobalTransforms(&sourceGlobal[0]);
+        decoded.GetGlobalTransforms(&decodedGlobal[0]);
+        for (unsigned int j = 0; j < mJointCount; ++j)
+        {
+            for (unsigned int v = 0; v < 3; ++v)
+            {
+                vec3 delta = transformPoint(sourceGlobal[j], offsets[v]) - transformPoint(decodedGlobal[j], offsets[v]);
+                float error = sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+                mMaxError = fmaxf(mMaxError, error);
+            }
+        }
+    }
+}
+
+void CompressedClip::DecodeFrames(Transform* outJoints, unsigned int frame, float t) const
+{
+    memcpy(outJoints, &mConstant[0], sizeof(Transform) * mJointCount);
+
+    unsigned int next = frame + 1 < mFrameCount ? frame + 1 : frame;
+    const unsigned short* a = &mData[(size_t)frame * mFrameStride];
+    const unsigned short* b = &mData[(size_t)next * mFrameStride];
+
+    for (unsigned int i = 0, size = (unsigned int)mRotationJoints.size(); i < size; ++i, a += 3, b += 3)
+    {
+        quat r0 = DecodeQuat(a);
+        quat r1 = DecodeQuat(b);
+        // Smallest-three keeps the largest component positive, which can flip
+        // the hemisphere between frames
+        if (dot(r0, r1) < 0.0f)
+        {
+            r1 = -r1;
+        }
+        outJoints[mRotationJoints[i]].rotation = nlerp(r0, r1, t);
+    }
+    for (unsigned int i = 0, size = (unsigned int)mPositionJoints.size(); i < size; ++i, a += 3, b += 3)
+    {
+        DecodeVec3(a, b, &mPositionRanges[i * 8], t, outJoints[mPositionJoints[i]].position);
+    }
+    for (unsigned int i = 0, size = (unsigned int)mScaleJoints.size(); i < size; ++i, a += 3, b += 3)
+    {
+        DecodeVec3(a, b, &mScaleRanges[i * 8], t, outJoints[mScaleJoints[i]].scale);
+    }
+}
+
+float CompressedClip::AdjustTimeToFitRange(float time) const
+{
+    if (mLooping)
+    {
+        if (mDuration <= 0.0f)
+        {
+            return mStartTime;
+        }
+        time = fmodf(time - mStartTime, mDuration);
+        if (time < 0.0f)
+        {
+            time += mDuration;
+        }
+        return time + mStartTime;
+    }
+
+    if (time < mStartTime)
+    {
+        time = mStartTime;
+    }
+    if (time > mStartTime + mDuration)
+    {
+        time = mStartTime + mDuration;
+    }
+    return time;
+}
+
+float CompressedClip::Sample(Transform* outJoints, float time) const
+{
+    if (mFrameCount == 0 || mJointCount == 0)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+
+    float frameTime = (time - mStartTime) * mInvFrameTime;
+    unsigned int frame = (unsigned int)frameTime;
+    unsigned int last = mFrameCount > 1 ? mFrameCount - 2 : 0;
+    if (frame > last)
+    {
+        frame = last;
+    }
+    float t = frameTime - (float)frame;
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+    DecodeFrames(outJoints, frame, t);
+    return time;
+}
+
+float CompressedClip::Sample(Pose& outPose, float time) const
+{
+    if (outPose.Size() < mJointCount)
+    {
+        outPose.Resize(mJointCount);
+    }
+    return Sample(outPose.GetLocalTransforms(), time);
+}
+
+float CompressedClip::GetCompressionRatio() const
+{
+    unsigned int bytes = GetMemoryBytes();
+    return bytes > 0 ? (float)mSourceBytes / (float)bytes : 0.0f;
+}
+
+float CompressedClip::GetMaxError() const
+{
+    return mMaxError;
+}
+
+unsigned int CompressedClip::GetAnimatedTrackCount() const
+{
+    return (unsigned int)(mRotationJoints.size() + mPositionJoints.size() + mScaleJoints.size());
+}
+
+unsigned int CompressedClip::GetConstantTrackCount() const
+{
+    return mJointCount * 3 - GetAnimatedTrackCount();
+}
+
+unsigned int CompressedClip::GetJointCount() const
+{
+    return mJointCount;
+}
+
+unsigned int CompressedClip::GetFrameCount() const
+{
+    return mFrameCount;
+}
+
+float CompressedClip::GetStartTime() const
+{
+    return mStartTime;
+}
+
+float CompressedClip::GetEndTime() const
+{
+    return mStartTime + mDuration;
+}
+
+float CompressedClip::GetDuration() const
+{
+    return mDuration;
+}
+
+bool CompressedClip::GetLooping() const
+{
+    return mLooping;
+}
+
+void CompressedClip::SetLooping(bool inLooping)
+{
+    mLooping = inLooping;
+}
+
+const std::string& CompressedClip::GetName() const
+{
+    return mName;
+}
+
+unsigned int CompressedClip::GetMemoryBytes() const
+{
+    return (unsigned int)(sizeof(CompressedClip) + mName.capacity() +
+        mData.capacity() * sizeof(unsigned short) +
+        mConstant.capacity() * sizeof(Transform) +
+        (mRotationJoints.capacity() + mPositionJoints.capacity() + mScaleJoints.capacity()) * sizeof(unsigned int) +
+        (mPositionRanges.capacity() + mScaleRanges.capacity()) * sizeof(float));
+}
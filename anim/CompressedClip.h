@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "BakedClip.h"
+#include "Pose.h"
+
+// Distance of the virtual vertices used to measure compression error, roughly
+// how far skinned vertices sit from their joint
+#define COMPRESSEDCLIP_VERTEX_DISTANCE 0.1f
+
+// A BakedClip quantized for memory:
+//  - rotations as smallest-three, 48 bits (2 bit index + three 15 bit components)
+//  - positions and scales as 16 bits per component within per-track bounds
+//  - tracks that never change store one full precision value and nothing per frame
+// Per frame, the animated rotations, then positions, then scales are packed as
+// unsigned shorts. Sampling decodes the two neighbouring frames straight into the
+// output transforms.
+class CompressedClip
+{
+protected:
+    std::vector<unsigned short> mData;
+    // Joint transforms with the value of every constant channel
+    std::vector<Transform> mConstant;
+    std::vector<unsigned int> mRotationJoints;
+    std::vector<unsigned int> mPositionJoints;
+    std::vector<unsigned int> mScaleJoints;
+    // Per animated position / scale track: min xyz, 0, then extent / 65535 xyz, 0
+    std::vector<float> mPositionRanges;
+    std::vector<float> mScaleRanges;
+    std::string mName;
+    unsigned int mJointCount;
+    unsigned int mFrameCount;
+    unsigned int mFrameStride;
+    float mStartTime;
+    float mDuration;
+    float mFrameTime;
+    float mInvFrameTime;
+    bool mLooping;
+    unsigned int mSourceBytes;
+    float mMaxError;
+
+    void DecodeFrames(Transform* outJoints, unsigned int frame, float t) const;
+    void MeasureError(const BakedClip& clip, const Pose& restPose, float vertexDistance);
+
+public:
+    CompressedClip();
+
+    // restPose supplies the hierarchy used to measure error in world space
+    void Compress(const BakedClip& clip, const Pose& restPose, float vertexDistance = COMPRESSEDCLIP_VERTEX_DISTANCE);
+
+    // Writes all joints. Returns the time fit to the clip.
+    float Sample(Transform* outJoints, float time) const;
+    float Sample(Pose& outPose, float time) const;
+    float AdjustTimeToFitRange(float time) const;
+
+    // Size of the source BakedClip divided by GetMemoryBytes
+    float GetCompressionRatio() const;
+    // Worst distance between a virtual vertex skinned by the source and by the
+    // compressed clip, over every joint and baked frame
+    float GetMaxError() const;
+    unsigned int GetAnimatedTrackCount() const;
+    unsigned int GetConstantTrackCount() const;
+
+    unsigned int GetJointCount() const;
+    unsigned int GetFrameCount() const;
+    float GetStartTime() const;
+    float GetEndTime() const;
+    float GetDuration() const;
+    bool GetLooping() const;
+    void SetLooping(bool inLooping);
+    const std::string& GetName() const;
+    unsigned int GetMemoryBytes() const;
+};
@@ -0,0 +1,270 @@
+#include <cmath>
+#include <cstring>
+
+#include "CurveClip.h"
+
+// Keys the cursor may step over before a sample is treated as a seek
+#define CURVECLIP_CURSOR_MAX_WALK 4
+
+namespace
+{
+    inline unsigned int KeyFrame(const unsigned char* key)
+    {
+        unsigned short frame;
+        memcpy(&frame, key, sizeof(frame));
+        return frame;
+    }
+}
+
+CurveClip::CurveClip()
+{
+    mName = "No name given";
+    mJointCount = 0;
+    mFrameCount = 0;
+    mStartTime = 0.0f;
+    mDuration = 0.0f;
+    mFrameTime = 0.0f;
+    mInvFrameTime = 0.0f;
+    mLooping = true;
+}
+
+unsigned int CurveClip::FindKey(const CurveClipChannel& channel, const unsigned char* keys, float frame, TrackCursor* cursor)
+{
+    const unsigned char* base = keys + channel.mOffset;
+    int last = (int)channel.mKeyCount - 2;
+
+    if (cursor != 0)
+    {
+        int key = cursor->mFrame;
+        if (key >= 0 && key <= last && (float)KeyFrame(base + key * CURVECLIP_KEY_BYTES) <= frame)
+        {
+            for (int step = 0; step <= CURVECLIP_CURSOR_MAX_WALK; ++step)
+            {
+                if (key == last || (float)KeyFrame(base + (key + 1) * CURVECLIP_KEY_BYTES) > frame)
+                {
+                    cursor->mFrame = key;
+                    return (unsigned int)key;
+                }
+                key += 1;
+            }
+        }
+    }
+
+    // Last key at or before frame, limited to keys that start a segment
+    int lo = 0;
+    int hi = last;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if ((float)KeyFrame(base + mid * CURVECLIP_KEY_BYTES) <= frame)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    if (cursor != 0)
+    {
+        cursor->mFrame = lo;
+    }
+    return (unsigned int)lo;
+}
+
+void CurveClip::SampleChannel(const CurveClipChannel& channel, const unsigned char* keys, float frame, float frameTime,
+    TrackCursor* cursor, float* outValue)
+{
+    unsigned int key = FindKey(channel, keys, frame, cursor);
+    const unsigned char* a = keys + channel.mOffset + key * CURVECLIP_KEY_BYTES;
+    const unsigned char* b = a + CURVECLIP_KEY_BYTES;
+
+    unsigned short values[2][4];
+    memcpy(values[0], a, sizeof(values[0]));
+    memcpy(values[1], b, sizeof(values[1]));
+    float span = (float)values[1][0] - (float)values[0][0];
+    float t = span > 0.0f ? (frame - (float)values[0][0]) / span : 0.0f;
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+    float tt = t * t;
+    float ttt = tt * t;
+    float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+    float h2 = -2.0f * ttt + 3.0f * tt;
+    // Tangents are per second; Hermite wants them over the segment. Each key
+    // holds its scale, then its in and out tangents.
+    const unsigned char* tangentsA = a + sizeof(values[0]);
+    const unsigned char* tangentsB = b + sizeof(values[0]);
+    float tangentScale = channel.mTangentStep * span * frameTime;
+    float h3 = (ttt - 2.0f * tt + t) * tangentScale * (float)tangentsA[0];
+    float h4 = (ttt - tt) * tangentScale * (float)tangentsB[0];
+
+    const signed char* outTangent = (const signed char*)(tangentsA + 4);
+    const signed char* inTangent = (const signed char*)(tangentsB + 1);
+    float value[3];
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        float p1 = channel.mMin[c] + (float)values[0][c + 1] * channel.mStep[c];
+        float p2 = channel.mMin[c] + (float)values[1][c + 1] * channel.mStep[c];
+        value[c] = p1 * h1 + p2 * h2 + (float)outTangent[c] * h3 + (float)inTangent[c] * h4;
+    }
+
+    if (channel.mType != CurveChannel::Rotation)
+    {
+        memcpy(outValue, value, sizeof(value));
+        return;
+    }
+
+    // An overshoot past unit length leaves nothing to rebuild
+    float sq = value[0] * value[0] + value[1] * value[1] + value[2] * value[2];
+    float rebuilt = 0.0f;
+    if (sq > 1.0f)
+    {
+        float invLength = 1.0f / sqrtf(sq);
+        value[0] *= invLength;
+        value[1] *= invLength;
+        value[2] *= invLength;
+    }
+    else
+    {
+        rebuilt = sqrtf(1.0f - sq);
+    }
+    for (unsigned int c = 0, stored = 0; c < 4; ++c)
+    {
+        outValue[c] = c == channel.mRebuilt ? rebuilt : value[stored++];
+    }
+}
+
+float CurveClip::AdjustTimeToFitRange(float time) const
+{
+    if (mLooping)
+    {
+        if (mDuration <= 0.0f)
+        {
+            return mStartTime;
+        }
+        time = fmodf(time - mStartTime, mDuration);
+        if (time < 0.0f)
+        {
+            time += mDuration;
+        }
+        return time + mStartTime;
+    }
+
+    if (time < mStartTime)
+    {
+        time = mStartTime;
+    }
+    if (time > mStartTime + mDuration)
+    {
+        time = mStartTime + mDuration;
+    }
+    return time;
+}
+
+float CurveClip::Sample(Transform* outJoints, float time, TrackCursor* cursors) const
+{
+    if (mFrameCount == 0 || mJointCount == 0)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+    memcpy(outJoints, &mConstant[0], sizeof(Transform) * mJointCount);
+
+    float frame = (time - mStartTime) * mInvFrameTime;
+    float last = (float)(mFrameCount - 1);
+    frame = frame < 0.0f ? 0.0f : (frame > last ? last : frame);
+
+    const unsigned char* keys = mKeys.empty() ? 0 : &mKeys[0];
+    float value[4];
+    for (unsigned int i = 0, size = (unsigned int)mChannels.size(); i < size; ++i)
+    {
+        const CurveClipChannel& channel = mChannels[i];
+        SampleChannel(channel, keys, frame, mFrameTime, cursors != 0 ? &cursors[i] : 0, value);
+        Transform& joint = outJoints[channel.mJoint];
+        if (channel.mType == CurveChannel::Rotation)
+        {
+            joint.rotation = quat(value[0], value[1], value[2], value[3]);
+        }
+        else if (channel.mType == CurveChannel::Position)
+        {
+            joint.position = vec3(value[0], value[1], value[2]);
+        }
+        else
+        {
+            joint.scale = vec3(value[0], value[1], value[2]);
+        }
+    }
+    return time;
+}
+
+float CurveClip::Sample(Pose& outPose, float time, TrackCursor* cursors) const
+{
+    if (outPose.Size() < mJointCount)
+    {
+        outPose.Resize(mJointCount);
+    }
+    return Sample(outPose.GetLocalTransforms(), time, cursors);
+}
+
+unsigned int CurveClip::GetChannelCount() const
+{
+    return (unsigned int)mChannels.size();
+}
+
+unsigned int CurveClip::GetKeyCount() const
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0, size = (unsigned int)mChannels.size(); i < size; ++i)
+    {
+        count += mChannels[i].mKeyCount;
+    }
+    return count;
+}
+
+unsigned int CurveClip::GetJointCount() const
+{
+    return mJointCount;
+}
+
+unsigned int CurveClip::GetFrameCount() const
+{
+    return mFrameCount;
+}
+
+float CurveClip::GetStartTime() const
+{
+    return mStartTime;
+}
+
+float CurveClip::GetEndTime() const
+{
+    return mStartTime + mDuration;
+}
+
+float CurveClip::GetDuration() const
+{
+    return mDuration;
+}
+
+bool CurveClip::GetLooping() const
+{
+    return mLooping;
+}
+
+void CurveClip::SetLooping(bool inLooping)
+{
+    mLooping = inLooping;
+}
+
+const std::string& CurveClip::GetName() const
+{
+    return mName;
+}
+
+unsigned int CurveClip::GetMemoryBytes() const
+{
+    return (unsigned int)(sizeof(CurveClip) + mName.capacity() +
+        mKeys.capacity() +
+        mChannels.capacity() * sizeof(CurveClipChannel) +
+        mConstant.capacity() * sizeof(Transform));
+}
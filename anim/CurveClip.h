@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "BakedClip.h"
+#include "Pose.h"
+#include "Track.h"
+
+// Frame number, three 16 bit values, a tangent scale and 8 bit in and out tangents
+#define CURVECLIP_KEY_BYTES 15
+
+struct CurveCompressionReport;
+
+enum class CurveChannel
+{
+    Position,
+    Rotation,
+    Scale
+};
+
+// One animated channel of a CurveClip and where its keys are
+struct CurveClipChannel
+{
+    unsigned int mJoint = 0;
+    CurveChannel mType = CurveChannel::Position;
+    // First byte of the first key
+    unsigned int mOffset = 0;
+    unsigned int mKeyCount = 0;
+    // Rotations: the quaternion component rebuilt from unit length. The other
+    // three are the stored components, in order.
+    unsigned int mRebuilt = 0;
+    // Stored component = mMin + quantized * mStep
+    float mMin[3] = { 0.0f, 0.0f, 0.0f };
+    float mStep[3] = { 0.0f, 0.0f, 0.0f };
+    // Tangent per second = quantized * key's scale * mTangentStep
+    float mTangentStep = 0.0f;
+};
+
+// Compact cubic Hermite keys, written by FitCurves (see CurveCompression.h). Keys
+// sit on the source clip's frames, so a key's time is a 16 bit frame number on the
+// frame rate the whole clip shares. Every key is CURVECLIP_KEY_BYTES:
+//  - the frame number (16 bits)
+//  - three components, 16 bits each within the channel's bounds. Rotations keep
+//    three quaternion components and rebuild the fourth, which the fitter picks
+//    to stay away from zero for the whole clip.
+//  - a tangent scale (8 bits) relative to the channel's largest tangent, so slow
+//    keys keep their precision, then in and out tangents, 8 bits per component
+// Joints and channels without keys take their value from the rest pose.
+//
+// Sampling finds each channel's segment through a per instance cursor (one
+// TrackCursor per channel), so playing forward never searches.
+class CurveClip
+{
+    friend CurveCompressionReport FitCurves(const BakedClip& source, const Pose& restPose, CurveClip& outClip,
+        float tolerance, float vertexDistance);
+
+protected:
+    std::vector<unsigned char> mKeys;
+    std::vector<CurveClipChannel> mChannels;
+    // Rest pose, overwritten by the animated channels
+    std::vector<Transform> mConstant;
+    std::string mName;
+    unsigned int mJointCount;
+    unsigned int mFrameCount;
+    float mStartTime;
+    float mDuration;
+    float mFrameTime;
+    float mInvFrameTime;
+    bool mLooping;
+
+    // Segment of channel holding frame (a position in source frames), through
+    // cursor when there is one
+    static unsigned int FindKey(const CurveClipChannel& channel, const unsigned char* keys, float frame, TrackCursor* cursor);
+
+public:
+    CurveClip();
+
+    // Decodes the channel's value at frame (a position in source frames) into 3
+    // floats, or 4 for rotations. keys is the start of the key data the channel's
+    // offset is from. Exactly what Sample does, so the fitter can measure it.
+    static void SampleChannel(const CurveClipChannel& channel, const unsigned char* keys, float frame, float frameTime,
+        TrackCursor* cursor, float* outValue);
+
+    // Writes all joints. cursors holds GetChannelCount() entries owned by the
+    // playing instance, or is 0 to search every channel. Returns the time fit to
+    // the clip.
+    float Sample(Transform* outJoints, float time, TrackCursor* cursors = 0) const;
+    float Sample(Pose& outPose, float time, TrackCursor* cursors = 0) const;
+    float AdjustTimeToFitRange(float time) const;
+
+    unsigned int GetChannelCount() const;
+    unsigned int GetKeyCount() const;
+    unsigned int GetJointCount() const;
+    unsigned int GetFrameCount() const;
+    float GetStartTime() const;
+    float GetEndTime() const;
+    float GetDuration() const;
+    bool GetLooping() const;
+    void SetLooping(bool inLooping);
+    const std::string& GetName() const;
+    unsigned int GetMemoryBytes() const;
+};
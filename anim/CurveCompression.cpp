@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "CurveCompression.h"
+
+// Weight pulling a segment's tangents towards the source derivative. Small
+// enough not to matter when the segment has samples to fit, it decides the
+// tangents of segments with fewer than two.
+#define CURVECOMPRESSION_TANGENT_PRIOR 0.001f
+// Largest quantized tangent component and key tangent scale, both are bytes
+#define CURVECOMPRESSION_TANGENT_RANGE 127.0f
+#define CURVECOMPRESSION_SCALE_RANGE 255.0f
+
+namespace
+{
+    inline float ChannelError(const vec3& a, const vec3& b)
+    {
+        vec3 d = a - b;
+        return sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+    }
+
+    // Angle between two rotations. Taken from the chord between the unit
+    // quaternions, since acos(dot) can't resolve small angles in float.
+    inline float ChannelError(const quat& a, const quat& b)
+    {
+        quat d = dot(a, b) < 0.0f ? a + b : a - b;
+        float chord = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z + d.w * d.w);
+        return 4.0f * asinf(fminf(chord * 0.5f, 1.0f));
+    }
+
+    // Joint rotations as the three components a CurveClip stores. The component
+    // rebuilt from unit length is the one farthest from zero over the whole clip,
+    // made positive by flipping each rotation into its hemisphere.
+    void StoreRotations(const std::vector<quat>& rotations, CurveClipChannel& channel, std::vector<vec3>& outStored)
+    {
+        unsigned int count = (unsigned int)rotations.size();
+        float smallest[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            quat q = normalized(rotations[i]);
+            for (unsigned int c = 0; c < 4; ++c)
+            {
+                smallest[c] = fminf(smallest[c], fabsf(q.v[c]));
+            }
+        }
+        channel.mRebuilt = 0;
+        for (unsigned int c = 1; c < 4; ++c)
+        {
+            if (smallest[c] > smallest[channel.mRebuilt])
+            {
+                channel.mRebuilt = c;
+            }
+        }
+
+        outStored.resize(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            quat q = normalized(rotations[i]);
+            if (q.v[channel.mRebuilt] < 0.0f)
+            {
+                q = -q;
+            }
+            for (unsigned int c = 0, stored = 0; c < 4; ++c)
+            {
+                if (c != channel.mRebuilt)
+                {
+                    outStored[i].v[stored++] = q.v[c];
+                }
+            }
+        }
+    }
+
+    // Bounds of every stored component over the clip, 16 bits across each
+    void SetBounds(CurveClipChannel& channel, const std::vector<vec3>& stored)
+    {
+        vec3 low = stored[0];
+        vec3 high = stored[0];
+        for (unsigned int i = 1, size = (unsigned int)stored.size(); i < size; ++i)
+        {
+            for (unsigned int c = 0; c < 3; ++c)
+            {
+                low.v[c] = fminf(low.v[c], stored[i].v[c]);
+                high.v[c] = fmaxf(high.v[c], stored[i].v[c]);
+            }
+        }
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            channel.mMin[c] = low.v[c];
+            channel.mStep[c] = (high.v[c] - low.v[c]) / 65535.0f;
+        }
+    }
+
+    inline void Encode(const CurveClipChannel& channel, const vec3& value, unsigned short* out)
+    {
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            float q = channel.mStep[c] > 0.0f ? (value.v[c] - channel.mMin[c]) / channel.mStep[c] : 0.0f;
+            q = q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q);
+            out[c] = (unsigned short)(q + 0.5f);
+        }
+    }
+
+    inline vec3 Decode(const CurveClipChannel& channel, const unsigned short* in)
+    {
+        return vec3(channel.mMin[0] + (float)in[0] * channel.mStep[0],
+            channel.mMin[1] + (float)in[1] * channel.mStep[1],
+            channel.mMin[2] + (float)in[2] * channel.mStep[2]);
+    }
+
+    inline signed char QuantizeTangent(float value)
+    {
+        float q = floorf(value + 0.5f);
+        q = q < -CURVECOMPRESSION_TANGENT_RANGE ? -CURVECOMPRESSION_TANGENT_RANGE : (q > CURVECOMPRESSION_TANGENT_RANGE ? CURVECOMPRESSION_TANGENT_RANGE : q);
+        return (signed char)q;
+    }
+
+    template <typename T>
+    bool MatchesRest(const std::vector<T>& samples, const T& rest, float errorScale, float tolerance)
+    {
+        for (unsigned int i = 0, size = (unsigned int)samples.size(); i < size; ++i)
+        {
+            if (ChannelError(samples[i], rest) * errorScale > tolerance)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Least squares out tangent of key first and in tangent of key last (both per
+    // second) so the Hermite segment between the keys' stored values passes
+    // closest to the samples in between.
+    void FitSegment(const std::vector<vec3>& samples, const std::vector<vec3>& keyValues, const std::vector<vec3>& slopes,
+        float frameTime, unsigned int first, unsigned int last, vec3& outOut, vec3& outIn)
+    {
+        float span = (float)(last - first);
+        float delta = span * frameTime;
+        const vec3& p1 = keyValues[first];
+        const vec3& p2 = keyValues[last];
+
+        // Normal equations of min |h3 s1 + h4 s2 - r|^2, r the sample less the
+        // value part of the curve, plus the prior on s1 and s2
+        float a11 = CURVECOMPRESSION_TANGENT_PRIOR;
+        float a12 = 0.0f;
+        float a22 = CURVECOMPRESSION_TANGENT_PRIOR;
+        vec3 b1 = slopes[first] * (delta * CURVECOMPRESSION_TANGENT_PRIOR);
+        vec3 b2 = slopes[last] * (delta * CURVECOMPRESSION_TANGENT_PRIOR);
+        for (unsigned int i = first + 1; i < last; ++i)
+        {
+            float t = (float)(i - first) / span;
+            float tt = t * t;
+            float ttt = tt * t;
+            float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+            float h2 = -2.0f * ttt + 3.0f * tt;
+            float h3 = ttt - 2.0f * tt + t;
+            float h4 = ttt - tt;
+
+            vec3 r = samples[i] - (p1 * h1 + p2 * h2);
+            a11 += h3 * h3;
+            a12 += h3 * h4;
+            a22 += h4 * h4;
+            b1 = b1 + r * h3;
+            b2 = b2 + r * h4;
+        }
+
+        float invDet = 1.0f / (a11 * a22 - a12 * a12);
+        float invDelta = 1.0f / delta;
+        outOut = (b1 * a22 - b2 * a12) * (invDet * invDelta);
+        outIn = (b2 * a11 - b1 * a12) * (invDet * invDelta);
+    }
+
+    // Fits stored (the three components the channel keeps, one per source frame)
+    // with cubic keys, written to outKeys in CurveClip's layout with channel
+    // describing them, its offset left at 0. Errors are measured by decoding the
+    // keys with CurveClip::SampleChannel, so quantization counts against the
+    // tolerance: against rotations for a rotation channel, against stored
+    // otherwise, times errorScale.
+    void FitChannel(CurveClipChannel& channel, std::vector<unsigned char>& outKeys, const std::vector<vec3>& stored,
+        const std::vector<quat>& rotations, float frameTime, float errorScale, float tolerance)
+    {
+        unsigned int count = (unsigned int)stored.size();
+
+        // Every frame's value as a key would store it, and as it decodes
+        SetBounds(channel, stored);
+        std::vector<unsigned short> encoded(count * 3);
+        std::vector<vec3> keyValues(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Encode(channel, stored[i], &encoded[i * 3]);
+            keyValues[i] = Decode(channel, &encoded[i * 3]);
+        }
+
+        // Per second derivative of the source at every frame
+        std::vector<vec3> slopes(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            unsigned int prev = i > 0 ? i - 1 : i;
+            unsigned int next = i + 1 < count ? i + 1 : i;
+            slopes[i] = (stored[next] - stored[prev]) * (1.0f / ((float)(next - prev) * frameTime));
+        }
+
+        // Each segment fits its own end tangents, so a key's in and out tangents
+        // differ and a corner in the motion costs one key, not several. The
+        // first key's in tangent and the last key's out tangent are never used.
+        std::vector<unsigned int> keys;
+        keys.push_back(0);
+        keys.push_back(count - 1);
+        std::vector<vec3> inTangents;
+        std::vector<vec3> outTangents;
+        while (true)
+        {
+            unsigned int size = (unsigned int)keys.size();
+            inTangents.resize(size);
+            outTangents.resize(size);
+            std::vector<float> largest(size, 0.0f);
+            float channelLargest = 0.0f;
+            for (unsigned int k = 0; k + 1 < size; ++k)
+            {
+                FitSegment(stored, keyValues, slopes, frameTime, keys[k], keys[k + 1], outTangents[k], inTangents[k + 1]);
+                for (unsigned int c = 0; c < 3; ++c)
+                {
+                    largest[k] = fmaxf(largest[k], fabsf(outTangents[k].v[c]));
+                    largest[k + 1] = fmaxf(largest[k + 1], fabsf(inTangents[k + 1].v[c]));
+                }
+                channelLargest = fmaxf(channelLargest, fmaxf(largest[k], largest[k + 1]));
+            }
+
+            channel.mKeyCount = size;
+            channel.mTangentStep = channelLargest / (CURVECOMPRESSION_TANGENT_RANGE * CURVECOMPRESSION_SCALE_RANGE);
+            outKeys.assign(size * CURVECLIP_KEY_BYTES, 0);
+            for (unsigned int k = 0; k < size; ++k)
+            {
+                unsigned char* key = &outKeys[k * CURVECLIP_KEY_BYTES];
+                unsigned short frame = (unsigned short)keys[k];
+                memcpy(key, &frame, sizeof(frame));
+                memcpy(key + sizeof(frame), &encoded[keys[k] * 3], 3 * sizeof(unsigned short));
+
+                // The smallest scale that holds the key's largest tangent
+                float scale = channelLargest > 0.0f ? ceilf(largest[k] / channelLargest * CURVECOMPRESSION_SCALE_RANGE) : 0.0f;
+                scale = scale > CURVECOMPRESSION_SCALE_RANGE ? CURVECOMPRESSION_SCALE_RANGE : scale;
+                float invStep = scale > 0.0f ? 1.0f / (scale * channel.mTangentStep) : 0.0f;
+                unsigned char* tangents = key + 4 * sizeof(unsigned short);
+                tangents[0] = (unsigned char)scale;
+                signed char* in = (signed char*)(tangents + 1);
+                signed char* out = in + 3;
+                for (unsigned int c = 0; c < 3; ++c)
+                {
+                    in[c] = k > 0 ? QuantizeTangent(inTangents[k].v[c] * invStep) : 0;
+                    out[c] = k + 1 < size ? QuantizeTangent(outTangents[k].v[c] * invStep) : 0;
+                }
+            }
+
+            float worst = 0.0f;
+            unsigned int worstFrame = 0;
+            TrackCursor cursor;
+            float value[4];
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                CurveClip::SampleChannel(channel, &outKeys[0], (float)i, frameTime, &cursor, value);
+                float error = channel.mType == CurveChannel::Rotation ?
+                    ChannelError(quat(value[0], value[1], value[2], value[3]), rotations[i]) :
+                    ChannelError(vec3(value[0], value[1], value[2]), stored[i]);
+                error *= errorScale;
+                if (error > worst)
+                {
+                    worst = error;
+                    worstFrame = i;
+                }
+            }
+            if (worst <= tolerance || size == count)
+            {
+                return;
+            }
+            keys.insert(std::upper_bound(keys.begin(), keys.end(), worstFrame), worstFrame);
+        }
+    }
+}
+
+float CurveCompressionReport::GetCompressionRatio() const
+{
+    return mBytes > 0 ? (float)mSourceBytes / (float)mBytes : 0.0f;
+}
+
+CurveCompressionReport FitCurves(const BakedClip& source, const Pose& restPose, CurveClip& outClip, float tolerance, float vertexDistance)
+{
+    CurveCompressionReport report;
+    outClip = CurveClip();
+    outClip.mName = source.GetName();
+    outClip.mLooping = source.GetLooping();
+
+    unsigned int jointCount = source.GetJointCount();
+    unsigned int frameCount = source.GetFrameCount();
+    if (restPose.Size() != jointCount || !restPose.IsTopologicallySorted())
+    {
+        std::cout << "WARNING: Can't fit " << source.GetName() << ", the rest pose doesn't match its " << jointCount << " sorted joints\n";
+        return report;
+    }
+    if (frameCount > 65536)
+    {
+        std::cout << "WARNING: Can't fit " << source.GetName() << ", its " << frameCount << " frames don't fit 16 bit key frames\n";
+        return report;
+    }
+    if (frameCount < 2)
+    {
+        return report;
+    }
+
+    float frameTime = source.GetFrameTime();
+    const Transform* rest = restPose.GetLocalTransforms();
+    outClip.mConstant.assign(rest, rest + jointCount);
+    outClip.mJointCount = jointCount;
+    outClip.mFrameCount = frameCount;
+    outClip.mStartTime = source.GetStartTime();
+    outClip.mDuration = source.GetDuration();
+    outClip.mFrameTime = frameTime;
+    outClip.mInvFrameTime = frameTime > 0.0f ? 1.0f / frameTime : 0.0f;
+
+    // Reach of every joint's subtree in the rest pose and the deepest chain
+    std::vector<Transform> global(jointCount);
+    restPose.GetGlobalTransforms(&global[0]);
+    const int* parents = restPose.GetParents();
+    std::vector<float> reach(jointCount, vertexDistance);
+    std::vector<unsigned int> depth(jointCount, 0);
+    unsigned int maxDepth = 0;
+    for (unsigned int j = 0; j < jointCount; ++j)
+    {
+        if (parents[j] >= 0)
+        {
+            depth[j] = depth[parents[j]] + 1;
+            maxDepth = std::max(maxDepth, depth[j]);
+        }
+    }
+    for (unsigned int j = jointCount; j-- > 0;)
+    {
+        int parent = parents[j];
+        if (parent >= 0)
+        {
+            float bone = ChannelError(global[j].position, global[parent].position);
+            reach[parent] = std::max(reach[parent], reach[j] + bone);
+        }
+    }
+    float share = tolerance / (float)(maxDepth + 1);
+
+    std::vector<vec3> positions(frameCount);
+    std::vector<quat> rotations(frameCount);
+    std::vector<vec3> scales(frameCount);
+    for (unsigned int j = 0; j < jointCount; ++j)
+    {
+        for (unsigned int f = 0; f < frameCount; ++f)
+        {
+            positions[f] = source.GetPositions(f)[j];
+            rotations[f] = source.GetRotations(f)[j];
+            scales[f] = source.GetScales(f)[j];
+        }
+
+        CurveClipChannel channels[3];
+        std::vector<unsigned char> keys[3];
+        std::vector<vec3> stored;
+        bool animated[3] = { false, false, false };
+        channels[0].mType = CurveChannel::Position;
+        channels[1].mType = CurveChannel::Rotation;
+        channels[2].mType = CurveChannel::Scale;
+        if (!MatchesRest(positions, rest[j].position, 1.0f, share))
+        {
+            FitChannel(channels[0], keys[0], positions, rotations, frameTime, 1.0f, share);
+            animated[0] = true;
+        }
+        if (!MatchesRest(rotations, rest[j].rotation, reach[j], share))
+        {
+            StoreRotations(rotations, channels[1], stored);
+            FitChannel(channels[1], keys[1], stored, rotations, frameTime, reach[j], share);
+            animated[1] = true;
+        }
+        if (!MatchesRest(scales, rest[j].scale, reach[j], share))
+        {
+            FitChannel(channels[2], keys[2], scales, rotations, frameTime, reach[j], share);
+            animated[2] = true;
+        }
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            if (animated[c])
+            {
+                channels[c].mJoint = j;
+                channels[c].mOffset = (unsigned int)outClip.mKeys.size();
+                outClip.mKeys.insert(outClip.mKeys.end(), keys[c].begin(), keys[c].end());
+                outClip.mChannels.push_back(channels[c]);
+            }
+        }
+    }
+    outClip.mKeys.shrink_to_fit();
+    outClip.mChannels.shrink_to_fit();
+
+    report.mKeys = outClip.GetKeyCount();
+    report.mSourceKeys = frameCount * jointCount * 3;
+    report.mSourceBytes = source.GetMemoryBytes();
+    report.mBytes = outClip.GetMemoryBytes();
+
+    // Measure the result in world space with the runtime sampler. Looping is
+    // off while measuring so the last frame is not wrapped to the first.
+    outClip.mLooping = false;
+    Pose sourcePose = restPose;
+    Pose fittedPose = restPose;
+    std::vector<Transform> sourceGlobal(jointCount);
+    std::vector<Transform> fittedGlobal(jointCount);
+    std::vector<TrackCursor> cursors(outClip.GetChannelCount());
+    const vec3 offsets[3] = { vec3(vertexDistance, 0, 0), vec3(0, vertexDistance, 0), vec3(0, 0, vertexDistance) };
+    for (unsigned int f = 0; f < frameCount; ++f)
+    {
+        Transform* src = sourcePose.GetLocalTransforms();
+        for (unsigned int j = 0; j < jointCount; ++j)
+        {
+            src[j] = Transform(source.GetPositions(f)[j], source.GetRotations(f)[j], source.GetScales(f)[j]);
+        }
+        float time = f == frameCount - 1 ? outClip.GetEndTime() : outClip.mStartTime + frameTime * (float)f;
+        outClip.Sample(fittedPose, time, cursors.empty() ? 0 : &cursors[0]);
+
+        sourcePose.GetGlobalTransforms(&sourceGlobal[0]);
+        fittedPose.GetGlobalTransforms(&fittedGlobal[0]);
+        for (unsigned int j = 0; j < jointCount; ++j)
+        {
+            for (unsigned int v = 0; v < 3; ++v)
+            {
+                float error = ChannelError(transformPoint(sourceGlobal[j], offsets[v]), transformPoint(fittedGlobal[j], offsets[v]));
+                report.mMaxError = std::max(report.mMaxError, error);
+            }
+        }
+    }
+    outClip.mLooping = source.GetLooping();
+
+    return report;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "BakedClip.h"
+#include "CurveClip.h"
+#include "Pose.h"
+
+#define CURVECOMPRESSION_DEFAULT_TOLERANCE 0.001f
+#define CURVECOMPRESSION_VERTEX_DISTANCE 0.1f
+
+struct CurveCompressionReport
+{
+    unsigned int mSourceKeys = 0;
+    unsigned int mKeys = 0;
+    unsigned int mSourceBytes = 0;
+    unsigned int mBytes = 0;
+    // Worst world space distance between virtual vertices skinned by the source
+    // and by the fitted clip, over every joint and source frame
+    float mMaxError = 0.0f;
+
+    float GetCompressionRatio() const;
+};
+
+// Offline. Fits cubic Hermite keys to every animated channel of source by greedy
+// key insertion: starting from the end keys, the source frame with the largest
+// error becomes a key until the channel is within tolerance. Every segment fits
+// its own end tangents by least squares, so keys carry separate in and out
+// tangents. Errors are measured on the quantized keys, decoded exactly as
+// CurveClip samples them, so quantization is inside the tolerance.
+//
+// Errors are bounded in world space: a joint's rotation and scale error is
+// weighted by the reach of its subtree (the farthest descendant virtual vertex,
+// vertexDistance beyond each joint) and the tolerance is split across the deepest
+// chain, so errors propagated down the hierarchy stay within tolerance at the
+// leaves. Channels equal to the rest pose for the whole clip get no keys.
+// restPose supplies the hierarchy. Sources over 65536 frames are not supported.
+CurveCompressionReport FitCurves(const BakedClip& source, const Pose& restPose, CurveClip& outClip,
+    float tolerance = CURVECOMPRESSION_DEFAULT_TOLERANCE, float vertexDistance = CURVECOMPRESSION_VERTEX_DISTANCE);
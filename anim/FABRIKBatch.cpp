@@ -0,0 +1,384 @@
+#include <chrono>
+#include <cmath>
+
+#include "FABRIKBatch.h"
+#include "FABRIKSolver.h"
+#include "../math/simd.h"
+
+// Floats per joint per group: x, y and z of every lane
+#define IKBATCH_JOINT_STRIDE (3 * IKBATCH_LANES)
+
+namespace
+{
+#if MATH_SSE
+    inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // Moves joint onto the line from anchor through it, length away from anchor.
+    // Lanes set in keep are left alone.
+    inline void Reach(float* joint, const float* anchor, const float* length, __m128 keep)
+    {
+        __m128 jx = _mm_loadu_ps(joint);
+        __m128 jy = _mm_loadu_ps(joint + 4);
+        __m128 jz = _mm_loadu_ps(joint + 8);
+        __m128 ax = _mm_loadu_ps(anchor);
+        __m128 ay = _mm_loadu_ps(anchor + 4);
+        __m128 az = _mm_loadu_ps(anchor + 8);
+        __m128 dx = _mm_sub_ps(jx, ax);
+        __m128 dy = _mm_sub_ps(jy, ay);
+        __m128 dz = _mm_sub_ps(jz, az);
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 scale = _mm_div_ps(_mm_loadu_ps(length), _mm_max_ps(distance, _mm_set1_ps(VEC3_EPSILON)));
+        _mm_storeu_ps(joint, Select(keep, jx, _mm_add_ps(ax, _mm_mul_ps(dx, scale))));
+        _mm_storeu_ps(joint + 4, Select(keep, jy, _mm_add_ps(ay, _mm_mul_ps(dy, scale))));
+        _mm_storeu_ps(joint + 8, Select(keep, jz, _mm_add_ps(az, _mm_mul_ps(dz, scale))));
+    }
+
+    inline void Place(float* joint, const float* position, __m128 keep)
+    {
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            __m128 current = _mm_loadu_ps(joint + axis * 4);
+            _mm_storeu_ps(joint + axis * 4, Select(keep, current, _mm_loadu_ps(position + axis * 4)));
+        }
+    }
+
+    inline __m128 DistanceSq(const float* a, const float* b)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(a + 4), _mm_loadu_ps(b + 4));
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(a + 8), _mm_loadu_ps(b + 8));
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    }
+#else
+    inline void Reach(float* joint, const float* anchor, const float* length, const bool* keep)
+    {
+        for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+        {
+            if (keep[lane])
+            {
+                continue;
+            }
+            float dx = joint[lane] - anchor[lane];
+            float dy = joint[lane + 4] - anchor[lane + 4];
+            float dz = joint[lane + 8] - anchor[lane + 8];
+            float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+            float scale = length[lane] / fmaxf(distance, VEC3_EPSILON);
+            joint[lane] = anchor[lane] + dx * scale;
+            joint[lane + 4] = anchor[lane + 4] + dy * scale;
+            joint[lane + 8] = anchor[lane + 8] + dz * scale;
+        }
+    }
+
+    inline void Place(float* joint, const float* position, const bool* keep)
+    {
+        for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+        {
+            if (!keep[lane])
+            {
+                joint[lane] = position[lane];
+                joint[lane + 4] = position[lane + 4];
+                joint[lane + 8] = position[lane + 8];
+            }
+        }
+    }
+
+    inline float DistanceSq(const float* a, const float* b, unsigned int lane)
+    {
+        float dx = a[lane] - b[lane];
+        float dy = a[lane + 4] - b[lane + 4];
+        float dz = a[lane + 8] - b[lane + 8];
+        return dx * dx + dy * dy + dz * dz;
+    }
+#endif
+}
+
+FABRIKBatch::FABRIKBatch()
+{
+    mJointCount = 0;
+    mChainCount = 0;
+    mNumSteps = IK_DEFAULT_STEPS;
+    mThreshold = IK_DEFAULT_THRESHOLD;
+}
+
+void FABRIKBatch::Resize(unsigned int jointCount, unsigned int chainCount)
+{
+    unsigned int groups = (chainCount + IKBATCH_LANES - 1) / IKBATCH_LANES;
+    mJointCount = jointCount;
+    mChainCount = chainCount;
+    mChains.resize(jointCount * chainCount);
+    mTargets.resize(chainCount);
+    mPositions.assign(groups * jointCount * IKBATCH_JOINT_STRIDE, 0.0f);
+    mLengths.assign(groups * jointCount * IKBATCH_LANES, 0.0f);
+    mIterations.assign(chainCount, 0);
+    mConverged.assign(chainCount, false);
+    mWorldChain.resize(jointCount);
+}
+
+unsigned int FABRIKBatch::GetJointCount() const
+{
+    return mJointCount;
+}
+
+unsigned int FABRIKBatch::GetChainCount() const
+{
+    return mChainCount;
+}
+
+Transform* FABRIKBatch::GetChain(unsigned int chain)
+{
+    return &mChains[chain * mJointCount];
+}
+
+const Transform* FABRIKBatch::GetChain(unsigned int chain) const
+{
+    return &mChains[chain * mJointCount];
+}
+
+void FABRIKBatch::SetTarget(unsigned int chain, const vec3& target)
+{
+    mTargets[chain] = target;
+}
+
+unsigned int FABRIKBatch::GetNumSteps() const
+{
+    return mNumSteps;
+}
+
+void FABRIKBatch::SetNumSteps(unsigned int numSteps)
+{
+    mNumSteps = numSteps;
+}
+
+float FABRIKBatch::GetThreshold() const
+{
+    return mThreshold;
+}
+
+void FABRIKBatch::SetThreshold(float value)
+{
+    mThreshold = value;
+}
+
+void FABRIKBatch::Gather(unsigned int group)
+{
+    float* positions = &mPositions[group * mJointCount * IKBATCH_JOINT_STRIDE];
+    float* lengths = &mLengths[group * mJointCount * IKBATCH_LANES];
+    for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+    {
+        // Lanes past the last chain stay at the origin with zero length bones and
+        // a target at the origin, so they count as converged from the start
+        unsigned int chain = group * IKBATCH_LANES + lane;
+        if (chain >= mChainCount)
+        {
+            continue;
+        }
+
+        const Transform* transforms = GetChain(chain);
+        Transform world;
+        vec3 previous;
+        for (unsigned int i = 0; i < mJointCount; ++i)
+        {
+            world = i == 0 ? transforms[0] : combine(world, transforms[i]);
+            float* joint = positions + i * IKBATCH_JOINT_STRIDE;
+            joint[lane] = world.position.x;
+            joint[lane + 4] = world.position.y;
+            joint[lane + 8] = world.position.z;
+            lengths[i * IKBATCH_LANES + lane] = i == 0 ? 0.0f : len(world.position - previous);
+            previous = world.position;
+        }
+    }
+}
+
+void FABRIKBatch::Scatter(unsigned int group)
+{
+    const float* positions = &mPositions[group * mJointCount * IKBATCH_JOINT_STRIDE];
+    for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+    {
+        unsigned int chain = group * IKBATCH_LANES + lane;
+        if (chain >= mChainCount)
+        {
+            return;
+        }
+        for (unsigned int i = 0; i < mJointCount; ++i)
+        {
+            const float* joint = positions + i * IKBATCH_JOINT_STRIDE;
+            mWorldChain[i] = vec3(joint[lane], joint[lane + 4], joint[lane + 8]);
+        }
+        FABRIKPositionsToChain(GetChain(chain), &mWorldChain[0], mJointCount);
+    }
+}
+
+void FABRIKBatch::SolveGroup(unsigned int group)
+{
+    float* positions = &mPositions[group * mJointCount * IKBATCH_JOINT_STRIDE];
+    const float* lengths = &mLengths[group * mJointCount * IKBATCH_LANES];
+    float* effector = positions + (mJointCount - 1) * IKBATCH_JOINT_STRIDE;
+
+    float goal[IKBATCH_JOINT_STRIDE] = { 0.0f };
+    float base[IKBATCH_JOINT_STRIDE];
+    for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+    {
+        unsigned int chain = group * IKBATCH_LANES + lane;
+        if (chain < mChainCount)
+        {
+            goal[lane] = mTargets[chain].x;
+            goal[lane + 4] = mTargets[chain].y;
+            goal[lane + 8] = mTargets[chain].z;
+        }
+    }
+    for (unsigned int i = 0; i < IKBATCH_JOINT_STRIDE; ++i)
+    {
+        base[i] = positions[i];
+    }
+
+    unsigned int iterations[IKBATCH_LANES] = { 0 };
+    bool converged[IKBATCH_LANES];
+    float minProgress = mThreshold * IKBATCH_MIN_PROGRESS;
+
+#if MATH_SSE
+    const __m128 thresholdSq = _mm_set1_ps(mThreshold * mThreshold);
+    __m128 distanceSq = DistanceSq(effector, goal);
+    __m128 done = _mm_cmplt_ps(distanceSq, thresholdSq);
+    __m128 reached = done;
+    __m128 previous = _mm_sqrt_ps(distanceSq);
+    __m128i counts = _mm_setzero_si128();
+
+    for (unsigned int step = 0; step < mNumSteps && _mm_movemask_ps(done) != 0xF; ++step)
+    {
+        // Mask lanes are all ones, so subtracting the active mask counts an iteration
+        __m128 active = _mm_andnot_ps(done, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+        counts = _mm_sub_epi32(counts, _mm_castps_si128(active));
+
+        Place(effector, goal, done);
+        for (int i = (int)mJointCount - 2; i >= 0; --i)
+        {
+            Reach(positions + i * IKBATCH_JOINT_STRIDE, positions + (i + 1) * IKBATCH_JOINT_STRIDE, lengths + (i + 1) * IKBATCH_LANES, done);
+        }
+        Place(positions, base, done);
+        for (unsigned int i = 1; i < mJointCount; ++i)
+        {
+            Reach(positions + i * IKBATCH_JOINT_STRIDE, positions + (i - 1) * IKBATCH_JOINT_STRIDE, lengths + i * IKBATCH_LANES, done);
+        }
+
+        distanceSq = DistanceSq(effector, goal);
+        __m128 distance = _mm_sqrt_ps(distanceSq);
+        __m128 arrived = _mm_andnot_ps(done, _mm_cmplt_ps(distanceSq, thresholdSq));
+        __m128 stalled = _mm_cmplt_ps(_mm_sub_ps(previous, distance), _mm_set1_ps(minProgress));
+        reached = _mm_or_ps(reached, arrived);
+        done = _mm_or_ps(done, _mm_or_ps(arrived, stalled));
+        previous = distance;
+    }
+
+    _mm_storeu_si128((__m128i*)iterations, counts);
+    int reachedMask = _mm_movemask_ps(reached);
+    for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+    {
+        converged[lane] = (reachedMask & (1 << lane)) != 0;
+    }
+#else
+    bool done[IKBATCH_LANES];
+    float previous[IKBATCH_LANES];
+    float thresholdSq = mThreshold * mThreshold;
+    for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+    {
+        float distanceSq = DistanceSq(effector, goal, lane);
+        converged[lane] = distanceSq < thresholdSq;
+        done[lane] = converged[lane];
+        previous[lane] = sqrtf(distanceSq);
+    }
+
+    for (unsigned int step = 0; step < mNumSteps; ++step)
+    {
+        if (done[0] && done[1] && done[2] && done[3])
+        {
+            break;
+        }
+        for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+        {
+            iterations[lane] += done[lane] ? 0 : 1;
+        }
+
+        Place(effector, goal, done);
+        for (int i = (int)mJointCount - 2; i >= 0; --i)
+        {
+            Reach(positions + i * IKBATCH_JOINT_STRIDE, positions + (i + 1) * IKBATCH_JOINT_STRIDE, lengths + (i + 1) * IKBATCH_LANES, done);
+        }
+        Place(positions, base, done);
+        for (unsigned int i = 1; i < mJointCount; ++i)
+        {
+            Reach(positions + i * IKBATCH_JOINT_STRIDE, positions + (i - 1) * IKBATCH_JOINT_STRIDE, lengths + i * IKBATCH_LANES, done);
+        }
+
+        for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+        {
+            if (done[lane])
+            {
+                continue;
+            }
+            float distanceSq = DistanceSq(effector, goal, lane);
+            float distance = sqrtf(distanceSq);
+            converged[lane] = distanceSq < thresholdSq;
+            done[lane] = converged[lane] || previous[lane] - distance < minProgress;
+            previous[lane] = distance;
+        }
+    }
+#endif
+
+    for (unsigned int lane = 0; lane < IKBATCH_LANES; ++lane)
+    {
+        unsigned int chain = group * IKBATCH_LANES + lane;
+        if (chain >= mChainCount)
+        {
+            break;
+        }
+        mIterations[chain] = iterations[lane];
+        mConverged[chain] = converged[lane];
+        mStats.iterations += iterations[lane];
+        mStats.converged += converged[lane] ? 1 : 0;
+        if (iterations[lane] > mStats.maxIterations)
+        {
+            mStats.maxIterations = iterations[lane];
+        }
+    }
+}
+
+unsigned int FABRIKBatch::Solve()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    mStats = IKBatchStats();
+    mStats.chains = mChainCount;
+    if (mJointCount == 0)
+    {
+        return 0;
+    }
+
+    unsigned int groups = (mChainCount + IKBATCH_LANES - 1) / IKBATCH_LANES;
+    for (unsigned int group = 0; group < groups; ++group)
+    {
+        Gather(group);
+        SolveGroup(group);
+        Scatter(group);
+    }
+
+    mStats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return mStats.converged;
+}
+
+bool FABRIKBatch::IsConverged(unsigned int chain) const
+{
+    return mConverged[chain];
+}
+
+unsigned int FABRIKBatch::GetIterations(unsigned int chain) const
+{
+    return mIterations[chain];
+}
+
+const IKBatchStats& FABRIKBatch::GetStats() const
+{
+    return mStats;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include "IKSolver.h"
+#include "../math/Transform.h"
+
+// Chains solved side by side, one per SIMD lane
+#define IKBATCH_LANES 4
+// A lane that gets less than this fraction of the threshold closer to its goal
+// in one iteration is treated as out of reach and stops
+#define IKBATCH_MIN_PROGRESS 0.01f
+
+struct IKBatchStats
+{
+    // Last Solve
+    unsigned int chains = 0;
+    unsigned int converged = 0;
+    // Summed over chains
+    unsigned long long iterations = 0;
+    unsigned int maxIterations = 0;
+    double seconds = 0.0;
+
+    double GetSecondsPerSolve() const { return chains > 0 ? seconds / chains : 0.0; }
+};
+
+// FABRIK for many chains with the same joint count, e.g. the left leg of every
+// character in a crowd. Chains are solved four at a time with one chain per SIMD
+// lane. A lane stops once its end effector is within the threshold of its goal,
+// or once an iteration no longer brings it closer (the goal is out of reach), and
+// a group of four stops when all its lanes have.
+//
+// Chains use the FABRIKSolver layout: the first transform is in model space, the
+// rest are local to the one before. Fill them with GetChain, set the targets,
+// Solve, and read the rotated chains back from GetChain.
+class FABRIKBatch
+{
+protected:
+    unsigned int mJointCount;
+    unsigned int mChainCount;
+    unsigned int mNumSteps;
+    float mThreshold;
+    std::vector<Transform> mChains;
+    std::vector<vec3> mTargets;
+    // Per group of IKBATCH_LANES chains and per joint: x, y, z of every lane
+    std::vector<float> mPositions;
+    // Per group and per joint: length of the bone ending at the joint in every lane
+    std::vector<float> mLengths;
+    std::vector<unsigned int> mIterations;
+    std::vector<bool> mConverged;
+    std::vector<vec3> mWorldChain;
+    IKBatchStats mStats;
+
+    void Gather(unsigned int group);
+    void Scatter(unsigned int group);
+    void SolveGroup(unsigned int group);
+
+public:
+    FABRIKBatch();
+
+    void Resize(unsigned int jointCount, unsigned int chainCount);
+    unsigned int GetJointCount() const;
+    unsigned int GetChainCount() const;
+
+    // GetJointCount() transforms
+    Transform* GetChain(unsigned int chain);
+    const Transform* GetChain(unsigned int chain) const;
+    void SetTarget(unsigned int chain, const vec3& target);
+
+    unsigned int GetNumSteps() const;
+    void SetNumSteps(unsigned int numSteps);
+    float GetThreshold() const;
+    void SetThreshold(float value);
+
+    // Returns how many chains converged
+    unsigned int Solve();
+    bool IsConverged(unsigned int chain) const;
+    unsigned int GetIterations(unsigned int chain) const;
+    const IKBatchStats& GetStats() const;
+};
@@ -0,0 +1,155 @@
+#include <chrono>
+
+#include "FABRIKSolver.h"
+
+FABRIKSolver::FABRIKSolver()
+{
+    mNumSteps = IK_DEFAULT_STEPS;
+    mThreshold = IK_DEFAULT_THRESHOLD;
+}
+
+unsigned int FABRIKSolver::Size() const
+{
+    return (unsigned int)mIKChain.size();
+}
+
+void FABRIKSolver::Resize(unsigned int newSize)
+{
+    mIKChain.resize(newSize);
+    mWorldChain.resize(newSize);
+    mLengths.resize(newSize);
+}
+
+Transform FABRIKSolver::GetLocalTransform(unsigned int index) const
+{
+    return mIKChain[index];
+}
+
+void FABRIKSolver::SetLocalTransform(unsigned int index, const Transform& t)
+{
+    mIKChain[index] = t;
+}
+
+Transform FABRIKSolver::GetGlobalTransform(unsigned int index) const
+{
+    Transform world = mIKChain[0];
+    for (unsigned int i = 1; i <= index; ++i)
+    {
+        world = combine(world, mIKChain[i]);
+    }
+    return world;
+}
+
+unsigned int FABRIKSolver::GetNumSteps() const
+{
+    return mNumSteps;
+}
+
+void FABRIKSolver::SetNumSteps(unsigned int numSteps)
+{
+    mNumSteps = numSteps;
+}
+
+float FABRIKSolver::GetThreshold() const
+{
+    return mThreshold;
+}
+
+void FABRIKSolver::SetThreshold(float value)
+{
+    mThreshold = value;
+}
+
+void FABRIKSolver::IKChainToWorld()
+{
+    unsigned int size = Size();
+    Transform world;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        world = i == 0 ? mIKChain[0] : combine(world, mIKChain[i]);
+        mWorldChain[i] = world.position;
+        mLengths[i] = i == 0 ? 0.0f : len(mWorldChain[i] - mWorldChain[i - 1]);
+    }
+}
+
+void FABRIKSolver::IterateBackward(const vec3& goal)
+{
+    int size = (int)Size();
+    mWorldChain[size - 1] = goal;
+    for (int i = size - 2; i >= 0; --i)
+    {
+        vec3 direction = normalized(mWorldChain[i] - mWorldChain[i + 1]);
+        mWorldChain[i] = mWorldChain[i + 1] + direction * mLengths[i + 1];
+    }
+}
+
+void FABRIKSolver::IterateForward(const vec3& base)
+{
+    unsigned int size = Size();
+    mWorldChain[0] = base;
+    for (unsigned int i = 1; i < size; ++i)
+    {
+        vec3 direction = normalized(mWorldChain[i] - mWorldChain[i - 1]);
+        mWorldChain[i] = mWorldChain[i - 1] + direction * mLengths[i];
+    }
+}
+
+void FABRIKSolver::WorldToIKChain()
+{
+    FABRIKPositionsToChain(&mIKChain[0], &mWorldChain[0], Size());
+}
+
+void FABRIKPositionsToChain(Transform* chain, const vec3* worldChain, unsigned int size)
+{
+    // World transform of the joint before i, already solved
+    Transform parent;
+    for (unsigned int i = 0; i + 1 < size; ++i)
+    {
+        Transform world = i == 0 ? chain[0] : combine(parent, chain[i]);
+        Transform next = combine(world, chain[i + 1]);
+        // Both directions in the joint's space, so the delta is a local rotation
+        quat invRotation = inverse(world.rotation);
+        vec3 toNext = invRotation * (next.position - world.position);
+        vec3 toDesired = invRotation * (worldChain[i + 1] - world.position);
+        quat delta = fromTo(toNext, toDesired);
+        chain[i].rotation = normalized(delta * chain[i].rotation);
+        parent = i == 0 ? chain[0] : combine(parent, chain[i]);
+    }
+}
+
+bool FABRIKSolver::Solve(const Transform& target)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    mStats = IKSolveStats();
+
+    unsigned int size = Size();
+    if (size == 0)
+    {
+        return false;
+    }
+    unsigned int last = size - 1;
+    float thresholdSq = mThreshold * mThreshold;
+
+    IKChainToWorld();
+    vec3 goal = target.position;
+    vec3 base = mWorldChain[0];
+
+    mStats.converged = lenSq(goal - mWorldChain[last]) < thresholdSq;
+    while (!mStats.converged && mStats.iterations < mNumSteps)
+    {
+        mStats.iterations += 1;
+        IterateBackward(goal);
+        IterateForward(base);
+        mStats.converged = lenSq(goal - mWorldChain[last]) < thresholdSq;
+    }
+
+    WorldToIKChain();
+    mStats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return mStats.converged;
+}
+
+const IKSolveStats& FABRIKSolver::GetStats() const
+{
+    return mStats;
+}
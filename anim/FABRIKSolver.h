@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "IKSolver.h"
+#include "../math/Transform.h"
+
+// Forward and backward reaching IK. Works on joint positions: each step drags the
+// chain end to the goal and back to its base, keeping bone lengths, then turns
+// the positions back into joint rotations. The first transform of the chain is
+// in model space, the rest are local to the one before.
+class FABRIKSolver
+{
+protected:
+    std::vector<Transform> mIKChain;
+    unsigned int mNumSteps;
+    float mThreshold;
+    std::vector<vec3> mWorldChain;
+    std::vector<float> mLengths;
+    IKSolveStats mStats;
+
+    void IKChainToWorld();
+    void IterateForward(const vec3& base);
+    void IterateBackward(const vec3& goal);
+    void WorldToIKChain();
+
+public:
+    FABRIKSolver();
+
+    unsigned int Size() const;
+    void Resize(unsigned int newSize);
+    Transform GetLocalTransform(unsigned int index) const;
+    void SetLocalTransform(unsigned int index, const Transform& t);
+    Transform GetGlobalTransform(unsigned int index) const;
+
+    unsigned int GetNumSteps() const;
+    void SetNumSteps(unsigned int numSteps);
+    float GetThreshold() const;
+    void SetThreshold(float value);
+
+    // True once the end effector is within the threshold of the target
+    bool Solve(const Transform& target);
+    const IKSolveStats& GetStats() const;
+};
+
+// Writes solved world positions back into a chain as rotations. Shared with the
+// batched solver.
+void FABRIKPositionsToChain(Transform* chain, const vec3* worldChain, unsigned int size);
@@ -0,0 +1,269 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "FootIK.h"
+#include "IKSolver.h"
+#include "../core/JobSystem.h"
+
+// Hits on surfaces steeper than this (normal y) are walls, not ground
+#define FOOTIK_MIN_GROUND_NORMAL 0.2f
+
+FootIK::FootIK()
+{
+    mGround = 0;
+    mJobSystem = 0;
+    mJob = 0;
+}
+
+FootIK::~FootIK()
+{
+    Sync();
+}
+
+void FootIK::SetGround(const Ground* ground)
+{
+    Sync();
+    mGround = ground;
+}
+
+unsigned int FootIK::Register(const FootIKRig& rig)
+{
+    if (rig.mLegCount > FOOTIK_MAX_LEGS)
+    {
+        std::cout << "WARNING: Foot IK supports " << FOOTIK_MAX_LEGS << " legs, rig has " << rig.mLegCount << "\n";
+    }
+
+    unsigned int handle = 0;
+    if (!mFree.empty())
+    {
+        handle = mFree.back();
+        mFree.pop_back();
+    }
+    else
+    {
+        handle = (unsigned int)mCharacters.size();
+        mCharacters.push_back(Character());
+        mRays.resize(mCharacters.size() * FOOTIK_MAX_LEGS);
+    }
+
+    Character& character = mCharacters[handle];
+    character.mRig = rig;
+    if (character.mRig.mLegCount > FOOTIK_MAX_LEGS)
+    {
+        character.mRig.mLegCount = FOOTIK_MAX_LEGS;
+    }
+    character.mActive = true;
+    for (unsigned int leg = 0; leg < FOOTIK_MAX_LEGS; ++leg)
+    {
+        mRays[handle * FOOTIK_MAX_LEGS + leg].length = 0.0f;
+    }
+    return handle;
+}
+
+void FootIK::Unregister(unsigned int handle)
+{
+    if (handle >= mCharacters.size() || !mCharacters[handle].mActive)
+    {
+        return;
+    }
+    mCharacters[handle].mActive = false;
+    for (unsigned int leg = 0; leg < FOOTIK_MAX_LEGS; ++leg)
+    {
+        mRays[handle * FOOTIK_MAX_LEGS + leg].length = 0.0f;
+    }
+    mFree.push_back(handle);
+}
+
+void FootIK::Query(unsigned int handle, const Pose& pose, const Transform& world)
+{
+    const FootIKRig& rig = mCharacters[handle].mRig;
+    for (unsigned int leg = 0; leg < rig.mLegCount; ++leg)
+    {
+        vec3 ankle = transformPoint(world, pose.GetGlobalTransform(rig.mLegs[leg].mAnkle).position);
+        GroundRay& ray = mRays[handle * FOOTIK_MAX_LEGS + leg];
+        ray.origin = ankle + vec3(0, rig.mRayAbove, 0);
+        ray.direction = vec3(0, -1, 0);
+        ray.length = rig.mRayAbove + rig.mRayBelow;
+    }
+}
+
+void FootIK::CastBatch(JobSystem* jobs)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    unsigned int count = (unsigned int)mInFlightRays.size();
+    mInFlightHits.resize(count);
+    const GroundRay* rays = count > 0 ? &mInFlightRays[0] : 0;
+    GroundHit* hits = count > 0 ? &mInFlightHits[0] : 0;
+    const Ground* ground = mGround;
+
+    auto cast = [rays, hits, count, ground](unsigned int begin, unsigned int end) {
+        unsigned int first = begin * FOOTIK_RAYS_PER_JOB;
+        unsigned int last = end * FOOTIK_RAYS_PER_JOB;
+        if (last > count)
+        {
+            last = count;
+        }
+        ground->Raycast(rays + first, hits + first, last - first);
+        for (unsigned int i = first; i < last; ++i)
+        {
+            if (rays[i].length <= 0.0f)
+            {
+                hits[i] = GroundHit();
+            }
+        }
+    };
+
+    unsigned int chunks = (count + FOOTIK_RAYS_PER_JOB - 1) / FOOTIK_RAYS_PER_JOB;
+    if (ground == 0 || chunks == 0)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            hits[i] = GroundHit();
+        }
+    }
+    else if (jobs != 0)
+    {
+        jobs->ParallelFor(chunks, cast);
+    }
+    else
+    {
+        cast(0, chunks);
+    }
+
+    mStats.querySeconds = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void FootIK::BatchJob(JobSystem& system, Job*, const void* data)
+{
+    const BatchData& batch = *(const BatchData*)data;
+    batch.mFootIK->CastBatch(&system);
+}
+
+void FootIK::Dispatch(JobSystem* jobs)
+{
+    if (mJob != 0)
+    {
+        std::cout << "WARNING: Foot IK dispatched again before Sync\n";
+        Sync();
+    }
+
+    // Take this frame's rays and clear them, so characters that aren't queried
+    // next frame don't cast stale rays
+    mInFlightRays = mRays;
+    mStats.rays = 0;
+    for (unsigned int i = 0, size = (unsigned int)mRays.size(); i < size; ++i)
+    {
+        mStats.rays += mRays[i].length > 0.0f ? 1 : 0;
+        mRays[i].length = 0.0f;
+    }
+
+    mJobSystem = jobs;
+    if (jobs == 0)
+    {
+        CastBatch(0);
+        return;
+    }
+    BatchData batch;
+    batch.mFootIK = this;
+    mJob = jobs->CreateJob(&FootIK::BatchJob, &batch, sizeof(batch));
+    jobs->Run(mJob);
+}
+
+void FootIK::Sync()
+{
+    if (mJob != 0)
+    {
+        mJobSystem->Wait(mJob);
+        mJob = 0;
+    }
+    if (mInFlightHits.empty() && mInFlightRays.empty())
+    {
+        return;
+    }
+
+    std::swap(mHits, mInFlightHits);
+    mInFlightRays.clear();
+    mInFlightHits.clear();
+    mStats.hits = 0;
+    for (unsigned int i = 0, size = (unsigned int)mHits.size(); i < size; ++i)
+    {
+        mStats.hits += mHits[i].hit ? 1 : 0;
+    }
+}
+
+bool FootIK::Solve(unsigned int handle, Pose& pose, const Transform& world)
+{
+    const FootIKRig& rig = mCharacters[handle].mRig;
+    vec3 targets[FOOTIK_MAX_LEGS];
+    const GroundHit* grounds[FOOTIK_MAX_LEGS] = { 0 };
+    float lowest = 0.0f;
+    bool grounded = false;
+
+    for (unsigned int leg = 0; leg < rig.mLegCount; ++leg)
+    {
+        unsigned int slot = handle * FOOTIK_MAX_LEGS + leg;
+        if (slot >= mHits.size() || !mHits[slot].hit || mHits[slot].normal.y < FOOTIK_MIN_GROUND_NORMAL)
+        {
+            continue;
+        }
+        const GroundHit& hit = mHits[slot];
+        vec3 ankle = transformPoint(world, pose.GetGlobalTransform(rig.mLegs[leg].mAnkle).position);
+
+        // Height of the hit's plane under where the ankle is now
+        float height = hit.position.y - (hit.normal.x * (ankle.x - hit.position.x) +
+            hit.normal.z * (ankle.z - hit.position.z)) / hit.normal.y;
+        targets[leg] = vec3(ankle.x, height + rig.mLegs[leg].mAnkleHeight, ankle.z);
+        grounds[leg] = &hit;
+        lowest = fminf(lowest, targets[leg].y - ankle.y);
+        grounded = true;
+    }
+    if (!grounded)
+    {
+        return false;
+    }
+
+    Transform invWorld = inverse(world);
+    float drop = fmaxf(lowest, -rig.mMaxPelvisDrop);
+    if (drop < 0.0f)
+    {
+        vec3 delta = transformVector(invWorld, vec3(0, drop, 0));
+        int parent = pose.GetParent(rig.mPelvis);
+        if (parent >= 0)
+        {
+            delta = transformVector(inverse(pose.GetGlobalTransform((unsigned int)parent)), delta);
+        }
+        Transform pelvis = pose.GetLocalTransform(rig.mPelvis);
+        pelvis.position = pelvis.position + delta;
+        pose.SetLocalTransform(rig.mPelvis, pelvis);
+    }
+
+    vec3 up = normalized(transformVector(invWorld, vec3(0, 1, 0)));
+    for (unsigned int leg = 0; leg < rig.mLegCount; ++leg)
+    {
+        if (grounds[leg] == 0)
+        {
+            continue;
+        }
+        const FootIKLeg& joints = rig.mLegs[leg];
+        SolveTwoBoneIK(pose, joints.mHip, joints.mKnee, joints.mAnkle, transformPoint(invWorld, targets[leg]), joints.mPole);
+
+        if (rig.mAlignFeet)
+        {
+            vec3 normal = normalized(transformVector(invWorld, grounds[leg]->normal));
+            quat ankleRotation = pose.GetGlobalTransform(joints.mAnkle).rotation * fromTo(up, normal);
+            Transform ankle = pose.GetLocalTransform(joints.mAnkle);
+            ankle.rotation = normalized(ankleRotation * inverse(pose.GetGlobalTransform(joints.mKnee).rotation));
+            pose.SetLocalTransform(joints.mAnkle, ankle);
+        }
+    }
+    return true;
+}
+
+const FootIKStats& FootIK::GetStats() const
+{
+    return mStats;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include "GroundQuery.h"
+#include "Pose.h"
+#include "../math/Transform.h"
+
+class JobSystem;
+struct Job;
+
+#define FOOTIK_MAX_LEGS 2
+// Rays per ground query job
+#define FOOTIK_RAYS_PER_JOB 64
+
+struct FootIKLeg
+{
+    unsigned int mHip = 0;
+    unsigned int mKnee = 0;
+    unsigned int mAnkle = 0;
+    // Model space direction the knee bends towards
+    vec3 mPole = vec3(0, 0, 1);
+    // Height of the ankle above the sole
+    float mAnkleHeight = 0.1f;
+};
+
+struct FootIKRig
+{
+    unsigned int mPelvis = 0;
+    unsigned int mLegCount = 2;
+    FootIKLeg mLegs[FOOTIK_MAX_LEGS];
+    // Rays start this far above the ankle and reach this far below it
+    float mRayAbove = 0.5f;
+    float mRayBelow = 0.75f;
+    // Furthest the pelvis is lowered so the lower foot can reach the ground
+    float mMaxPelvisDrop = 0.4f;
+    // Rotate the feet to lie flat on the ground
+    bool mAlignFeet = true;
+};
+
+struct FootIKStats
+{
+    // Last dispatched batch
+    unsigned int rays = 0;
+    unsigned int hits = 0;
+    double querySeconds = 0.0;
+};
+
+// Plants feet on a Ground. All ground queries of a frame go out in one batch:
+// Query collects a ray under each foot of every character, Dispatch casts the
+// batch (spread over the job system when one is given) and Sync waits for it
+// and makes its hits current. Solve then lowers the pelvis so the lower foot
+// can reach, and runs two-bone IK on each leg to the ground.
+//
+// In the same frame: Query all, Dispatch, Sync, Solve all. One frame ahead:
+// Sync, Query all, Solve all (against last frame's hits), then Dispatch and let
+// the batch run while the frame is rendered. Solve uses each foot's current
+// position with the plane of last frame's hit, so small horizontal motion since
+// the query is accounted for.
+//
+// All calls other than the batch itself happen on the thread that owns the
+// JobSystem.
+class FootIK
+{
+private:
+    FootIK(const FootIK&);
+    FootIK& operator=(const FootIK&);
+
+protected:
+    struct Character
+    {
+        FootIKRig mRig;
+        bool mActive = false;
+    };
+
+    struct BatchData
+    {
+        FootIK* mFootIK;
+    };
+
+    const Ground* mGround;
+    std::vector<Character> mCharacters;
+    std::vector<unsigned int> mFree;
+    // Slot handle * FOOTIK_MAX_LEGS + leg. Rays are filled by Query; hits belong
+    // to the last synced batch. A ray of zero length is not cast.
+    std::vector<GroundRay> mRays;
+    std::vector<GroundRay> mInFlightRays;
+    std::vector<GroundHit> mInFlightHits;
+    std::vector<GroundHit> mHits;
+    JobSystem* mJobSystem;
+    Job* mJob;
+    FootIKStats mStats;
+
+    static void BatchJob(JobSystem& system, Job* job, const void* data);
+    void CastBatch(JobSystem* jobs);
+
+public:
+    FootIK();
+    ~FootIK();
+
+    void SetGround(const Ground* ground);
+
+    unsigned int Register(const FootIKRig& rig);
+    void Unregister(unsigned int handle);
+
+    // world places the character's model space in the world
+    void Query(unsigned int handle, const Pose& pose, const Transform& world);
+    void Dispatch(JobSystem* jobs = 0);
+    void Sync();
+    // Returns true if any foot found ground
+    bool Solve(unsigned int handle, Pose& pose, const Transform& world);
+
+    const FootIKStats& GetStats() const;
+};
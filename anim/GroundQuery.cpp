@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+#include "GroundQuery.h"
+#include "../math/simd.h"
+
+// Deeper nodes are not split, so a traversal stack of this size never overflows
+#define GROUNDQUERY_MAX_DEPTH 48
+// Floats per packet: v0, edge1, edge2 as x, y, z of each triangle
+#define GROUNDQUERY_PACKET_FLOATS (9 * GROUNDQUERY_LEAF_TRIANGLES)
+#define GROUNDQUERY_DET_EPSILON 0.0000001f
+
+static_assert(GROUNDQUERY_LEAF_TRIANGLES == 4, "Leaf packets are tested as one SSE register per component");
+
+Heightfield::Heightfield()
+{
+    mWidth = 0;
+    mDepth = 0;
+    mCellSize = 1.0f;
+}
+
+void Heightfield::Set(const float* heights, unsigned int width, unsigned int depth, float cellSize, const vec3& origin)
+{
+    if (width < 2 || depth < 2 || cellSize <= 0.0f)
+    {
+        std::cout << "WARNING: Heightfield needs at least 2x2 samples and a positive cell size\n";
+        return;
+    }
+    mHeights.assign(heights, heights + width * depth);
+    mWidth = width;
+    mDepth = depth;
+    mCellSize = cellSize;
+    mOrigin = origin;
+}
+
+bool Heightfield::Sample(float x, float z, float& outHeight, vec3& outNormal) const
+{
+    if (mHeights.empty())
+    {
+        return false;
+    }
+    float gx = (x - mOrigin.x) / mCellSize;
+    float gz = (z - mOrigin.z) / mCellSize;
+    if (gx < 0.0f || gz < 0.0f || gx > (float)(mWidth - 1) || gz > (float)(mDepth - 1))
+    {
+        return false;
+    }
+
+    unsigned int cx = std::min((unsigned int)gx, mWidth - 2);
+    unsigned int cz = std::min((unsigned int)gz, mDepth - 2);
+    float fx = gx - (float)cx;
+    float fz = gz - (float)cz;
+    const float* row = &mHeights[cz * mWidth + cx];
+    float h00 = row[0];
+    float h10 = row[1];
+    float h01 = row[mWidth];
+    float h11 = row[mWidth + 1];
+
+    // Cells are split along the diagonal from (1, 0) to (0, 1)
+    float slopeX = 0.0f;
+    float slopeZ = 0.0f;
+    if (fx + fz <= 1.0f)
+    {
+        slopeX = h10 - h00;
+        slopeZ = h01 - h00;
+        outHeight = mOrigin.y + h00 + slopeX * fx + slopeZ * fz;
+    }
+    else
+    {
+        slopeX = h11 - h01;
+        slopeZ = h11 - h10;
+        outHeight = mOrigin.y + h11 - slopeX * (1.0f - fx) - slopeZ * (1.0f - fz);
+    }
+    outNormal = normalized(vec3(-slopeX / mCellSize, 1.0f, -slopeZ / mCellSize));
+    return true;
+}
+
+float Heightfield::GetHeight(float x, float z) const
+{
+    float height = mOrigin.y;
+    vec3 normal;
+    Sample(x, z, height, normal);
+    return height;
+}
+
+void Heightfield::Raycast(const GroundRay* rays, GroundHit* outHits, unsigned int count) const
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const GroundRay& ray = rays[i];
+        GroundHit& hit = outHits[i];
+        hit = GroundHit();
+
+        float height = 0.0f;
+        vec3 normal;
+        if (!Sample(ray.origin.x, ray.origin.z, height, normal))
+        {
+            continue;
+        }
+        float distance = ray.origin.y - height;
+        if (distance < 0.0f || distance > ray.length)
+        {
+            continue;
+        }
+        hit.position = vec3(ray.origin.x, height, ray.origin.z);
+        hit.normal = normal;
+        hit.distance = distance;
+        hit.hit = true;
+    }
+}
+
+TriangleBVH::TriangleBVH()
+{
+    mTriangleCount = 0;
+    mDepth = 0;
+}
+
+void TriangleBVH::Build(const vec3* positions, const unsigned int* indices, unsigned int triangleCount)
+{
+    mNodes.clear();
+    mPackets.clear();
+    mTriangleCount = triangleCount;
+    mDepth = 0;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    std::vector<vec3> centroids(triangleCount);
+    std::vector<unsigned int> order(triangleCount);
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        const unsigned int* tri = indices + i * 3;
+        centroids[i] = (positions[tri[0]] + positions[tri[1]] + positions[tri[2]]) * (1.0f / 3.0f);
+        order[i] = i;
+    }
+
+    mNodes.reserve(2 * (triangleCount / GROUNDQUERY_LEAF_TRIANGLES + 1));
+    Build(order, 0, triangleCount, centroids, positions, indices, 1);
+}
+
+unsigned int TriangleBVH::Build(std::vector<unsigned int>& order, unsigned int first, unsigned int count,
+    const std::vector<vec3>& centroids, const vec3* positions, const unsigned int* indices, unsigned int depth)
+{
+    unsigned int index = (unsigned int)mNodes.size();
+    mNodes.push_back(Node());
+    mDepth = std::max(mDepth, depth);
+
+    vec3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    vec3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    vec3 centroidMin = boundsMin;
+    vec3 centroidMax = boundsMax;
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        const unsigned int* tri = indices + order[i] * 3;
+        for (unsigned int corner = 0; corner < 3; ++corner)
+        {
+            const vec3& p = positions[tri[corner]];
+            for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+                boundsMin.v[axis] = fminf(boundsMin.v[axis], p.v[axis]);
+                boundsMax.v[axis] = fmaxf(boundsMax.v[axis], p.v[axis]);
+            }
+        }
+        const vec3& c = centroids[order[i]];
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            centroidMin.v[axis] = fminf(centroidMin.v[axis], c.v[axis]);
+            centroidMax.v[axis] = fmaxf(centroidMax.v[axis], c.v[axis]);
+        }
+    }
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        mNodes[index].mMin[axis] = boundsMin.v[axis];
+        mNodes[index].mMax[axis] = boundsMax.v[axis];
+    }
+
+    if (count <= GROUNDQUERY_LEAF_TRIANGLES || depth >= GROUNDQUERY_MAX_DEPTH)
+    {
+        // Pack the triangles, padding the last packet with degenerate ones that never hit
+        unsigned int packets = (count + GROUNDQUERY_LEAF_TRIANGLES - 1) / GROUNDQUERY_LEAF_TRIANGLES;
+        unsigned int packetStart = (unsigned int)(mPackets.size() / GROUNDQUERY_PACKET_FLOATS);
+        mPackets.resize(mPackets.size() + packets * GROUNDQUERY_PACKET_FLOATS, 0.0f);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const unsigned int* tri = indices + order[first + i] * 3;
+            vec3 v0 = positions[tri[0]];
+            vec3 e1 = positions[tri[1]] - v0;
+            vec3 e2 = positions[tri[2]] - v0;
+            float* packet = &mPackets[(packetStart + i / GROUNDQUERY_LEAF_TRIANGLES) * GROUNDQUERY_PACKET_FLOATS];
+            unsigned int lane = i % GROUNDQUERY_LEAF_TRIANGLES;
+            for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+                packet[axis * 4 + lane] = v0.v[axis];
+                packet[12 + axis * 4 + lane] = e1.v[axis];
+                packet[24 + axis * 4 + lane] = e2.v[axis];
+            }
+        }
+        mNodes[index].mOffset = packetStart;
+        mNodes[index].mCount = packets;
+        return index;
+    }
+
+    // Median split on the axis the centroids spread furthest along
+    unsigned int axis = 0;
+    vec3 extent = centroidMax - centroidMin;
+    if (extent.y > extent.x)
+    {
+        axis = 1;
+    }
+    if (extent.z > extent.v[axis])
+    {
+        axis = 2;
+    }
+    unsigned int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+        [&centroids, axis](unsigned int a, unsigned int b) {
+            return centroids[a].v[axis] < centroids[b].v[axis];
+        });
+
+    Build(order, first, half, centroids, positions, indices, depth + 1);
+    unsigned int right = Build(order, first + half, count - half, centroids, positions, indices, depth + 1);
+    mNodes[index].mOffset = right;
+    mNodes[index].mCount = 0;
+    return index;
+}
+
+void TriangleBVH::RaycastOne(const GroundRay& ray, GroundHit& outHit) const
+{
+    outHit = GroundHit();
+    float closest = ray.length;
+    unsigned int hitPacket = 0;
+    unsigned int hitLane = 0;
+    bool found = false;
+
+    float invDir[3];
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        float d = ray.direction.v[axis];
+        invDir[axis] = fabsf(d) > VEC3_EPSILON ? 1.0f / d : (d < 0.0f ? -FLT_MAX : FLT_MAX);
+    }
+
+#if MATH_SSE
+    const __m128 ox = _mm_set1_ps(ray.origin.x);
+    const __m128 oy = _mm_set1_ps(ray.origin.y);
+    const __m128 oz = _mm_set1_ps(ray.origin.z);
+    const __m128 dx = _mm_set1_ps(ray.direction.x);
+    const __m128 dy = _mm_set1_ps(ray.direction.y);
+    const __m128 dz = _mm_set1_ps(ray.direction.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(GROUNDQUERY_DET_EPSILON);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+#endif
+
+    unsigned int stack[GROUNDQUERY_MAX_DEPTH + 1];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = mNodes[stack[--stackSize]];
+
+        // Slab test against the ray segment found so far
+        float tNear = 0.0f;
+        float tFar = closest;
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (node.mMin[axis] - ray.origin.v[axis]) * invDir[axis];
+            float t1 = (node.mMax[axis] - ray.origin.v[axis]) * invDir[axis];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        if (tNear > tFar)
+        {
+            continue;
+        }
+
+        if (node.mCount == 0)
+        {
+            unsigned int nodeIndex = (unsigned int)(&node - &mNodes[0]);
+            stack[stackSize++] = node.mOffset;
+            stack[stackSize++] = nodeIndex + 1;
+            continue;
+        }
+
+        for (unsigned int p = node.mOffset; p < node.mOffset + node.mCount; ++p)
+        {
+            const float* packet = &mPackets[p * GROUNDQUERY_PACKET_FLOATS];
+#if MATH_SSE
+            // Moller-Trumbore against four triangles at once
+            __m128 e1x = _mm_loadu_ps(packet + 12);
+            __m128 e1y = _mm_loadu_ps(packet + 16);
+            __m128 e1z = _mm_loadu_ps(packet + 20);
+            __m128 e2x = _mm_loadu_ps(packet + 24);
+            __m128 e2y = _mm_loadu_ps(packet + 28);
+            __m128 e2z = _mm_loadu_ps(packet + 32);
+
+            // pvec = direction x edge2
+            __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+            __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+            __m128 valid = _mm_cmpgt_ps(_mm_and_ps(det, absMask), epsilon);
+            if (_mm_movemask_ps(valid) == 0)
+            {
+                continue;
+            }
+            __m128 invDet = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(valid, det), _mm_andnot_ps(valid, one)));
+
+            __m128 tx = _mm_sub_ps(ox, _mm_loadu_ps(packet));
+            __m128 ty = _mm_sub_ps(oy, _mm_loadu_ps(packet + 4));
+            __m128 tz = _mm_sub_ps(oz, _mm_loadu_ps(packet + 8));
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+
+            // qvec = tvec x edge1
+            __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+            __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+            __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+            valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+            valid = _mm_and_ps(valid, _mm_cmpge_ps(t, zero));
+            valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(closest)));
+            int mask = _mm_movemask_ps(valid);
+            if (mask == 0)
+            {
+                continue;
+            }
+
+            float distances[4];
+            _mm_storeu_ps(distances, t);
+            for (unsigned int lane = 0; lane < 4; ++lane)
+            {
+                if ((mask & (1 << lane)) != 0 && distances[lane] < closest)
+                {
+                    closest = distances[lane];
+                    hitPacket = p;
+                    hitLane = lane;
+                    found = true;
+                }
+            }
+#else
+            for (unsigned int lane = 0; lane < 4; ++lane)
+            {
+                vec3 v0(packet[lane], packet[4 + lane], packet[8 + lane]);
+                vec3 e1(packet[12 + lane], packet[16 + lane], packet[20 + lane]);
+                vec3 e2(packet[24 + lane], packet[28 + lane], packet[32 + lane]);
+                vec3 pvec = cross(ray.direction, e2);
+                float det = dot(e1, pvec);
+                if (fabsf(det) <= GROUNDQUERY_DET_EPSILON)
+                {
+                    continue;
+                }
+                float invDet = 1.0f / det;
+                vec3 tvec = ray.origin - v0;
+                float u = dot(tvec, pvec) * invDet;
+                vec3 qvec = cross(tvec, e1);
+                float v = dot(ray.direction, qvec) * invDet;
+                float t = dot(e2, qvec) * invDet;
+                if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < closest)
+                {
+                    closest = t;
+                    hitPacket = p;
+                    hitLane = lane;
+                    found = true;
+                }
+            }
+#endif
+        }
+    }
+
+    if (!found)
+    {
+        return;
+    }
+    const float* packet = &mPackets[hitPacket * GROUNDQUERY_PACKET_FLOATS];
+    vec3 e1(packet[12 + hitLane], packet[16 + hitLane], packet[20 + hitLane]);
+    vec3 e2(packet[24 + hitLane], packet[28 + hitLane], packet[32 + hitLane]);
+    vec3 normal = normalized(cross(e1, e2));
+    if (dot(normal, ray.direction) > 0.0f)
+    {
+        normal = normal * -1.0f;
+    }
+    outHit.position = ray.origin + ray.direction * closest;
+    outHit.normal = normal;
+    outHit.distance = closest;
+    outHit.hit = true;
+}
+
+void TriangleBVH::Raycast(const GroundRay* rays, GroundHit* outHits, unsigned int count) const
+{
+    if (mNodes.empty())
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            outHits[i] = GroundHit();
+        }
+        return;
+    }
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        RaycastOne(rays[i], outHits[i]);
+    }
+}
+
+unsigned int TriangleBVH::GetTriangleCount() const
+{
+    return mTriangleCount;
+}
+
+unsigned int TriangleBVH::GetNodeCount() const
+{
+    return (unsigned int)mNodes.size();
+}
+
+unsigned int TriangleBVH::GetDepth() const
+{
+    return mDepth;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "../math/vec3.h"
+
+// Triangles per BVH leaf, tested together as one SIMD packet
+#define GROUNDQUERY_LEAF_TRIANGLES 4
+
+struct GroundRay
+{
+    vec3 origin;
+    // Unit length
+    vec3 direction = vec3(0, -1, 0);
+    float length = 0.0f;
+};
+
+struct GroundHit
+{
+    vec3 position;
+    // Faces back along the ray
+    vec3 normal = vec3(0, 1, 0);
+    float distance = 0.0f;
+    bool hit = false;
+};
+
+// Something feet can stand on. Queries come in batches so implementations can
+// amortise their setup and keep their data hot across a whole crowd.
+class Ground
+{
+public:
+    virtual ~Ground() = default;
+    // Closest hit along each ray, within its length
+    virtual void Raycast(const GroundRay* rays, GroundHit* outHits, unsigned int count) const = 0;
+};
+
+// Regular grid of heights on the XZ plane, two triangles per cell. Rays are
+// treated as pointing straight down: each one hits the surface under its origin
+// if that lies within its length.
+class Heightfield : public Ground
+{
+protected:
+    std::vector<float> mHeights;
+    unsigned int mWidth;
+    unsigned int mDepth;
+    float mCellSize;
+    vec3 mOrigin;
+
+    // False outside the grid
+    bool Sample(float x, float z, float& outHeight, vec3& outNormal) const;
+
+public:
+    Heightfield();
+
+    // heights holds width * depth samples, row by row along +X; origin is the
+    // position of the first sample
+    void Set(const float* heights, unsigned int width, unsigned int depth, float cellSize, const vec3& origin);
+    float GetHeight(float x, float z) const;
+
+    void Raycast(const GroundRay* rays, GroundHit* outHits, unsigned int count) const override;
+};
+
+// Bounding volume hierarchy over a triangle mesh, built once at load time.
+// Leaves hold GROUNDQUERY_LEAF_TRIANGLES triangles stored structure of arrays,
+// so each ray is tested against a whole leaf at once with SIMD.
+class TriangleBVH : public Ground
+{
+protected:
+    // Interior nodes keep their left child right after them and the index of the
+    // right child in mOffset. Leaves have a non-zero mCount and mOffset is their
+    // first packet.
+    struct Node
+    {
+        float mMin[3];
+        unsigned int mOffset;
+        float mMax[3];
+        unsigned int mCount;
+    };
+
+    std::vector<Node> mNodes;
+    // Per packet: v0, edge1 and edge2, each as x, y, z of every triangle
+    std::vector<float> mPackets;
+    unsigned int mTriangleCount;
+    unsigned int mDepth;
+
+    unsigned int Build(std::vector<unsigned int>& order, unsigned int first, unsigned int count,
+        const std::vector<vec3>& centroids, const vec3* positions, const unsigned int* indices, unsigned int depth);
+    void RaycastOne(const GroundRay& ray, GroundHit& outHit) const;
+
+public:
+    TriangleBVH();
+
+    // indices holds three entries per triangle
+    void Build(const vec3* positions, const unsigned int* indices, unsigned int triangleCount);
+
+    unsigned int GetTriangleCount() const;
+    unsigned int GetNodeCount() const;
+    unsigned int GetDepth() const;
+
+    void Raycast(const GroundRay* rays, GroundHit* outHits, unsigned int count) const override;
+};
@@ -0,0 +1,80 @@
+#include <cmath>
+#include <iostream>
+
+#include "IKSolver.h"
+
+// Any direction not parallel to v, made perpendicular to it
+static vec3 AnyPerpendicular(const vec3& v)
+{
+    vec3 axis = fabsf(v.x) < 0.9f ? vec3(1, 0, 0) : vec3(0, 1, 0);
+    return normalized(reject(axis, v));
+}
+
+bool SolveTwoBoneIK(Pose& pose, unsigned int root, unsigned int mid, unsigned int end, const vec3& target, const vec3& pole)
+{
+    if (pose.GetParent(end) != (int)mid || pose.GetParent(mid) != (int)root)
+    {
+        std::cout << "WARNING: Two bone IK joints " << root << ", " << mid << ", " << end << " are not a chain\n";
+        return false;
+    }
+
+    Transform rootWorld = pose.GetGlobalTransform(root);
+    Transform midLocal = pose.GetLocalTransform(mid);
+    Transform midWorld = combine(rootWorld, midLocal);
+    Transform endWorld = combine(midWorld, pose.GetLocalTransform(end));
+
+    vec3 a = rootWorld.position;
+    vec3 b = midWorld.position;
+    vec3 c = endWorld.position;
+    float lab = len(b - a);
+    float lcb = len(c - b);
+    vec3 toTarget = target - a;
+    float distance = len(toTarget);
+    if (lab < VEC3_EPSILON || lcb < VEC3_EPSILON || distance < VEC3_EPSILON)
+    {
+        return false;
+    }
+
+    bool reachable = distance <= lab + lcb;
+    float lat = reachable ? distance : lab + lcb;
+    vec3 forward = toTarget * (1.0f / distance);
+
+    // Plane the limb bends in, as the direction from the root-target line to the middle joint
+    vec3 bend = reject(pole, forward);
+    if (lenSq(bend) < VEC3_EPSILON)
+    {
+        bend = reject(b - a, forward);
+    }
+    bend = lenSq(bend) < VEC3_EPSILON ? AnyPerpendicular(forward) : normalized(bend);
+
+    // Law of cosines for the angle at the root
+    float cosRoot = (lab * lab + lat * lat - lcb * lcb) / (2.0f * lab * lat);
+    cosRoot = fmaxf(-1.0f, fminf(1.0f, cosRoot));
+    float sinRoot = sqrtf(1.0f - cosRoot * cosRoot);
+    vec3 midTarget = a + (forward * cosRoot + bend * sinRoot) * lab;
+    vec3 endTarget = a + forward * lat;
+
+    // World space swings: the root brings the middle joint into place, then the
+    // middle joint brings the end onto the target
+    quat rootSwing = fromTo(b - a, midTarget - a);
+    vec3 swungEnd = a + rootSwing * (c - a);
+    quat midSwing = fromTo(swungEnd - midTarget, endTarget - midTarget);
+
+    Transform parentWorld;
+    int parent = pose.GetParent(root);
+    if (parent >= 0)
+    {
+        parentWorld = pose.GetGlobalTransform((unsigned int)parent);
+    }
+
+    quat rootRotation = rootWorld.rotation * rootSwing;
+    quat midRotation = midWorld.rotation * rootSwing * midSwing;
+
+    Transform rootLocal = pose.GetLocalTransform(root);
+    rootLocal.rotation = normalized(rootRotation * inverse(parentWorld.rotation));
+    midLocal.rotation = normalized(midRotation * inverse(rootRotation));
+    pose.SetLocalTransform(root, rootLocal);
+    pose.SetLocalTransform(mid, midLocal);
+
+    return reachable;
+}
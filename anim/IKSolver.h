@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Pose.h"
+#include "../math/vec3.h"
+
+// Default iteration limit and goal distance for the iterative solvers
+#define IK_DEFAULT_STEPS 15
+#define IK_DEFAULT_THRESHOLD 0.00001f
+
+struct IKSolveStats
+{
+    // Last solve
+    unsigned int iterations = 0;
+    bool converged = false;
+    double seconds = 0.0;
+};
+
+// Analytic two-bone IK (thigh, knee, ankle or shoulder, elbow, wrist). end must
+// be a child of mid and mid a child of root. The chain bends in the plane of the
+// target and pole, a model space direction the middle joint should point towards
+// (in front of the knee, behind the elbow); a zero pole keeps the current bend
+// plane. Only the local rotations of root and mid change. Returns false when the
+// target is out of reach, in which case the chain points straight at it.
+bool SolveTwoBoneIK(Pose& pose, unsigned int root, unsigned int mid, unsigned int end, const vec3& target, const vec3& pole);
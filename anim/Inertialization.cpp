@@ -0,0 +1,218 @@
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "Inertialization.h"
+
+#define INERTIALIZATION_EPSILON 0.00001f
+
+// Rotation taking b to a, as an axis-angle vector on the short arc
+static vec3 RotationOffset(const quat& a, const quat& b)
+{
+    // b * offset == a, see quat operator* for the order
+    quat offset = inverse(b) * a;
+    if (offset.w < 0.0f)
+    {
+        offset = -offset;
+    }
+    vec3 axis(offset.x, offset.y, offset.z);
+    float sinHalf = len(axis);
+    if (sinHalf < INERTIALIZATION_EPSILON)
+    {
+        return vec3(0, 0, 0);
+    }
+    float angle = 2.0f * atan2f(sinHalf, offset.w);
+    return axis * (angle / sinHalf);
+}
+
+InertialChannel::InertialChannel()
+{
+    mX0 = 0.0f;
+    mV0 = 0.0f;
+    mA0 = 0.0f;
+    mA = 0.0f;
+    mB = 0.0f;
+    mC = 0.0f;
+    mDuration = 0.0f;
+}
+
+void InertialChannel::Set(const vec3& offset, const vec3& previousOffset, float deltaTime, float blendTime)
+{
+    *this = InertialChannel();
+    float x0 = sqrtf(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+    if (x0 < INERTIALIZATION_EPSILON || blendTime <= 0.0f)
+    {
+        return;
+    }
+    mDirection = offset * (1.0f / x0);
+
+    float v0 = 0.0f;
+    if (deltaTime > 0.0f)
+    {
+        v0 = (x0 - dot(previousOffset, mDirection)) / deltaTime;
+    }
+    // An offset that is still growing would overshoot; start it at rest instead
+    if (v0 > 0.0f)
+    {
+        v0 = 0.0f;
+    }
+
+    float t1 = blendTime;
+    if (v0 < 0.0f)
+    {
+        // Shorten the blend so a fast closing velocity cannot push through zero
+        float closing = -5.0f * x0 / v0;
+        if (closing < t1)
+        {
+            t1 = closing;
+        }
+    }
+    float t1Sq = t1 * t1;
+    float a0 = (-8.0f * v0 * t1 - 20.0f * x0) / t1Sq;
+    if (a0 < 0.0f)
+    {
+        a0 = 0.0f;
+    }
+
+    mX0 = x0;
+    mV0 = v0;
+    mA0 = a0;
+    mA = -(a0 * t1Sq + 6.0f * v0 * t1 + 12.0f * x0) / (2.0f * t1Sq * t1Sq * t1);
+    mB = (3.0f * a0 * t1Sq + 16.0f * v0 * t1 + 30.0f * x0) / (2.0f * t1Sq * t1Sq);
+    mC = -(3.0f * a0 * t1Sq + 12.0f * v0 * t1 + 20.0f * x0) / (2.0f * t1Sq * t1);
+    mDuration = t1;
+}
+
+float InertialChannel::Evaluate(float t) const
+{
+    if (t >= mDuration)
+    {
+        return 0.0f;
+    }
+    return (((((mA * t + mB) * t + mC) * t + mA0 * 0.5f) * t + mV0) * t) + mX0;
+}
+
+Inertializer::Inertializer()
+{
+    mLastDeltaTime = 0.0f;
+    mElapsed = 0.0f;
+    mDuration = 0.0f;
+    mHistory = 0;
+    mActive = false;
+}
+
+void Inertializer::Begin(const Pose& target, float blendTime)
+{
+    if (mHistory == 0)
+    {
+        // Nothing has been shown yet, so there is nothing to transition from
+        Cancel();
+        return;
+    }
+    const Pose& previous = mHistory > 1 ? mPreviousOutput : mLastOutput;
+    Begin(mLastOutput, previous, target, mLastDeltaTime, blendTime);
+}
+
+void Inertializer::Begin(const Pose& source, const Pose& previousSource, const Pose& target, float deltaTime, float blendTime)
+{
+    unsigned int size = target.Size();
+    if (source.Size() != size || previousSource.Size() != size)
+    {
+        std::cout << "WARNING: Inertialization source has " << source.Size() << " joints, target has " << size << "\n";
+        Cancel();
+        return;
+    }
+
+    mPositions.resize(size);
+    mRotations.resize(size);
+    mScales.resize(size);
+    mDuration = 0.0f;
+
+    const Transform* src = source.GetLocalTransforms();
+    const Transform* prev = previousSource.GetLocalTransforms();
+    const Transform* dst = target.GetLocalTransforms();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        mPositions[i].Set(src[i].position - dst[i].position, prev[i].position - dst[i].position, deltaTime, blendTime);
+        mRotations[i].Set(RotationOffset(src[i].rotation, dst[i].rotation), RotationOffset(prev[i].rotation, dst[i].rotation), deltaTime, blendTime);
+        mScales[i].Set(src[i].scale - dst[i].scale, prev[i].scale - dst[i].scale, deltaTime, blendTime);
+
+        mDuration = fmaxf(mDuration, fmaxf(mPositions[i].mDuration, fmaxf(mRotations[i].mDuration, mScales[i].mDuration)));
+    }
+
+    mElapsed = 0.0f;
+    mActive = mDuration > 0.0f;
+}
+
+void Inertializer::Cancel()
+{
+    mActive = false;
+    mElapsed = 0.0f;
+    mDuration = 0.0f;
+}
+
+void Inertializer::Apply(Pose& inOutPose, float deltaTime)
+{
+    if (mActive)
+    {
+        mElapsed += deltaTime;
+        if (mElapsed >= mDuration || inOutPose.Size() != mPositions.size())
+        {
+            mActive = false;
+        }
+    }
+
+    if (mActive)
+    {
+        Transform* joints = inOutPose.GetLocalTransforms();
+        float t = mElapsed;
+        for (unsigned int i = 0, size = inOutPose.Size(); i < size; ++i)
+        {
+            const InertialChannel& position = mPositions[i];
+            if (position.mDuration > 0.0f)
+            {
+                joints[i].position = joints[i].position + position.mDirection * position.Evaluate(t);
+            }
+
+            const InertialChannel& rotation = mRotations[i];
+            if (rotation.mDuration > 0.0f)
+            {
+                float angle = rotation.Evaluate(t);
+                if (angle > INERTIALIZATION_EPSILON)
+                {
+                    joints[i].rotation = normalized(joints[i].rotation * angleAxis(angle, rotation.mDirection));
+                }
+            }
+
+            const InertialChannel& scale = mScales[i];
+            if (scale.mDuration > 0.0f)
+            {
+                joints[i].scale = joints[i].scale + scale.mDirection * scale.Evaluate(t);
+            }
+        }
+    }
+
+    // Swap so both history poses keep their allocations
+    std::swap(mPreviousOutput, mLastOutput);
+    mLastOutput = inOutPose;
+    mLastDeltaTime = deltaTime;
+    if (mHistory < 2)
+    {
+        mHistory += 1;
+    }
+}
+
+bool Inertializer::IsActive() const
+{
+    return mActive;
+}
+
+float Inertializer::GetElapsed() const
+{
+    return mElapsed;
+}
+
+float Inertializer::GetDuration() const
+{
+    return mDuration;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include "Pose.h"
+
+// Offset of one channel (position, rotation as axis-angle, or scale) of one
+// joint, decayed to zero along a fixed direction by a quintic polynomial
+struct InertialChannel
+{
+    vec3 mDirection;
+    float mX0;
+    float mV0;
+    float mA0;
+    float mA;
+    float mB;
+    float mC;
+    float mDuration;
+
+    InertialChannel();
+    void Set(const vec3& offset, const vec3& previousOffset, float deltaTime, float blendTime);
+    // Offset magnitude along mDirection at time t after the transition
+    float Evaluate(float t) const;
+};
+
+// Transitions without a crossfade. When the animation switches, the difference
+// between the last pose shown and the new animation's pose (and the rate that
+// difference was changing at) is recorded per joint, then decays to zero with a
+// quintic that matches position, velocity and acceleration at both ends. Only the
+// destination animation is sampled during the transition.
+//
+// Call Apply on the final pose every frame so the last two outputs are known,
+// and Begin with the destination pose on the frame the animation switches.
+class Inertializer
+{
+protected:
+    std::vector<InertialChannel> mPositions;
+    std::vector<InertialChannel> mRotations;
+    std::vector<InertialChannel> mScales;
+    Pose mLastOutput;
+    Pose mPreviousOutput;
+    float mLastDeltaTime;
+    float mElapsed;
+    float mDuration;
+    unsigned int mHistory;
+    bool mActive;
+
+public:
+    Inertializer();
+
+    // Uses the last two poses passed to Apply as the source
+    void Begin(const Pose& target, float blendTime);
+    // source and previousSource are the last two poses shown, deltaTime apart
+    void Begin(const Pose& source, const Pose& previousSource, const Pose& target, float deltaTime, float blendTime);
+    void Cancel();
+
+    // Advances by deltaTime and adds the remaining offset to the freshly sampled
+    // destination pose. Records the result as the latest output.
+    void Apply(Pose& inOutPose, float deltaTime);
+
+    bool IsActive() const;
+    float GetElapsed() const;
+    float GetDuration() const;
+};
@@ -0,0 +1,610 @@
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "MotionDatabase.h"
+#include "../core/JobSystem.h"
+#include "../math/simd.h"
+
+// Queries are normalized on the stack, so feature vectors are capped
+#define MOTIONDB_MAX_DIMENSIONS 128
+// Deeper nodes are not split, so a traversal stack of this size never overflows
+#define MOTIONDB_MAX_DEPTH 48
+// Padding frames of the brute force rows, far enough away to never match
+#define MOTIONDB_PADDING 1.0e15f
+// Queries per job of a batch
+#define MOTIONDB_QUERIES_PER_JOB 4
+
+namespace
+{
+    // Character space: the root's position on the floor and its facing about +Y
+    Transform GroundFrame(const Transform& root)
+    {
+        Transform result;
+        result.position = vec3(root.position.x, 0.0f, root.position.z);
+        vec3 forward = root.rotation * vec3(0, 0, 1);
+        if (forward.x * forward.x + forward.z * forward.z > VEC3_EPSILON)
+        {
+            result.rotation = angleAxis(atan2f(forward.x, forward.z), vec3(0, 1, 0));
+        }
+        return result;
+    }
+
+    float RowDistance(const float* a, const float* b, unsigned int stride)
+    {
+#if MATH_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned int d = 0; d < stride; d += 4)
+        {
+            __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + d), _mm_loadu_ps(b + d));
+            sum = _mm_add_ps(sum, _mm_mul_ps(diff, diff));
+        }
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+#else
+        float sum = 0.0f;
+        for (unsigned int d = 0; d < stride; ++d)
+        {
+            float diff = a[d] - b[d];
+            sum += diff * diff;
+        }
+        return sum;
+#endif
+    }
+}
+
+MotionDatabase::MotionDatabase()
+{
+    mDimensions = 0;
+    mStride = 0;
+    mClipCount = 0;
+    mRowStride = 0;
+    mDepth = 0;
+    SetConfig(MotionFeatureConfig());
+}
+
+void MotionDatabase::SetConfig(const MotionFeatureConfig& config)
+{
+    mConfig = config;
+    if (mConfig.mTrajectoryCount > MOTIONDB_MAX_TRAJECTORY)
+    {
+        std::cout << "WARNING: Motion database supports " << MOTIONDB_MAX_TRAJECTORY << " trajectory times\n";
+        mConfig.mTrajectoryCount = MOTIONDB_MAX_TRAJECTORY;
+    }
+    unsigned int maxBones = (MOTIONDB_MAX_DIMENSIONS - mConfig.mTrajectoryCount * 6) / 6;
+    if (mConfig.mBones.size() > maxBones)
+    {
+        std::cout << "WARNING: Motion database supports " << maxBones << " feature bones, config has " << mConfig.mBones.size() << "\n";
+        mConfig.mBones.resize(maxBones);
+    }
+
+    mDimensions = ((unsigned int)mConfig.mBones.size() + mConfig.mTrajectoryCount) * 6;
+    mStride = (mDimensions + 3) & ~3u;
+    mClipCount = 0;
+    mRaw.clear();
+    mFrames.clear();
+    mMean.clear();
+    mScale.clear();
+    mFeatures.clear();
+    mRowStride = 0;
+    mNodes.clear();
+    mBounds.clear();
+    mTreeFeatures.clear();
+    mTreeFrames.clear();
+    mDepth = 0;
+}
+
+void MotionDatabase::AddFrame(const Transform* globals, const Transform& toCharacter,
+    const Transform* neighbourGlobals, const Transform& neighbourToCharacter, float invDeltaTime, const Transform* trajectory)
+{
+    unsigned int boneCount = (unsigned int)mConfig.mBones.size();
+    unsigned int first = (unsigned int)mRaw.size();
+    mRaw.resize(first + mDimensions);
+    float* positions = &mRaw[first];
+    float* velocities = positions + boneCount * 3;
+    float* trajectoryPositions = velocities + boneCount * 3;
+    float* trajectoryDirections = trajectoryPositions + mConfig.mTrajectoryCount * 3;
+
+    for (unsigned int i = 0; i < boneCount; ++i)
+    {
+        unsigned int bone = mConfig.mBones[i];
+        vec3 position = transformPoint(toCharacter, globals[bone].position);
+        vec3 neighbour = transformPoint(neighbourToCharacter, neighbourGlobals[bone].position);
+        vec3 velocity = (neighbour - position) * invDeltaTime;
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            positions[i * 3 + c] = position.v[c];
+            velocities[i * 3 + c] = velocity.v[c];
+        }
+    }
+    for (unsigned int i = 0; i < mConfig.mTrajectoryCount; ++i)
+    {
+        vec3 direction = trajectory[i].rotation * vec3(0, 0, 1);
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            trajectoryPositions[i * 3 + c] = trajectory[i].position.v[c];
+            trajectoryDirections[i * 3 + c] = direction.v[c];
+        }
+    }
+}
+
+unsigned int MotionDatabase::AddClip(const BakedClip& clip, const Pose& restPose, const RootMotion* rootMotion)
+{
+    if (mConfig.mRoot >= restPose.Size())
+    {
+        std::cout << "WARNING: Motion database root " << mConfig.mRoot << " is not in the pose\n";
+        return mClipCount;
+    }
+    for (unsigned int i = 0, size = (unsigned int)mConfig.mBones.size(); i < size; ++i)
+    {
+        if (mConfig.mBones[i] >= restPose.Size())
+        {
+            std::cout << "WARNING: Motion database bone " << mConfig.mBones[i] << " is not in the pose\n";
+            return mClipCount;
+        }
+    }
+    if (clip.GetFrameCount() < 2)
+    {
+        std::cout << "WARNING: Motion database clip " << clip.GetName() << " needs at least two frames\n";
+        return mClipCount;
+    }
+
+    unsigned int clipIndex = mClipCount++;
+    unsigned int jointCount = restPose.Size();
+    Pose pose = restPose;
+    std::vector<Transform> globals(jointCount);
+    std::vector<Transform> neighbourGlobals(jointCount);
+    Transform trajectory[MOTIONDB_MAX_TRAJECTORY];
+    float frameTime = clip.GetFrameTime();
+    float endTime = clip.GetEndTime();
+
+    for (unsigned int frame = 0, count = clip.GetFrameCount(); frame < count; ++frame)
+    {
+        float time = clip.GetStartTime() + frame * frameTime;
+        // Velocities are differenced with the next frame, or with the previous
+        // one at the end of the clip unless root motion carries it across the loop
+        float neighbour = time + frameTime;
+        float invDeltaTime = 1.0f / frameTime;
+        bool wraps = clip.GetLooping() && rootMotion != 0;
+        if (!wraps && neighbour > endTime + frameTime * 0.5f)
+        {
+            neighbour = time - frameTime;
+            invDeltaTime = -invDeltaTime;
+        }
+        clip.Sample(pose, time);
+        pose.GetGlobalTransforms(&globals[0]);
+        clip.Sample(pose, neighbour);
+        pose.GetGlobalTransforms(&neighbourGlobals[0]);
+
+        Transform toCharacter;
+        Transform neighbourToCharacter;
+        if (rootMotion != 0)
+        {
+            // The clip already plays in character space; the neighbour's ground
+            // frame is placed relative to this one by the extracted motion
+            neighbourToCharacter = rootMotion->GetDelta(time, neighbour - time);
+            for (unsigned int i = 0; i < mConfig.mTrajectoryCount; ++i)
+            {
+                trajectory[i] = rootMotion->GetDelta(time, mConfig.mTrajectoryTimes[i]);
+            }
+        }
+        else
+        {
+            toCharacter = inverse(GroundFrame(globals[mConfig.mRoot]));
+            neighbourToCharacter = toCharacter;
+            for (unsigned int i = 0; i < mConfig.mTrajectoryCount; ++i)
+            {
+                // Without root motion a looping clip's root jumps back at the end,
+                // so future times stop there instead
+                clip.Sample(pose, std::min(time + mConfig.mTrajectoryTimes[i], endTime));
+                trajectory[i] = combine(toCharacter, GroundFrame(pose.GetGlobalTransform(mConfig.mRoot)));
+            }
+        }
+
+        AddFrame(&globals[0], toCharacter, &neighbourGlobals[0], neighbourToCharacter, invDeltaTime, trajectory);
+        FrameSource source;
+        source.mClip = clipIndex;
+        source.mTime = time;
+        mFrames.push_back(source);
+    }
+    return clipIndex;
+}
+
+void MotionDatabase::Build()
+{
+    unsigned int frameCount = (unsigned int)mFrames.size();
+    unsigned int boneCount = (unsigned int)mConfig.mBones.size();
+    mMean.assign(mStride, 0.0f);
+    mScale.assign(mStride, 0.0f);
+    mFeatures.clear();
+    mNodes.clear();
+    mBounds.clear();
+    mTreeFeatures.clear();
+    mTreeFrames.clear();
+    mDepth = 0;
+    if (frameCount == 0)
+    {
+        return;
+    }
+
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        for (unsigned int d = 0; d < mDimensions; ++d)
+        {
+            mMean[d] += mRaw[frame * mDimensions + d];
+        }
+    }
+    for (unsigned int d = 0; d < mDimensions; ++d)
+    {
+        mMean[d] /= (float)frameCount;
+    }
+
+    // One scale per group, from the group's average variance, so the components
+    // of a vec3 keep their relative size
+    unsigned int groupEnds[4] = { boneCount * 3, boneCount * 6, boneCount * 6 + mConfig.mTrajectoryCount * 3, mDimensions };
+    float groupWeights[4] = { mConfig.mPositionWeight, mConfig.mVelocityWeight,
+        mConfig.mTrajectoryPositionWeight, mConfig.mTrajectoryDirectionWeight };
+    unsigned int groupStart = 0;
+    for (unsigned int group = 0; group < 4; ++group)
+    {
+        unsigned int groupEnd = groupEnds[group];
+        if (groupEnd == groupStart)
+        {
+            continue;
+        }
+        double variance = 0.0;
+        for (unsigned int frame = 0; frame < frameCount; ++frame)
+        {
+            for (unsigned int d = groupStart; d < groupEnd; ++d)
+            {
+                double diff = mRaw[frame * mDimensions + d] - mMean[d];
+                variance += diff * diff;
+            }
+        }
+        float deviation = (float)sqrt(variance / ((double)frameCount * (groupEnd - groupStart)));
+        float scale = deviation > VEC3_EPSILON ? groupWeights[group] / deviation : groupWeights[group];
+        for (unsigned int d = groupStart; d < groupEnd; ++d)
+        {
+            mScale[d] = scale;
+        }
+        groupStart = groupEnd;
+    }
+
+    // Rows of every frame for brute force
+    mRowStride = (frameCount + 3) & ~3u;
+    mFeatures.assign(mDimensions * mRowStride, MOTIONDB_PADDING);
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        for (unsigned int d = 0; d < mDimensions; ++d)
+        {
+            mFeatures[d * mRowStride + frame] = (mRaw[frame * mDimensions + d] - mMean[d]) * mScale[d];
+        }
+    }
+
+    std::vector<unsigned int> order(frameCount);
+    for (unsigned int frame = 0; frame < frameCount; ++frame)
+    {
+        order[frame] = frame;
+    }
+    mTreeFeatures.reserve(frameCount * mStride);
+    mTreeFrames.reserve(frameCount);
+    BuildTree(order, 0, frameCount, 0);
+}
+
+unsigned int MotionDatabase::BuildTree(std::vector<unsigned int>& order, unsigned int first, unsigned int count, unsigned int depth)
+{
+    unsigned int index = (unsigned int)mNodes.size();
+    mNodes.push_back(Node());
+    mBounds.resize(mBounds.size() + mStride * 2, 0.0f);
+    mDepth = std::max(mDepth, depth);
+
+    // Bound the node, and split the dimension with the widest spread at its median
+    unsigned int dimension = 0;
+    float widest = 0.0f;
+    for (unsigned int d = 0; d < mDimensions; ++d)
+    {
+        const float* row = &mFeatures[d * mRowStride];
+        float lo = row[order[first]];
+        float hi = lo;
+        for (unsigned int i = first + 1; i < first + count; ++i)
+        {
+            lo = std::min(lo, row[order[i]]);
+            hi = std::max(hi, row[order[i]]);
+        }
+        mBounds[index * mStride * 2 + d] = lo;
+        mBounds[index * mStride * 2 + mStride + d] = hi;
+        if (hi - lo > widest)
+        {
+            widest = hi - lo;
+            dimension = d;
+        }
+    }
+
+    if (count <= MOTIONDB_LEAF_FRAMES || depth >= MOTIONDB_MAX_DEPTH || widest <= 0.0f)
+    {
+        Node& leaf = mNodes[index];
+        leaf.mOffset = (unsigned int)mTreeFrames.size();
+        leaf.mCount = count;
+        for (unsigned int i = first; i < first + count; ++i)
+        {
+            unsigned int frame = order[i];
+            mTreeFrames.push_back(frame);
+            for (unsigned int d = 0; d < mStride; ++d)
+            {
+                mTreeFeatures.push_back(d < mDimensions ? mFeatures[d * mRowStride + frame] : 0.0f);
+            }
+        }
+        return index;
+    }
+
+    const float* row = &mFeatures[dimension * mRowStride];
+    unsigned int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+        [row](unsigned int a, unsigned int b) { return row[a] < row[b]; });
+
+    BuildTree(order, first, half, depth + 1);
+    unsigned int right = BuildTree(order, first + half, count - half, depth + 1);
+    Node& node = mNodes[index];
+    node.mOffset = right;
+    node.mCount = 0;
+    return index;
+}
+
+void MotionDatabase::Normalize(const float* query, float* outNormalized) const
+{
+    for (unsigned int d = 0; d < mStride; ++d)
+    {
+        outNormalized[d] = d < mDimensions ? (query[d] - mMean[d]) * mScale[d] : 0.0f;
+    }
+}
+
+void MotionDatabase::SearchBruteForce(const float* normalized, MotionMatch& outMatch) const
+{
+    float best = FLT_MAX;
+    unsigned int bestFrame = 0;
+#if MATH_SSE
+    __m128 best4 = _mm_set1_ps(FLT_MAX);
+    for (unsigned int frame = 0; frame < mRowStride; frame += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        const float* row = &mFeatures[frame];
+        unsigned int d = 0;
+        for (; d < mDimensions; ++d, row += mRowStride)
+        {
+            __m128 diff = _mm_sub_ps(_mm_loadu_ps(row), _mm_set1_ps(normalized[d]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(diff, diff));
+            // Costs only grow, so stop once none of the four can win
+            if ((d & 3) == 3 && _mm_movemask_ps(_mm_cmplt_ps(sum, best4)) == 0)
+            {
+                break;
+            }
+        }
+        if (d < mDimensions)
+        {
+            continue;
+        }
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(sum, best4));
+        if (mask == 0)
+        {
+            continue;
+        }
+        float costs[4];
+        _mm_storeu_ps(costs, sum);
+        for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+            if ((mask & (1 << lane)) != 0 && costs[lane] < best)
+            {
+                best = costs[lane];
+                bestFrame = frame + lane;
+            }
+        }
+        best4 = _mm_set1_ps(best);
+    }
+#else
+    for (unsigned int frame = 0, count = (unsigned int)mFrames.size(); frame < count; ++frame)
+    {
+        float sum = 0.0f;
+        for (unsigned int d = 0; d < mDimensions && sum < best; ++d)
+        {
+            float diff = mFeatures[d * mRowStride + frame] - normalized[d];
+            sum += diff * diff;
+        }
+        if (sum < best)
+        {
+            best = sum;
+            bestFrame = frame;
+        }
+    }
+#endif
+    outMatch.mFrame = bestFrame;
+    outMatch.mCost = best;
+}
+
+float MotionDatabase::BoundsDistance(unsigned int node, const float* normalized) const
+{
+    const float* lo = &mBounds[node * mStride * 2];
+    const float* hi = lo + mStride;
+#if MATH_SSE
+    __m128 zero = _mm_setzero_ps();
+    __m128 sum = zero;
+    for (unsigned int d = 0; d < mStride; d += 4)
+    {
+        __m128 q = _mm_loadu_ps(normalized + d);
+        __m128 outside = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(lo + d), q), _mm_sub_ps(q, _mm_loadu_ps(hi + d)));
+        outside = _mm_max_ps(outside, zero);
+        sum = _mm_add_ps(sum, _mm_mul_ps(outside, outside));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0.0f;
+    for (unsigned int d = 0; d < mStride; ++d)
+    {
+        float outside = std::max(std::max(lo[d] - normalized[d], normalized[d] - hi[d]), 0.0f);
+        sum += outside * outside;
+    }
+    return sum;
+#endif
+}
+
+void MotionDatabase::SearchTree(const float* normalized, MotionMatch& outMatch) const
+{
+    struct Entry
+    {
+        unsigned int mNode;
+        // No frame below the node is closer than this
+        float mBound;
+    };
+    Entry stack[MOTIONDB_MAX_DEPTH + 2];
+    unsigned int stackSize = 0;
+    stack[stackSize].mNode = 0;
+    stack[stackSize++].mBound = BoundsDistance(0, normalized);
+
+    float best = FLT_MAX;
+    unsigned int bestFrame = 0;
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        if (entry.mBound >= best)
+        {
+            continue;
+        }
+        const Node& node = mNodes[entry.mNode];
+        if (node.mCount > 0)
+        {
+            const float* row = &mTreeFeatures[node.mOffset * mStride];
+            for (unsigned int i = 0; i < node.mCount; ++i, row += mStride)
+            {
+                float cost = RowDistance(row, normalized, mStride);
+                if (cost < best)
+                {
+                    best = cost;
+                    bestFrame = mTreeFrames[node.mOffset + i];
+                }
+            }
+            continue;
+        }
+
+        // Nearer child last, so it is searched first and tightens best for the other
+        unsigned int children[2] = { entry.mNode + 1, node.mOffset };
+        float bounds[2] = { BoundsDistance(children[0], normalized), BoundsDistance(children[1], normalized) };
+        unsigned int nearer = bounds[1] < bounds[0] ? 1 : 0;
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            unsigned int child = i == 0 ? 1 - nearer : nearer;
+            if (bounds[child] < best)
+            {
+                stack[stackSize].mNode = children[child];
+                stack[stackSize++].mBound = bounds[child];
+            }
+        }
+    }
+    outMatch.mFrame = bestFrame;
+    outMatch.mCost = best;
+}
+
+MotionMatch MotionDatabase::Search(const float* query, MotionSearch method) const
+{
+    MotionMatch result;
+    if (mFeatures.empty())
+    {
+        return result;
+    }
+    float normalized[MOTIONDB_MAX_DIMENSIONS];
+    Normalize(query, normalized);
+    if (method == MotionSearch::BruteForce)
+    {
+        SearchBruteForce(normalized, result);
+    }
+    else
+    {
+        SearchTree(normalized, result);
+    }
+    result.mClip = mFrames[result.mFrame].mClip;
+    result.mTime = mFrames[result.mFrame].mTime;
+    return result;
+}
+
+void MotionDatabase::SearchBatch(const float* queries, unsigned int count, MotionMatch* outMatches,
+    MotionSearch method, JobSystem* jobs)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    unsigned int dimensions = mDimensions;
+    const MotionDatabase* database = this;
+    auto search = [database, queries, outMatches, dimensions, method](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            outMatches[i] = database->Search(queries + i * dimensions, method);
+        }
+    };
+    if (jobs != 0)
+    {
+        jobs->ParallelFor(count, search, MOTIONDB_QUERIES_PER_JOB);
+    }
+    else
+    {
+        search(0, count);
+    }
+
+    mStats.queries = count;
+    mStats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void MotionDatabase::GetFrameFeatures(unsigned int frame, float* outFeatures) const
+{
+    for (unsigned int d = 0; d < mDimensions; ++d)
+    {
+        outFeatures[d] = mRaw[frame * mDimensions + d];
+    }
+}
+
+void MotionDatabase::SetQueryTrajectory(float* query, const vec3* positions, const vec3* directions) const
+{
+    float* trajectoryPositions = query + mConfig.mBones.size() * 6;
+    float* trajectoryDirections = trajectoryPositions + mConfig.mTrajectoryCount * 3;
+    for (unsigned int i = 0; i < mConfig.mTrajectoryCount; ++i)
+    {
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            trajectoryPositions[i * 3 + c] = positions[i].v[c];
+            trajectoryDirections[i * 3 + c] = directions[i].v[c];
+        }
+    }
+}
+
+unsigned int MotionDatabase::GetDimensions() const
+{
+    return mDimensions;
+}
+
+unsigned int MotionDatabase::GetFrameCount() const
+{
+    return (unsigned int)mFrames.size();
+}
+
+unsigned int MotionDatabase::GetNodeCount() const
+{
+    return (unsigned int)mNodes.size();
+}
+
+unsigned int MotionDatabase::GetDepth() const
+{
+    return mDepth;
+}
+
+unsigned int MotionDatabase::GetMemoryBytes() const
+{
+    return (unsigned int)(sizeof(float) * (mRaw.size() + mMean.size() + mScale.size() + mFeatures.size() + mBounds.size() + mTreeFeatures.size()) +
+        sizeof(FrameSource) * mFrames.size() + sizeof(Node) * mNodes.size() + sizeof(unsigned int) * mTreeFrames.size());
+}
+
+const MotionSearchStats& MotionDatabase::GetStats() const
+{
+    return mStats;
+}
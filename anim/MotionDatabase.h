@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include "BakedClip.h"
+#include "Pose.h"
+#include "RootMotion.h"
+
+class JobSystem;
+
+// Frames a KD-tree leaf holds before it is split
+#define MOTIONDB_LEAF_FRAMES 16
+#define MOTIONDB_MAX_TRAJECTORY 4
+
+enum class MotionSearch
+{
+    BruteForce,
+    KDTree
+};
+
+// What a frame is matched on. Features are in the character's ground frame (root
+// on the floor, facing its forward): for each bone its position and velocity, and
+// for each trajectory time the future root position and facing direction. Each
+// group is normalized by its spread and scaled by its weight.
+struct MotionFeatureConfig
+{
+    std::vector<unsigned int> mBones;
+    float mTrajectoryTimes[MOTIONDB_MAX_TRAJECTORY] = { 0.33f, 0.67f, 1.0f, 0.0f };
+    unsigned int mTrajectoryCount = 3;
+    // Root joint, used for the ground frame of clips without root motion
+    unsigned int mRoot = 0;
+    float mPositionWeight = 1.0f;
+    float mVelocityWeight = 1.0f;
+    float mTrajectoryPositionWeight = 1.0f;
+    float mTrajectoryDirectionWeight = 1.5f;
+};
+
+struct MotionMatch
+{
+    unsigned int mFrame = 0;
+    unsigned int mClip = 0;
+    float mTime = 0.0f;
+    // Squared distance in normalized feature space
+    float mCost = 0.0f;
+};
+
+struct MotionSearchStats
+{
+    // Last SearchBatch
+    unsigned int queries = 0;
+    double seconds = 0.0;
+
+    double GetSecondsPerQuery() const { return queries > 0 ? seconds / queries : 0.0; }
+};
+
+// Feature vectors of every frame of a set of clips, built at load time, and
+// nearest neighbour search over them for motion matching.
+//
+// Features are stored normalized, structure of arrays (one row of all frames per
+// feature dimension), so brute force compares four frames per SSE instruction
+// and gives up on a group of four as soon as none can beat the best so far. A
+// KD-tree over the same features keeps the bounding box of every node and a copy
+// of each frame's vector next to the others in its leaf. It skips any node whose
+// box is further than the best match so far. With queries near the data, as in
+// motion matching, it typically tests a small fraction of the frames.
+//
+// A query is a raw (not normalized) feature vector: usually the bone features
+// of the frame playing now (GetFrameFeatures) with the trajectory replaced by the
+// one the character wants (SetQueryTrajectory).
+class MotionDatabase
+{
+private:
+    MotionDatabase(const MotionDatabase&);
+    MotionDatabase& operator=(const MotionDatabase&);
+
+protected:
+    // Interior nodes keep their left child right after them and the index of the
+    // right child in mOffset. Leaves have a non-zero mCount and mOffset is their
+    // first row in mTreeFeatures.
+    struct Node
+    {
+        unsigned int mOffset;
+        unsigned int mCount;
+    };
+
+    struct FrameSource
+    {
+        unsigned int mClip;
+        float mTime;
+    };
+
+    MotionFeatureConfig mConfig;
+    unsigned int mDimensions;
+    // Dimensions rounded up to a multiple of four
+    unsigned int mStride;
+    unsigned int mClipCount;
+    // Raw features per frame, mDimensions each, as added
+    std::vector<float> mRaw;
+    std::vector<FrameSource> mFrames;
+    std::vector<float> mMean;
+    std::vector<float> mScale;
+    // Normalized, dimension by dimension; each row is padded to a multiple of four frames
+    std::vector<float> mFeatures;
+    unsigned int mRowStride;
+    std::vector<Node> mNodes;
+    // Per node, the bounds of its frames: mStride minimums, then mStride maximums
+    std::vector<float> mBounds;
+    // Normalized, frame by frame in leaf order, mStride floats each
+    std::vector<float> mTreeFeatures;
+    std::vector<unsigned int> mTreeFrames;
+    unsigned int mDepth;
+    MotionSearchStats mStats;
+
+    // Transforms place each pose's model space in the character's ground frame at
+    // this frame. invDeltaTime is negative when the neighbour is the previous frame.
+    void AddFrame(const Transform* globals, const Transform& toCharacter, const Transform* neighbourGlobals,
+        const Transform& neighbourToCharacter, float invDeltaTime, const Transform* trajectory);
+    unsigned int BuildTree(std::vector<unsigned int>& order, unsigned int first, unsigned int count, unsigned int depth);
+    void Normalize(const float* query, float* outNormalized) const;
+    void SearchBruteForce(const float* normalized, MotionMatch& outMatch) const;
+    float BoundsDistance(unsigned int node, const float* normalized) const;
+    void SearchTree(const float* normalized, MotionMatch& outMatch) const;
+
+public:
+    MotionDatabase();
+
+    // Before adding clips. Clears the database.
+    void SetConfig(const MotionFeatureConfig& config);
+    // Adds every baked frame of clip. rootMotion is the clip's extracted root
+    // motion when it has one (the clip then plays in character space); it also lets
+    // trajectories of looping clips wrap. Returns the clip's index in matches.
+    unsigned int AddClip(const BakedClip& clip, const Pose& restPose, const RootMotion* rootMotion = 0);
+    // After the last clip: normalizes the features and builds the search tree
+    void Build();
+
+    // Raw features of a frame, GetDimensions floats
+    void GetFrameFeatures(unsigned int frame, float* outFeatures) const;
+    // Overwrites the trajectory part of a query. Positions and directions are in
+    // the character's ground frame, one per configured trajectory time.
+    void SetQueryTrajectory(float* query, const vec3* positions, const vec3* directions) const;
+
+    MotionMatch Search(const float* query, MotionSearch method = MotionSearch::KDTree) const;
+    // count queries of GetDimensions floats each, spread over the job system when
+    // one is given
+    void SearchBatch(const float* queries, unsigned int count, MotionMatch* outMatches,
+        MotionSearch method = MotionSearch::KDTree, JobSystem* jobs = 0);
+
+    unsigned int GetDimensions() const;
+    unsigned int GetFrameCount() const;
+    unsigned int GetNodeCount() const;
+    unsigned int GetDepth() const;
+    unsigned int GetMemoryBytes() const;
+    const MotionSearchStats& GetStats() const;
+};
@@ -0,0 +1,150 @@
+#include "Pose.h"
+
+Pose::Pose()
+{
+}
+
+Pose::Pose(unsigned int numJoints)
+{
+    Resize(numJoints);
+}
+
+void Pose::Resize(unsigned int size)
+{
+    mParents.resize(size, -1);
+    mJoints.resize(size);
+}
+
+unsigned int Pose::Size() const
+{
+    return (unsigned int)mJoints.size();
+}
+
+int Pose::GetParent(unsigned int index) const
+{
+    return mParents[index];
+}
+
+void Pose::SetParent(unsigned int index, int parent)
+{
+    mParents[index] = parent;
+}
+
+Transform Pose::GetLocalTransform(unsigned int index) const
+{
+    return mJoints[index];
+}
+
+void Pose::SetLocalTransform(unsigned int index, const Transform& transform)
+{
+    mJoints[index] = transform;
+}
+
+Transform Pose::GetGlobalTransform(unsigned int index) const
+{
+    Transform result = mJoints[index];
+    for (int parent = mParents[index]; parent >= 0; parent = mParents[parent])
+    {
+        result = combine(mJoints[parent], result);
+    }
+    return result;
+}
+
+Transform Pose::operator[](unsigned int index) const
+{
+    return GetGlobalTransform(index);
+}
+
+void Pose::GetGlobalTransforms(Transform* out) const
+{
+    unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        int parent = mParents[i];
+        if (parent < 0)
+        {
+            out[i] = mJoints[i];
+        }
+        else
+        {
+            out[i] = combine(out[parent], mJoints[i]);
+        }
+    }
+}
+
+void Pose::GetMatrixPalette(std::vector<mat4>& out) const
+{
+    out.resize(Size());
+    if (!out.empty())
+    {
+        GetMatrixPalette(&out[0]);
+    }
+}
+
+void Pose::GetMatrixPalette(mat4* out) const
+{
+    unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        int parent = mParents[i];
+        mat4 local = transformToMat4(mJoints[i]);
+        if (parent < 0)
+        {
+            out[i] = local;
+        }
+        else
+        {
+            out[i] = out[parent] * local;
+        }
+    }
+}
+
+bool Pose::IsTopologicallySorted() const
+{
+    unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (mParents[i] >= (int)i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Transform* Pose::GetLocalTransforms()
+{
+    return mJoints.empty() ? 0 : &mJoints[0];
+}
+
+const Transform* Pose::GetLocalTransforms() const
+{
+    return mJoints.empty() ? 0 : &mJoints[0];
+}
+
+const int* Pose::GetParents() const
+{
+    return mParents.empty() ? 0 : &mParents[0];
+}
+
+bool Pose::operator==(const Pose& other) const
+{
+    if (mJoints.size() != other.mJoints.size())
+    {
+        return false;
+    }
+    unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (mParents[i] != other.mParents[i] || mJoints[i] != other.mJoints[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Pose::operator!=(const Pose& other) const
+{
+    return !(*this == other);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include "../math/Transform.h"
+#include "../math/mat4.h"
+
+// Local joint transforms and parent indices as two flat arrays. Parents are kept
+// topologically sorted (every parent index is lower than its child's), so global
+// transforms and matrix palettes are one forward pass with no recursion and no
+// per-joint walk up the hierarchy. Skeleton::Set establishes the order.
+class Pose
+{
+protected:
+    std::vector<Transform> mJoints;
+    std::vector<int> mParents;
+
+public:
+    Pose();
+    Pose(unsigned int numJoints);
+    void Resize(unsigned int size);
+    unsigned int Size() const;
+
+    int GetParent(unsigned int index) const;
+    void SetParent(unsigned int index, int parent);
+    Transform GetLocalTransform(unsigned int index) const;
+    void SetLocalTransform(unsigned int index, const Transform& transform);
+    // Walks up the hierarchy. Use GetGlobalTransforms for more than a few joints.
+    Transform GetGlobalTransform(unsigned int index) const;
+    Transform operator[](unsigned int index) const;
+
+    // Single forward pass, out must hold Size() transforms
+    void GetGlobalTransforms(Transform* out) const;
+    void GetMatrixPalette(std::vector<mat4>& out) const;
+    void GetMatrixPalette(mat4* out) const;
+    bool IsTopologicallySorted() const;
+
+    Transform* GetLocalTransforms();
+    const Transform* GetLocalTransforms() const;
+    const int* GetParents() const;
+
+    bool operator==(const Pose& other) const;
+    bool operator!=(const Pose& other) const;
+};
@@ -0,0 +1,154 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "PoseCache.h"
+
+bool PoseCache::Key::operator==(const Key& other) const
+{
+    // Times are compared bitwise; they are all produced by Quantize
+    return mClip == other.mClip && mRestPose == other.mRestPose &&
+        memcmp(&mTime, &other.mTime, sizeof(float)) == 0;
+}
+
+size_t PoseCache::KeyHash::operator()(const Key& key) const
+{
+    unsigned int timeBits = 0;
+    memcpy(&timeBits, &key.mTime, sizeof(float));
+    size_t hash = (size_t)key.mClip;
+    hash = hash * 31 + (size_t)key.mRestPose;
+    hash = hash * 31 + (size_t)timeBits * 2654435761u;
+    return hash;
+}
+
+PoseCache::PoseCache()
+{
+    mUsed = 0;
+    float steps[ANIMLOD_BUCKET_COUNT] = POSECACHE_DEFAULT_STEPS;
+    for (unsigned int i = 0; i < ANIMLOD_BUCKET_COUNT; ++i)
+    {
+        mSteps[i] = steps[i];
+    }
+    mRequests = 0;
+    mSamples = 0;
+    mMatrixBuilds = 0;
+}
+
+void PoseCache::SetStep(unsigned int lod, float seconds)
+{
+    if (lod >= ANIMLOD_BUCKET_COUNT)
+    {
+        std::cout << "WARNING: Pose cache LOD " << lod << " out of range\n";
+        return;
+    }
+    mSteps[lod] = seconds > 0.0f ? seconds : 0.0f;
+}
+
+float PoseCache::GetStep(unsigned int lod) const
+{
+    if (lod >= ANIMLOD_BUCKET_COUNT)
+    {
+        return mSteps[ANIMLOD_BUCKET_COUNT - 1];
+    }
+    return mSteps[lod];
+}
+
+void PoseCache::BeginFrame()
+{
+    std::lock_guard<std::mutex> guard(mLock);
+    mLookup.clear();
+    for (unsigned int i = 0; i < mUsed; ++i)
+    {
+        mEntries[i]->mPoseState.store(0, std::memory_order_relaxed);
+        mEntries[i]->mMatrixState.store(0, std::memory_order_relaxed);
+    }
+    mUsed = 0;
+}
+
+float PoseCache::Quantize(float time, unsigned int lod) const
+{
+    float step = GetStep(lod);
+    if (step <= 0.0f)
+    {
+        return time;
+    }
+    return floorf(time / step + 0.5f) * step;
+}
+
+void PoseCache::WaitReady(const std::atomic<int>& state)
+{
+    while (state.load(std::memory_order_acquire) != 2)
+    {
+        std::this_thread::yield();
+    }
+}
+
+PoseCache::Entry& PoseCache::Acquire(const void* clip, ClipSampler sampler, const Pose& restPose, float time)
+{
+    Key key;
+    key.mClip = clip;
+    key.mRestPose = &restPose;
+    key.mTime = time;
+
+    Entry* entry = 0;
+    bool owner = false;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        mRequests += 1;
+        std::unordered_map<Key, Entry*, KeyHash>::iterator it = mLookup.find(key);
+        if (it != mLookup.end())
+        {
+            entry = it->second;
+        }
+        else
+        {
+            if (mUsed == mEntries.size())
+            {
+                mEntries.push_back(std::unique_ptr<Entry>(new Entry()));
+            }
+            entry = mEntries[mUsed++].get();
+            entry->mPoseState.store(1, std::memory_order_relaxed);
+            mLookup[key] = entry;
+            mSamples += 1;
+            owner = true;
+        }
+    }
+
+    // Sample outside the lock so other keys aren't held up
+    if (owner)
+    {
+        entry->mPose = restPose;
+        sampler(clip, entry->mPose, time);
+        entry->mPoseState.store(2, std::memory_order_release);
+    }
+    else
+    {
+        WaitReady(entry->mPoseState);
+    }
+    return *entry;
+}
+
+unsigned int PoseCache::GetEntryCount()
+{
+    std::lock_guard<std::mutex> guard(mLock);
+    return mUsed;
+}
+
+PoseCacheStats PoseCache::GetStats()
+{
+    std::lock_guard<std::mutex> guard(mLock);
+    PoseCacheStats stats;
+    stats.requests = mRequests;
+    stats.samples = mSamples;
+    stats.matrixBuilds = mMatrixBuilds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PoseCache::ResetStats()
+{
+    std::lock_guard<std::mutex> guard(mLock);
+    mRequests = 0;
+    mSamples = 0;
+    mMatrixBuilds = 0;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "AnimationLOD.h"
+#include "Pose.h"
+#include "../math/mat4.h"
+
+// Time quantization per LOD bucket, in seconds. Bucket 0 keeps a 60 Hz step so
+// close characters still get a distinct pose every display frame.
+#define POSECACHE_DEFAULT_STEPS { 1.0f / 60.0f, 1.0f / 30.0f, 1.0f / 15.0f, 1.0f / 10.0f }
+
+struct PoseCacheStats
+{
+    // Since ResetStats
+    unsigned long long requests = 0;
+    unsigned long long samples = 0;
+    unsigned long long matrixBuilds = 0;
+};
+
+// Shares sampled poses between characters playing the same clip at nearly the
+// same time. Requests are keyed by clip, rest pose and time rounded to the step
+// of the character's LOD bucket; the first request for a key samples the clip
+// and every later one in the frame gets the same pose. Sampling cost follows the
+// number of distinct clip times instead of the number of characters.
+//
+// Characters built from the same Skeleton pass the same rest pose, which makes
+// them identical skeletons: they can share the global matrix palette too.
+//
+// Safe to call from several jobs at once. A request that finds its key being
+// sampled on another thread waits for it. Returned references stay valid until
+// the next BeginFrame.
+class PoseCache
+{
+private:
+    PoseCache(const PoseCache&);
+    PoseCache& operator=(const PoseCache&);
+
+protected:
+    struct Key
+    {
+        const void* mClip;
+        const Pose* mRestPose;
+        float mTime;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Pose mPose;
+        std::vector<mat4> mMatrices;
+        // 0 empty, 1 being built, 2 ready
+        std::atomic<int> mPoseState;
+        std::atomic<int> mMatrixState;
+
+        Entry() : mPoseState(0), mMatrixState(0) {}
+    };
+
+    typedef float (*ClipSampler)(const void* clip, Pose& outPose, float time);
+
+    std::mutex mLock;
+    std::unordered_map<Key, Entry*, KeyHash> mLookup;
+    // Entries are reused frame to frame so their poses keep their storage
+    std::vector<std::unique_ptr<Entry>> mEntries;
+    unsigned int mUsed;
+    float mSteps[ANIMLOD_BUCKET_COUNT];
+    unsigned long long mRequests;
+    unsigned long long mSamples;
+    std::atomic<unsigned long long> mMatrixBuilds;
+
+    template <typename T>
+    static float SampleClip(const void* clip, Pose& outPose, float time)
+    {
+        return ((const T*)clip)->Sample(outPose, time);
+    }
+
+    float Quantize(float time, unsigned int lod) const;
+    Entry& Acquire(const void* clip, ClipSampler sampler, const Pose& restPose, float time);
+    static void WaitReady(const std::atomic<int>& state);
+
+public:
+    PoseCache();
+
+    // Seconds between shared sample times for a LOD bucket. 0 only shares
+    // requests for exactly the same time.
+    void SetStep(unsigned int lod, float seconds);
+    float GetStep(unsigned int lod) const;
+
+    // Call once per frame, before any requests and with none in flight
+    void BeginFrame();
+
+    // Local pose of clip (Clip, BakedClip or CompressedClip) at time, fit to the
+    // clip and rounded to the step of lod. Joints the clip doesn't animate keep
+    // their rest pose values.
+    template <typename T>
+    const Pose& GetPose(const T& clip, const Pose& restPose, float time, unsigned int lod = 0)
+    {
+        float quantized = Quantize(clip.AdjustTimeToFitRange(time), lod);
+        return Acquire(&clip, &SampleClip<T>, restPose, quantized).mPose;
+    }
+
+    // Global matrices (Pose::GetMatrixPalette) of the same shared pose, built on
+    // the first request
+    template <typename T>
+    const std::vector<mat4>& GetMatrixPalette(const T& clip, const Pose& restPose, float time, unsigned int lod = 0)
+    {
+        float quantized = Quantize(clip.AdjustTimeToFitRange(time), lod);
+        Entry& entry = Acquire(&clip, &SampleClip<T>, restPose, quantized);
+        int expected = 0;
+        if (entry.mMatrixState.compare_exchange_strong(expected, 1))
+        {
+            entry.mPose.GetMatrixPalette(entry.mMatrices);
+            mMatrixBuilds.fetch_add(1, std::memory_order_relaxed);
+            entry.mMatrixState.store(2, std::memory_order_release);
+        }
+        else
+        {
+            WaitReady(entry.mMatrixState);
+        }
+        return entry.mMatrices;
+    }
+
+    // Distinct clip times sampled this frame
+    unsigned int GetEntryCount();
+    PoseCacheStats GetStats();
+    void ResetStats();
+};
@@ -0,0 +1,221 @@
+#include <cmath>
+#include <iostream>
+
+#include "RootMotion.h"
+
+RootMotion::RootMotion()
+{
+    mFrameCount = 0;
+    mStartTime = 0.0f;
+    mDuration = 0.0f;
+    mInvFrameTime = 0.0f;
+    mLooping = false;
+}
+
+void RootMotion::Extract(BakedClip& clip, unsigned int root, bool extractYaw)
+{
+    if (clip.IsAdditive())
+    {
+        std::cout << "WARNING: Can't extract root motion from additive clip " << clip.GetName() << "\n";
+        return;
+    }
+    if (root >= clip.GetJointCount() || clip.GetFrameCount() == 0)
+    {
+        std::cout << "WARNING: Root joint " << root << " is not in " << clip.GetName() << "\n";
+        return;
+    }
+
+    mFrameCount = clip.GetFrameCount();
+    mStartTime = clip.GetStartTime();
+    mDuration = clip.GetDuration();
+    mInvFrameTime = clip.GetFrameTime() > 0.0f ? 1.0f / clip.GetFrameTime() : 0.0f;
+    mLooping = clip.GetLooping();
+    mPositions.resize(mFrameCount);
+    mRotations.resize(mFrameCount);
+
+    // The ground frame of each frame: root position on the floor, facing its yaw
+    std::vector<Transform> ground(mFrameCount);
+    float yaw = 0.0f;
+    for (unsigned int frame = 0; frame < mFrameCount; ++frame)
+    {
+        vec3 position = clip.GetPositions(frame)[root];
+        vec3 forward = clip.GetRotations(frame)[root] * vec3(0, 0, 1);
+        // Keep the last yaw while the root faces straight up or down
+        if (forward.x * forward.x + forward.z * forward.z > VEC3_EPSILON)
+        {
+            yaw = atan2f(forward.x, forward.z);
+        }
+        ground[frame].position = vec3(position.x, 0.0f, position.z);
+        if (extractYaw)
+        {
+            ground[frame].rotation = angleAxis(yaw, vec3(0, 1, 0));
+        }
+    }
+
+    mStart = ground[0];
+    Transform invFirst = inverse(ground[0]);
+    for (unsigned int frame = 0; frame < mFrameCount; ++frame)
+    {
+        Transform motion = combine(invFirst, ground[frame]);
+        mPositions[frame] = motion.position;
+        mRotations[frame] = normalized(motion.rotation);
+        if (frame > 0 && dot(mRotations[frame - 1], mRotations[frame]) < 0.0f)
+        {
+            mRotations[frame] = -mRotations[frame];
+        }
+
+        // Express the root in its own frame's ground frame: character space
+        vec3& position = clip.GetPositions(frame)[root];
+        quat& rotation = clip.GetRotations(frame)[root];
+        Transform local(position, rotation, vec3(1, 1, 1));
+        Transform inPlace = combine(inverse(ground[frame]), local);
+        position = inPlace.position;
+        rotation = normalized(inPlace.rotation);
+        if (frame > 0 && dot(clip.GetRotations(frame - 1)[root], rotation) < 0.0f)
+        {
+            rotation = -rotation;
+        }
+    }
+}
+
+Transform RootMotion::Sample(float time) const
+{
+    Transform result;
+    if (mFrameCount < 2)
+    {
+        return result;
+    }
+
+    float frameTime = (time - mStartTime) * mInvFrameTime;
+    if (frameTime < 0.0f)
+    {
+        frameTime = 0.0f;
+    }
+    unsigned int frame = (unsigned int)frameTime;
+    if (frame > mFrameCount - 2)
+    {
+        frame = mFrameCount - 2;
+    }
+    float t = frameTime - (float)frame;
+    if (t > 1.0f)
+    {
+        t = 1.0f;
+    }
+
+    result.position = lerp(mPositions[frame], mPositions[frame + 1], t);
+    result.rotation = nlerp(mRotations[frame], mRotations[frame + 1], t);
+    return result;
+}
+
+Transform RootMotion::GetDelta(float time, float deltaTime) const
+{
+    if (mFrameCount < 2)
+    {
+        return Transform();
+    }
+    if (deltaTime < 0.0f)
+    {
+        return inverse(GetDelta(time + deltaTime, -deltaTime));
+    }
+    if (!mLooping || mDuration <= 0.0f)
+    {
+        return combine(inverse(Sample(time)), Sample(time + deltaTime));
+    }
+
+    // Split both ends into whole loops and the time within the loop
+    float from = time - mStartTime;
+    float to = from + deltaTime;
+    float fromLoop = floorf(from / mDuration);
+    float toLoop = floorf(to / mDuration);
+    from -= fromLoop * mDuration;
+    to -= toLoop * mDuration;
+    unsigned int loops = (unsigned int)(toLoop - fromLoop);
+
+    Transform start = inverse(Sample(mStartTime + from));
+    Transform end = Sample(mStartTime + to);
+    if (loops == 0)
+    {
+        return combine(start, end);
+    }
+
+    // To the end of this loop, through any whole loops, then into the last one
+    Transform loop = GetLoopDelta();
+    Transform delta = combine(start, loop);
+    for (unsigned int i = 1; i < loops; ++i)
+    {
+        delta = combine(delta, loop);
+    }
+    return combine(delta, end);
+}
+
+Transform RootMotion::GetStart() const
+{
+    return mStart;
+}
+
+Transform RootMotion::GetLoopDelta() const
+{
+    if (mFrameCount == 0)
+    {
+        return Transform();
+    }
+    return Transform(mPositions[mFrameCount - 1], mRotations[mFrameCount - 1], vec3(1, 1, 1));
+}
+
+unsigned int RootMotion::GetFrameCount() const
+{
+    return mFrameCount;
+}
+
+bool RootMotion::GetLooping() const
+{
+    return mLooping;
+}
+
+unsigned int RootMotion::GetMemoryBytes() const
+{
+    return (unsigned int)(sizeof(RootMotion) + mPositions.capacity() * sizeof(vec3) + mRotations.capacity() * sizeof(quat));
+}
+
+Transform BlendRootMotion(const Transform* deltas, const float* weights, unsigned int count)
+{
+    Transform result;
+    float total = 0.0f;
+    vec3 position;
+    quat rotation(0, 0, 0, 0);
+    const quat* reference = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float weight = weights[i];
+        if (weight <= 0.0f)
+        {
+            continue;
+        }
+        quat q = deltas[i].rotation;
+        if (reference == 0)
+        {
+            reference = &deltas[i].rotation;
+        }
+        else if (dot(*reference, q) < 0.0f)
+        {
+            q = -q;
+        }
+        position = position + deltas[i].position * weight;
+        rotation = rotation + q * weight;
+        total += weight;
+    }
+    if (total <= 0.0f)
+    {
+        return result;
+    }
+
+    result.position = position * (1.0f / total);
+    result.rotation = normalized(rotation);
+    return result;
+}
+
+void ApplyRootMotion(Transform& world, const Transform& delta)
+{
+    Transform step(delta.position, delta.rotation, vec3(1, 1, 1));
+    world = combine(world, step);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include "BakedClip.h"
+#include "../math/Transform.h"
+
+// Motion of a character's ground frame (root position on the XZ plane and yaw
+// about +Y) over a clip, extracted once at import time. Each baked frame keeps
+// the frame's placement relative to the first one, so the motion between any two
+// times is one lookup at each end instead of sampling and differencing the root
+// joint every frame.
+//
+// Extract also removes the motion from the clip's root joint, leaving every
+// frame in character space: its own ground frame, at the origin facing +Z. A
+// character's world transform then places its ground frame, and deltas move it.
+// Vertical motion and tilt stay in the clip. To play the clip where it was
+// authored, start the world transform at GetStart.
+class RootMotion
+{
+protected:
+    std::vector<vec3> mPositions;
+    std::vector<quat> mRotations;
+    Transform mStart;
+    unsigned int mFrameCount;
+    float mStartTime;
+    float mDuration;
+    float mInvFrameTime;
+    bool mLooping;
+
+public:
+    RootMotion();
+
+    // root must be a joint without a parent. With extractYaw false only the
+    // translation is extracted and the root keeps all of its rotation.
+    void Extract(BakedClip& clip, unsigned int root, bool extractYaw = true);
+
+    // Placement of the ground frame at time (clamped to the clip) relative to
+    // the clip's first frame
+    Transform Sample(float time) const;
+    // How the character moves from time to time + deltaTime, in its own space at
+    // time. Looping clips wrap as many times as deltaTime spans, adding the whole
+    // loop's motion each time; other clips stop at their ends. A negative
+    // deltaTime plays backwards.
+    Transform GetDelta(float time, float deltaTime) const;
+    // Ground frame of the first frame in the clip's original model space
+    Transform GetStart() const;
+    // Motion over one full pass of the clip
+    Transform GetLoopDelta() const;
+
+    unsigned int GetFrameCount() const;
+    bool GetLooping() const;
+    unsigned int GetMemoryBytes() const;
+};
+
+// Weighted average of the deltas of blended clips, each advanced by its own
+// playback. Weights need not sum to one; zero weights are skipped.
+Transform BlendRootMotion(const Transform* deltas, const float* weights, unsigned int count);
+
+// Moves a character's world transform by a delta from GetDelta or
+// BlendRootMotion. The delta is applied in the character's space, so it turns
+// with the character. Scale is left unchanged.
+void ApplyRootMotion(Transform& world, const Transform& delta);
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <iostream>
+
+#include "Skeleton.h"
+#include "Clip.h"
+
+// Depth of every joint (roots are 0). Returns false and the joint whose parent
+// link closes a loop if the hierarchy has a cycle.
+static bool ComputeDepths(const Pose& pose, std::vector<int>& outDepths, unsigned int& outCycleJoint)
+{
+    const int unknown = -2;
+    const int visiting = -1;
+    unsigned int size = pose.Size();
+    outDepths.assign(size, unknown);
+
+    std::vector<unsigned int> chain;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        // Walk up until a root or a joint with a known depth, then fill in on the way back
+        chain.clear();
+        int joint = (int)i;
+        while (joint >= 0 && joint < (int)size && outDepths[joint] == unknown)
+        {
+            outDepths[joint] = visiting;
+            chain.push_back((unsigned int)joint);
+            joint = pose.GetParent((unsigned int)joint);
+        }
+
+        int depth = -1;
+        if (joint >= 0 && joint < (int)size)
+        {
+            if (outDepths[joint] == visiting)
+            {
+                outCycleJoint = chain.back();
+                return false;
+            }
+            depth = outDepths[joint];
+        }
+        for (std::vector<unsigned int>::reverse_iterator it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            depth += 1;
+            outDepths[*it] = depth;
+        }
+    }
+    return true;
+}
+
+static Pose ReorderPose(const Pose& pose, const std::vector<unsigned int>& sourceFromSorted, const std::vector<int>& sortedFromSource)
+{
+    unsigned int size = pose.Size();
+    Pose result(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int source = sourceFromSorted[i];
+        int parent = pose.GetParent(source);
+        result.SetLocalTransform(i, pose.GetLocalTransform(source));
+        result.SetParent(i, parent >= 0 ? sortedFromSource[parent] : -1);
+    }
+    return result;
+}
+
+Skeleton::Skeleton()
+{
+    mMetadata.reset(new SkeletonMetadata());
+}
+
+Skeleton::Skeleton(const Pose& rest, const Pose& bind, const std::vector<std::string>& names)
+{
+    mMetadata.reset(new SkeletonMetadata());
+    Set(rest, bind, names);
+}
+
+Skeleton::Skeleton(const Skeleton& other)
+{
+    mRestPose = other.mRestPose;
+    mBindPose = other.mBindPose;
+    mInvBindPose = other.mInvBindPose;
+    mMetadata.reset(new SkeletonMetadata(*other.mMetadata));
+}
+
+Skeleton& Skeleton::operator=(const Skeleton& other)
+{
+    if (this != &other)
+    {
+        mRestPose = other.mRestPose;
+        mBindPose = other.mBindPose;
+        mInvBindPose = other.mInvBindPose;
+        mMetadata.reset(new SkeletonMetadata(*other.mMetadata));
+    }
+    return *this;
+}
+
+void Skeleton::Set(const Pose& rest, const Pose& bind, const std::vector<std::string>& names)
+{
+    unsigned int size = rest.Size();
+    Pose sortableRest = rest;
+    Pose sortableBind = bind;
+
+    // Parents out of range are roots. A joint that closes a parent cycle can't be
+    // sorted; it is detached and kept as a root.
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (sortableRest.GetParent(i) >= (int)size)
+        {
+            sortableRest.SetParent(i, -1);
+        }
+    }
+    std::vector<int> depths;
+    unsigned int cycleJoint = 0;
+    while (!ComputeDepths(sortableRest, depths, cycleJoint))
+    {
+        std::cout << "WARNING: Joint " << cycleJoint << " is part of a parent cycle\n";
+        sortableRest.SetParent(cycleJoint, -1);
+    }
+    // The bind pose shares the rest pose hierarchy
+    sortableBind.Resize(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        sortableBind.SetParent(i, sortableRest.GetParent(i));
+    }
+
+    // Breadth first by depth, authoring order within a depth
+    std::vector<unsigned int> order(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&depths](unsigned int a, unsigned int b) {
+        return depths[a] < depths[b];
+    });
+
+    SkeletonMetadata& metadata = *mMetadata;
+    metadata.mSourceFromSorted = order;
+    metadata.mSortedFromSource.assign(size, -1);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        metadata.mSortedFromSource[order[i]] = (int)i;
+    }
+
+    mRestPose = ReorderPose(sortableRest, metadata.mSourceFromSorted, metadata.mSortedFromSource);
+    mBindPose = ReorderPose(sortableBind, metadata.mSourceFromSorted, metadata.mSortedFromSource);
+
+    metadata.mJointNames.resize(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int source = order[i];
+        metadata.mJointNames[i] = source < names.size() ? names[source] : std::string();
+    }
+
+    UpdateInverseBindPose();
+}
+
+void Skeleton::UpdateInverseBindPose()
+{
+    unsigned int size = mBindPose.Size();
+    std::vector<Transform> world(size);
+    if (size > 0)
+    {
+        mBindPose.GetGlobalTransforms(&world[0]);
+    }
+
+    mInvBindPose.resize(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        mInvBindPose[i] = inverse(transformToMat4(world[i]));
+    }
+}
+
+const Pose& Skeleton::GetBindPose() const
+{
+    return mBindPose;
+}
+
+const Pose& Skeleton::GetRestPose() const
+{
+    return mRestPose;
+}
+
+const std::vector<mat4>& Skeleton::GetInvBindPose() const
+{
+    return mInvBindPose;
+}
+
+unsigned int Skeleton::Size() const
+{
+    return mRestPose.Size();
+}
+
+const std::vector<std::string>& Skeleton::GetJointNames() const
+{
+    return mMetadata->mJointNames;
+}
+
+const std::string& Skeleton::GetJointName(unsigned int index) const
+{
+    return mMetadata->mJointNames[index];
+}
+
+int Skeleton::FindJoint(const std::string& name) const
+{
+    const std::vector<std::string>& names = mMetadata->mJointNames;
+    for (unsigned int i = 0, size = (unsigned int)names.size(); i < size; ++i)
+    {
+        if (names[i] == name)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int Skeleton::GetSortedIndex(unsigned int sourceIndex) const
+{
+    if (sourceIndex >= mMetadata->mSortedFromSource.size())
+    {
+        return -1;
+    }
+    return mMetadata->mSortedFromSource[sourceIndex];
+}
+
+unsigned int Skeleton::GetSourceIndex(unsigned int sortedIndex) const
+{
+    return mMetadata->mSourceFromSorted[sortedIndex];
+}
+
+void Skeleton::RemapClip(Clip& clip) const
+{
+    for (unsigned int i = 0, size = clip.Size(); i < size; ++i)
+    {
+        int sorted = GetSortedIndex(clip.GetIdAtIndex(i));
+        if (sorted >= 0)
+        {
+            clip.SetIdAtIndex(i, (unsigned int)sorted);
+        }
+    }
+}
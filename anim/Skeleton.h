@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Pose.h"
+#include "../math/mat4.h"
+
+class Clip;
+
+// Cold skeleton data: only touched at load time and by tools
+struct SkeletonMetadata
+{
+    std::vector<std::string> mJointNames;
+    // Sorted index of each joint in the order it was authored, and the reverse
+    std::vector<int> mSortedFromSource;
+    std::vector<unsigned int> mSourceFromSorted;
+};
+
+// Rest pose, bind pose and inverse bind matrices, with joints reordered so every
+// parent precedes its children. The per-frame data lives in the poses and the
+// matrix array; names and the reorder tables sit in a separate allocation so they
+// stay out of the cache lines the hot passes touch.
+class Skeleton
+{
+protected:
+    Pose mRestPose;
+    Pose mBindPose;
+    std::vector<mat4> mInvBindPose;
+    std::unique_ptr<SkeletonMetadata> mMetadata;
+
+    void UpdateInverseBindPose();
+
+public:
+    Skeleton();
+    Skeleton(const Pose& rest, const Pose& bind, const std::vector<std::string>& names);
+    Skeleton(const Skeleton& other);
+    Skeleton& operator=(const Skeleton& other);
+
+    // Poses may be in any joint order; they are sorted topologically here
+    void Set(const Pose& rest, const Pose& bind, const std::vector<std::string>& names);
+
+    const Pose& GetBindPose() const;
+    const Pose& GetRestPose() const;
+    const std::vector<mat4>& GetInvBindPose() const;
+    unsigned int Size() const;
+
+    const std::vector<std::string>& GetJointNames() const;
+    const std::string& GetJointName(unsigned int index) const;
+    // -1 if there is no joint with that name
+    int FindJoint(const std::string& name) const;
+
+    // Data authored against the original joint order (clips, skin weights) must be
+    // remapped to the sorted order
+    int GetSortedIndex(unsigned int sourceIndex) const;
+    unsigned int GetSourceIndex(unsigned int sortedIndex) const;
+    void RemapClip(Clip& clip) const;
+};
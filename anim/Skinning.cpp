@@ -0,0 +1,560 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "Skinning.h"
+#include "../core/JobSystem.h"
+#include "../math/simd.h"
+
+#define SKINNING_WEIGHT_EPSILON 0.00001f
+
+namespace
+{
+    struct SkinInfluence
+    {
+        unsigned short joint;
+        float weight;
+    };
+
+    inline void StoreVec3(const float* lanes, vec3& out)
+    {
+        out.x = lanes[0];
+        out.y = lanes[1];
+        out.z = lanes[2];
+    }
+
+    inline void NormalizeInPlace(vec3& v)
+    {
+        float lenSq = v.x * v.x + v.y * v.y + v.z * v.z;
+        if (lenSq > VEC3_EPSILON)
+        {
+            float invLen = 1.0f / sqrtf(lenSq);
+            v.x *= invLen;
+            v.y *= invLen;
+            v.z *= invLen;
+        }
+    }
+
+    // real and dual are the blended, unnormalised dual quaternion. Every term of
+    // the rotation and translation is quadratic in it, so dividing by |real|^2
+    // stands in for normalising first.
+    inline void ApplyDualQuat(const float* real, const float* dual, const vec3& p, const vec3* n, vec3& outP, vec3* outN)
+    {
+        float lenSq = real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3];
+        float invLenSq = lenSq > 0.000001f ? 1.0f / lenSq : 0.0f;
+        vec3 u(real[0], real[1], real[2]);
+        float s = real[3];
+        float sSqMinusUU = s * s - dot(u, u);
+
+        // 2 * dual * conjugate(real), vector part
+        vec3 du(dual[0], dual[1], dual[2]);
+        vec3 t = (du * s - u * dual[3] + cross(u, du)) * (2.0f * invLenSq);
+        outP = (u * (2.0f * dot(u, p)) + p * sSqMinusUU + cross(u, p) * (2.0f * s)) * invLenSq + t;
+
+        if (outN != 0)
+        {
+            *outN = (u * (2.0f * dot(u, *n)) + *n * sSqMinusUU + cross(u, *n) * (2.0f * s)) * invLenSq;
+        }
+    }
+
+#if MATH_SSE
+    // N is a compile time constant, so the blend loop unrolls and the kernel
+    // has no branches other than the vertex loop itself
+    template <unsigned int N>
+    void SkinVertices(const mat4* palette, const unsigned short* joints, const float* weights,
+        const vec3* positions, const vec3* normals, vec3* outPositions, vec3* outNormals, unsigned int count)
+    {
+        float lanes[4];
+        for (unsigned int i = 0; i < count; ++i, joints += N, weights += N)
+        {
+            const float* m = palette[joints[0]].v;
+            __m128 w = _mm_set1_ps(weights[0]);
+            __m128 c0 = _mm_mul_ps(_mm_loadu_ps(m + 0), w);
+            __m128 c1 = _mm_mul_ps(_mm_loadu_ps(m + 4), w);
+            __m128 c2 = _mm_mul_ps(_mm_loadu_ps(m + 8), w);
+            __m128 c3 = _mm_mul_ps(_mm_loadu_ps(m + 12), w);
+            for (unsigned int k = 1; k < N; ++k)
+            {
+                m = palette[joints[k]].v;
+                w = _mm_set1_ps(weights[k]);
+                c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m + 0), w));
+                c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+                c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+                c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+            }
+
+            const vec3& p = positions[i];
+            __m128 result = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), _mm_mul_ps(c1, _mm_set1_ps(p.y))),
+                _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p.z)), c3));
+            _mm_storeu_ps(lanes, result);
+            StoreVec3(lanes, outPositions[i]);
+
+            if (outNormals != 0)
+            {
+                const vec3& n = normals[i];
+                result = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(n.x)), _mm_mul_ps(c1, _mm_set1_ps(n.y))),
+                    _mm_mul_ps(c2, _mm_set1_ps(n.z)));
+                _mm_storeu_ps(lanes, result);
+                StoreVec3(lanes, outNormals[i]);
+                NormalizeInPlace(outNormals[i]);
+            }
+        }
+    }
+    // Blends with each real part pulled into the hemisphere of the first
+    // influence. The sign flip is a mask on the weight rather than a branch.
+    template <unsigned int N>
+    void SkinVerticesDualQuat(const DualQuaternion* palette, const unsigned short* joints, const float* weights,
+        const vec3* positions, const vec3* normals, vec3* outPositions, vec3* outNormals, unsigned int count)
+    {
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        float lanes[8];
+        for (unsigned int i = 0; i < count; ++i, joints += N, weights += N)
+        {
+            const float* dq = palette[joints[0]].real.v;
+            __m128 pivot = _mm_loadu_ps(dq);
+            __m128 w = _mm_set1_ps(weights[0]);
+            __m128 real = _mm_mul_ps(pivot, w);
+            __m128 dual = _mm_mul_ps(_mm_loadu_ps(dq + 4), w);
+            for (unsigned int k = 1; k < N; ++k)
+            {
+                dq = palette[joints[k]].real.v;
+                __m128 r = _mm_loadu_ps(dq);
+                __m128 prod = _mm_mul_ps(r, pivot);
+                __m128 shuf = _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(2, 3, 0, 1));
+                __m128 sums = _mm_add_ps(prod, shuf);
+                shuf = _mm_movehl_ps(shuf, sums);
+                sums = _mm_add_ss(sums, shuf);
+                __m128 sign = _mm_and_ps(_mm_shuffle_ps(sums, sums, 0), signBit);
+                w = _mm_xor_ps(_mm_set1_ps(weights[k]), sign);
+                real = _mm_add_ps(real, _mm_mul_ps(r, w));
+                dual = _mm_add_ps(dual, _mm_mul_ps(_mm_loadu_ps(dq + 4), w));
+            }
+            _mm_storeu_ps(lanes, real);
+            _mm_storeu_ps(lanes + 4, dual);
+            ApplyDualQuat(lanes, lanes + 4, positions[i], normals + i, outPositions[i], outNormals != 0 ? outNormals + i : 0);
+        }
+    }
+#else
+    template <unsigned int N>
+    void SkinVertices(const mat4* palette, const unsigned short* joints, const float* weights,
+        const vec3* positions, const vec3* normals, vec3* outPositions, vec3* outNormals, unsigned int count)
+    {
+        float blend[16];
+        for (unsigned int i = 0; i < count; ++i, joints += N, weights += N)
+        {
+            for (unsigned int j = 0; j < 16; ++j)
+            {
+                blend[j] = 0.0f;
+            }
+            for (unsigned int k = 0; k < N; ++k)
+            {
+                const float* m = palette[joints[k]].v;
+                for (unsigned int j = 0; j < 16; ++j)
+                {
+                    blend[j] += m[j] * weights[k];
+                }
+            }
+
+            const vec3& p = positions[i];
+            outPositions[i] = vec3(
+                blend[0] * p.x + blend[4] * p.y + blend[8] * p.z + blend[12],
+                blend[1] * p.x + blend[5] * p.y + blend[9] * p.z + blend[13],
+                blend[2] * p.x + blend[6] * p.y + blend[10] * p.z + blend[14]);
+
+            if (outNormals != 0)
+            {
+                const vec3& n = normals[i];
+                outNormals[i] = vec3(
+                    blend[0] * n.x + blend[4] * n.y + blend[8] * n.z,
+                    blend[1] * n.x + blend[5] * n.y + blend[9] * n.z,
+                    blend[2] * n.x + blend[6] * n.y + blend[10] * n.z);
+                NormalizeInPlace(outNormals[i]);
+            }
+        }
+    }
+    template <unsigned int N>
+    void SkinVerticesDualQuat(const DualQuaternion* palette, const unsigned short* joints, const float* weights,
+        const vec3* positions, const vec3* normals, vec3* outPositions, vec3* outNormals, unsigned int count)
+    {
+        float lanes[8];
+        for (unsigned int i = 0; i < count; ++i, joints += N, weights += N)
+        {
+            const DualQuaternion& pivot = palette[joints[0]];
+            for (unsigned int j = 0; j < 8; ++j)
+            {
+                lanes[j] = 0.0f;
+            }
+            for (unsigned int k = 0; k < N; ++k)
+            {
+                const DualQuaternion& dq = palette[joints[k]];
+                float w = dot(dq.real, pivot.real) < 0.0f ? -weights[k] : weights[k];
+                for (unsigned int j = 0; j < 8; ++j)
+                {
+                    lanes[j] += (&dq.real.x)[j] * w;
+                }
+            }
+            ApplyDualQuat(lanes, lanes + 4, positions[i], normals + i, outPositions[i], outNormals != 0 ? outNormals + i : 0);
+        }
+    }
+#endif
+}
+
+CPUSkinMesh::CPUSkinMesh()
+{
+    mMaxJoint = 0;
+}
+
+void CPUSkinMesh::Set(const vec3* positions, const vec3* normals, unsigned int vertexCount,
+    const int* joints, const float* weights, unsigned int influencesPerVertex)
+{
+    mPositions.clear();
+    mNormals.clear();
+    mJoints.clear();
+    mWeights.clear();
+    mGroups.clear();
+    mChunks.clear();
+    mSortedFromSource.clear();
+    mSourceFromSorted.clear();
+    mMaxJoint = 0;
+
+    if (influencesPerVertex > SKINNING_MAX_INFLUENCES)
+    {
+        std::cout << "WARNING: " << influencesPerVertex << " influences per vertex, only the heaviest "
+            << SKINNING_MAX_INFLUENCES << " are used\n";
+    }
+
+    // Gather, sort (heaviest first) and renormalise each vertex's influences
+    std::vector<SkinInfluence> influences(vertexCount * SKINNING_MAX_INFLUENCES);
+    std::vector<unsigned int> counts(vertexCount);
+    unsigned int unweighted = 0;
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        SkinInfluence gathered[64];
+        unsigned int count = 0;
+        for (unsigned int k = 0; k < influencesPerVertex && count < 64; ++k)
+        {
+            int joint = joints[v * influencesPerVertex + k];
+            float weight = weights[v * influencesPerVertex + k];
+            if (weight > SKINNING_WEIGHT_EPSILON && joint >= 0 && joint <= 0xFFFF)
+            {
+                gathered[count].joint = (unsigned short)joint;
+                gathered[count].weight = weight;
+                count += 1;
+            }
+        }
+        std::sort(gathered, gathered + count, [](const SkinInfluence& a, const SkinInfluence& b) {
+            return a.weight > b.weight;
+        });
+        if (count > SKINNING_MAX_INFLUENCES)
+        {
+            count = SKINNING_MAX_INFLUENCES;
+        }
+        if (count == 0)
+        {
+            // Keep the vertex attached to the root rather than collapsing it to the origin
+            gathered[0].joint = 0;
+            gathered[0].weight = 1.0f;
+            count = 1;
+            unweighted += 1;
+        }
+
+        float total = 0.0f;
+        for (unsigned int k = 0; k < count; ++k)
+        {
+            total += gathered[k].weight;
+        }
+        for (unsigned int k = 0; k < count; ++k)
+        {
+            gathered[k].weight /= total;
+            influences[v * SKINNING_MAX_INFLUENCES + k] = gathered[k];
+            if (gathered[k].joint > mMaxJoint)
+            {
+                mMaxJoint = gathered[k].joint;
+            }
+        }
+        counts[v] = count;
+    }
+    if (unweighted > 0)
+    {
+        std::cout << "WARNING: " << unweighted << " vertices have no skin weights, bound to joint 0\n";
+    }
+
+    // Counting sort by influence count keeps the source order within each group
+    unsigned int groupSizes[SKINNING_MAX_INFLUENCES + 1] = { 0 };
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        groupSizes[counts[v]] += 1;
+    }
+    unsigned int groupStart[SKINNING_MAX_INFLUENCES + 1] = { 0 };
+    unsigned int firstVertex = 0;
+    unsigned int firstInfluence = 0;
+    for (unsigned int n = 1; n <= SKINNING_MAX_INFLUENCES; ++n)
+    {
+        groupStart[n] = firstVertex;
+        if (groupSizes[n] == 0)
+        {
+            continue;
+        }
+        SkinGroup group;
+        group.mInfluences = n;
+        group.mFirstVertex = firstVertex;
+        group.mVertexCount = groupSizes[n];
+        group.mFirstInfluence = firstInfluence;
+        mGroups.push_back(group);
+        firstVertex += groupSizes[n];
+        firstInfluence += groupSizes[n] * n;
+    }
+
+    mSortedFromSource.resize(vertexCount);
+    mSourceFromSorted.resize(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        unsigned int sorted = groupStart[counts[v]]++;
+        mSortedFromSource[v] = sorted;
+        mSourceFromSorted[sorted] = v;
+    }
+
+    mPositions.resize(vertexCount);
+    mNormals.resize(vertexCount, vec3(0, 1, 0));
+    mJoints.resize(firstInfluence);
+    mWeights.resize(firstInfluence);
+    unsigned int cursor = 0;
+    for (unsigned int s = 0; s < vertexCount; ++s)
+    {
+        unsigned int v = mSourceFromSorted[s];
+        mPositions[s] = positions[v];
+        if (normals != 0)
+        {
+            mNormals[s] = normals[v];
+        }
+        for (unsigned int k = 0; k < counts[v]; ++k, ++cursor)
+        {
+            mJoints[cursor] = influences[v * SKINNING_MAX_INFLUENCES + k].joint;
+            mWeights[cursor] = influences[v * SKINNING_MAX_INFLUENCES + k].weight;
+        }
+    }
+
+    for (unsigned int g = 0, size = (unsigned int)mGroups.size(); g < size; ++g)
+    {
+        const SkinGroup& group = mGroups[g];
+        for (unsigned int first = 0; first < group.mVertexCount; first += SKINNING_CHUNK_SIZE)
+        {
+            SkinChunk chunk;
+            chunk.mGroup = g;
+            chunk.mFirstVertex = first;
+            chunk.mVertexCount = std::min((unsigned int)SKINNING_CHUNK_SIZE, group.mVertexCount - first);
+            mChunks.push_back(chunk);
+        }
+    }
+}
+
+void CPUSkinMesh::SkinChunkRange(const SkinChunk& chunk, const mat4* palette, vec3* outPositions, vec3* outNormals) const
+{
+    const SkinGroup& group = mGroups[chunk.mGroup];
+    unsigned int n = group.mInfluences;
+    unsigned int vertex = group.mFirstVertex + chunk.mFirstVertex;
+    const unsigned short* joints = &mJoints[group.mFirstInfluence + chunk.mFirstVertex * n];
+    const float* weights = &mWeights[group.mFirstInfluence + chunk.mFirstVertex * n];
+    const vec3* positions = &mPositions[vertex];
+    const vec3* normals = &mNormals[vertex];
+    vec3* dstPositions = outPositions + vertex;
+    vec3* dstNormals = outNormals != 0 ? outNormals + vertex : 0;
+    unsigned int count = chunk.mVertexCount;
+
+    switch (n)
+    {
+    case 1: SkinVertices<1>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 2: SkinVertices<2>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 3: SkinVertices<3>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 4: SkinVertices<4>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 5: SkinVertices<5>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 6: SkinVertices<6>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 7: SkinVertices<7>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 8: SkinVertices<8>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    }
+}
+
+void CPUSkinMesh::SkinChunkRange(const SkinChunk& chunk, const DualQuaternion* palette, vec3* outPositions, vec3* outNormals) const
+{
+    const SkinGroup& group = mGroups[chunk.mGroup];
+    unsigned int n = group.mInfluences;
+    unsigned int vertex = group.mFirstVertex + chunk.mFirstVertex;
+    const unsigned short* joints = &mJoints[group.mFirstInfluence + chunk.mFirstVertex * n];
+    const float* weights = &mWeights[group.mFirstInfluence + chunk.mFirstVertex * n];
+    const vec3* positions = &mPositions[vertex];
+    const vec3* normals = &mNormals[vertex];
+    vec3* dstPositions = outPositions + vertex;
+    vec3* dstNormals = outNormals != 0 ? outNormals + vertex : 0;
+    unsigned int count = chunk.mVertexCount;
+
+    switch (n)
+    {
+    case 1: SkinVerticesDualQuat<1>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 2: SkinVerticesDualQuat<2>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 3: SkinVerticesDualQuat<3>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 4: SkinVerticesDualQuat<4>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 5: SkinVerticesDualQuat<5>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 6: SkinVerticesDualQuat<6>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 7: SkinVerticesDualQuat<7>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    case 8: SkinVerticesDualQuat<8>(palette, joints, weights, positions, normals, dstPositions, dstNormals, count); break;
+    }
+}
+
+void CPUSkinMesh::Skin(const mat4* palette, unsigned int paletteSize, vec3* outPositions, vec3* outNormals, JobSystem* jobs) const
+{
+    if (mPositions.empty())
+    {
+        return;
+    }
+    if (mMaxJoint >= paletteSize)
+    {
+        std::cout << "WARNING: Skin palette has " << paletteSize << " matrices, mesh references joint " << mMaxJoint << "\n";
+        return;
+    }
+
+    unsigned int chunkCount = (unsigned int)mChunks.size();
+    if (jobs == 0)
+    {
+        for (unsigned int i = 0; i < chunkCount; ++i)
+        {
+            SkinChunkRange(mChunks[i], palette, outPositions, outNormals);
+        }
+        return;
+    }
+
+    jobs->ParallelFor(chunkCount, [this, palette, outPositions, outNormals](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            SkinChunkRange(mChunks[i], palette, outPositions, outNormals);
+        }
+    });
+}
+
+void CPUSkinMesh::SkinDualQuat(const DualQuaternion* palette, unsigned int paletteSize, vec3* outPositions, vec3* outNormals, JobSystem* jobs) const
+{
+    if (mPositions.empty())
+    {
+        return;
+    }
+    if (mMaxJoint >= paletteSize)
+    {
+        std::cout << "WARNING: Skin palette has " << paletteSize << " dual quaternions, mesh references joint " << mMaxJoint << "\n";
+        return;
+    }
+
+    unsigned int chunkCount = (unsigned int)mChunks.size();
+    if (jobs == 0)
+    {
+        for (unsigned int i = 0; i < chunkCount; ++i)
+        {
+            SkinChunkRange(mChunks[i], palette, outPositions, outNormals);
+        }
+        return;
+    }
+
+    jobs->ParallelFor(chunkCount, [this, palette, outPositions, outNormals](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            SkinChunkRange(mChunks[i], palette, outPositions, outNormals);
+        }
+    });
+}
+
+void CPUSkinMesh::BuildPalette(const Pose& pose, const std::vector<mat4>& invBindPose, std::vector<mat4>& out)
+{
+    pose.GetMatrixPalette(out);
+    unsigned int size = (unsigned int)std::min(out.size(), invBindPose.size());
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        out[i] = out[i] * invBindPose[i];
+    }
+}
+
+void CPUSkinMesh::BuildInvBindDualQuats(const Pose& bindPose, std::vector<DualQuaternion>& out)
+{
+    BuildDualQuatPalette(bindPose, std::vector<DualQuaternion>(), out);
+    for (unsigned int i = 0, size = (unsigned int)out.size(); i < size; ++i)
+    {
+        out[i] = conjugate(out[i]);
+    }
+}
+
+void CPUSkinMesh::BuildDualQuatPalette(const Pose& pose, const std::vector<DualQuaternion>& invBindPose, std::vector<DualQuaternion>& out)
+{
+    unsigned int size = pose.Size();
+    out.resize(size);
+    const Transform* joints = pose.GetLocalTransforms();
+    const int* parents = pose.GetParents();
+
+    // Global transforms in one forward pass; parents precede their children
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        DualQuaternion local = transformToDualQuat(joints[i]);
+        out[i] = parents[i] < 0 ? local : local * out[parents[i]];
+    }
+
+    if (invBindPose.size() >= size)
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            out[i] = invBindPose[i] * out[i];
+        }
+    }
+}
+
+void CPUSkinMesh::RemapIndices(unsigned int* indices, unsigned int count) const
+{
+    unsigned int vertexCount = (unsigned int)mSortedFromSource.size();
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (indices[i] < vertexCount)
+        {
+            indices[i] = mSortedFromSource[indices[i]];
+        }
+    }
+}
+
+void CPUSkinMesh::RemapIndices(std::vector<unsigned int>& indices) const
+{
+    if (!indices.empty())
+    {
+        RemapIndices(&indices[0], (unsigned int)indices.size());
+    }
+}
+
+unsigned int CPUSkinMesh::GetVertexCount() const
+{
+    return (unsigned int)mPositions.size();
+}
+
+unsigned int CPUSkinMesh::GetChunkCount() const
+{
+    return (unsigned int)mChunks.size();
+}
+
+const std::vector<SkinGroup>& CPUSkinMesh::GetGroups() const
+{
+    return mGroups;
+}
+
+const std::vector<vec3>& CPUSkinMesh::GetPositions() const
+{
+    return mPositions;
+}
+
+const std::vector<vec3>& CPUSkinMesh::GetNormals() const
+{
+    return mNormals;
+}
+
+unsigned int CPUSkinMesh::GetSortedIndex(unsigned int sourceIndex) const
+{
+    return mSortedFromSource[sourceIndex];
+}
+
+unsigned int CPUSkinMesh::GetSourceIndex(unsigned int sortedIndex) const
+{
+    return mSourceFromSorted[sortedIndex];
+}
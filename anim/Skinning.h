@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include "Pose.h"
+#include "../math/DualQuaternion.h"
+#include "../math/mat4.h"
+#include "../math/vec3.h"
+
+class JobSystem;
+
+#define SKINNING_MAX_INFLUENCES 8
+// Vertices per chunk handed to the job system
+#define SKINNING_CHUNK_SIZE 4096
+
+// Vertices with the same number of influences, stored contiguously
+struct SkinGroup
+{
+    unsigned int mInfluences;
+    unsigned int mFirstVertex;
+    unsigned int mVertexCount;
+    // Offset of the group's first joint index / weight
+    unsigned int mFirstInfluence;
+};
+
+struct SkinChunk
+{
+    unsigned int mGroup;
+    unsigned int mFirstVertex;
+    unsigned int mVertexCount;
+};
+
+// CPU linear blend and dual quaternion skinning. At load time vertices are reordered by influence
+// count and weights are packed tightly per group, so every chunk runs a kernel
+// specialised for exactly that many influences with no per-vertex branching.
+// Chunks are independent and run in parallel on a JobSystem.
+//
+// Skinned output is written in the sorted vertex order; index buffers authored
+// against the source order must be passed through RemapIndices once.
+class CPUSkinMesh
+{
+protected:
+    std::vector<vec3> mPositions;
+    std::vector<vec3> mNormals;
+    std::vector<unsigned short> mJoints;
+    std::vector<float> mWeights;
+    std::vector<SkinGroup> mGroups;
+    std::vector<SkinChunk> mChunks;
+    std::vector<unsigned int> mSortedFromSource;
+    std::vector<unsigned int> mSourceFromSorted;
+    unsigned int mMaxJoint;
+
+    void SkinChunkRange(const SkinChunk& chunk, const mat4* palette, vec3* outPositions, vec3* outNormals) const;
+    void SkinChunkRange(const SkinChunk& chunk, const DualQuaternion* palette, vec3* outPositions, vec3* outNormals) const;
+
+public:
+    CPUSkinMesh();
+
+    // joints and weights hold influencesPerVertex entries per vertex (up to
+    // SKINNING_MAX_INFLUENCES). Zero weights mark unused slots. normals may be null.
+    void Set(const vec3* positions, const vec3* normals, unsigned int vertexCount,
+        const int* joints, const float* weights, unsigned int influencesPerVertex);
+
+    // palette holds one skin matrix per joint (see BuildPalette). Both outputs
+    // hold GetVertexCount() entries in sorted order; outNormals may be null.
+    // Runs on the calling thread when jobs is null.
+    void Skin(const mat4* palette, unsigned int paletteSize, vec3* outPositions, vec3* outNormals, JobSystem* jobs = 0) const;
+
+    // Same vertex layout and output as Skin, with a dual quaternion palette (see
+    // BuildDualQuatPalette). Blending rigid transforms avoids the volume loss of
+    // linear blending at twisting joints; the palette is half the size. Joint
+    // scale is not supported.
+    void SkinDualQuat(const DualQuaternion* palette, unsigned int paletteSize, vec3* outPositions, vec3* outNormals, JobSystem* jobs = 0) const;
+
+    // Pose matrix palette multiplied by the inverse bind pose
+    static void BuildPalette(const Pose& pose, const std::vector<mat4>& invBindPose, std::vector<mat4>& out);
+    // Computed once per skeleton from its bind pose
+    static void BuildInvBindDualQuats(const Pose& bindPose, std::vector<DualQuaternion>& out);
+    // Inverse bind followed by the pose's global transform, per joint
+    static void BuildDualQuatPalette(const Pose& pose, const std::vector<DualQuaternion>& invBindPose, std::vector<DualQuaternion>& out);
+
+    void RemapIndices(unsigned int* indices, unsigned int count) const;
+    void RemapIndices(std::vector<unsigned int>& indices) const;
+
+    unsigned int GetVertexCount() const;
+    unsigned int GetChunkCount() const;
+    const std::vector<SkinGroup>& GetGroups() const;
+    // Rest data in sorted order
+    const std::vector<vec3>& GetPositions() const;
+    const std::vector<vec3>& GetNormals() const;
+    unsigned int GetSortedIndex(unsigned int sourceIndex) const;
+    unsigned int GetSourceIndex(unsigned int sortedIndex) const;
+};
@@ -0,0 +1,344 @@
+#include <cmath>
+#include <cstring>
+
+#include "Track.h"
+
+// Keys the cursor may step over before a sample is treated as a seek
+#define TRACK_CURSOR_MAX_WALK 4
+
+namespace TrackHelpers
+{
+    inline float Interpolate(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    inline vec3 Interpolate(const vec3& a, const vec3& b, float t)
+    {
+        return lerp(a, b, t);
+    }
+
+    inline quat Interpolate(const quat& a, const quat& b, float t)
+    {
+        quat result = mix(a, b, t);
+        if (dot(a, b) < 0) // Neighborhood
+        {
+            result = mix(a, -b, t);
+        }
+        return normalized(result);
+    }
+
+    inline float AdjustHermiteResult(float f)
+    {
+        return f;
+    }
+
+    inline vec3 AdjustHermiteResult(const vec3& v)
+    {
+        return v;
+    }
+
+    inline quat AdjustHermiteResult(const quat& q)
+    {
+        return normalized(q);
+    }
+
+    inline void Neighborhood(const float&, float&) {}
+    inline void Neighborhood(const vec3&, vec3&) {}
+    inline void Neighborhood(const quat& a, quat& b)
+    {
+        if (dot(a, b) < 0)
+        {
+            b = -b;
+        }
+    }
+}
+
+template<typename T, int N>
+Track<T, N>::Track()
+{
+    mInterpolation = Interpolation::Linear;
+}
+
+template<typename T, int N>
+float Track<T, N>::GetStartTime() const
+{
+    return mFrames[0].mTime;
+}
+
+template<typename T, int N>
+float Track<T, N>::GetEndTime() const
+{
+    return mFrames[mFrames.size() - 1].mTime;
+}
+
+template<typename T, int N>
+T Track<T, N>::Sample(float time, bool looping) const
+{
+    unsigned int size = (unsigned int)mFrames.size();
+    if (size == 0)
+    {
+        return T();
+    }
+    if (size == 1)
+    {
+        return Cast(&mFrames[0].mValue[0]);
+    }
+
+    float trackTime = AdjustTimeToFitTrack(time, looping);
+    int frame = FrameIndex(trackTime, 0);
+
+    if (mInterpolation == Interpolation::Constant)
+    {
+        return SampleConstant(trackTime, frame);
+    }
+    else if (mInterpolation == Interpolation::Linear)
+    {
+        return SampleLinear(trackTime, frame);
+    }
+    return SampleCubic(trackTime, frame);
+}
+
+template<typename T, int N>
+T Track<T, N>::Sample(float time, bool looping, TrackCursor& cursor) const
+{
+    unsigned int size = (unsigned int)mFrames.size();
+    if (size == 0)
+    {
+        return T();
+    }
+    if (size == 1)
+    {
+        return Cast(&mFrames[0].mValue[0]);
+    }
+
+    float trackTime = AdjustTimeToFitTrack(time, looping);
+    int frame = FrameIndex(trackTime, &cursor);
+
+    if (mInterpolation == Interpolation::Constant)
+    {
+        return SampleConstant(trackTime, frame);
+    }
+    else if (mInterpolation == Interpolation::Linear)
+    {
+        return SampleLinear(trackTime, frame);
+    }
+    return SampleCubic(trackTime, frame);
+}
+
+template<typename T, int N>
+Frame<N>& Track<T, N>::operator[](unsigned int index)
+{
+    return mFrames[index];
+}
+
+template<typename T, int N>
+const Frame<N>& Track<T, N>::operator[](unsigned int index) const
+{
+    return mFrames[index];
+}
+
+template<typename T, int N>
+void Track<T, N>::Resize(unsigned int size)
+{
+    mFrames.resize(size);
+}
+
+template<typename T, int N>
+unsigned int Track<T, N>::Size() const
+{
+    return (unsigned int)mFrames.size();
+}
+
+template<typename T, int N>
+Interpolation Track<T, N>::GetInterpolation() const
+{
+    return mInterpolation;
+}
+
+template<typename T, int N>
+void Track<T, N>::SetInterpolation(Interpolation interpolation)
+{
+    mInterpolation = interpolation;
+}
+
+template<typename T, int N>
+T Track<T, N>::Hermite(float t, const T& p1, const T& s1, const T& _p2, const T& s2) const
+{
+    float tt = t * t;
+    float ttt = tt * t;
+
+    T p2 = _p2;
+    TrackHelpers::Neighborhood(p1, p2);
+
+    float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+    float h2 = -2.0f * ttt + 3.0f * tt;
+    float h3 = ttt - 2.0f * tt + t;
+    float h4 = ttt - tt;
+
+    T result = p1 * h1 + p2 * h2 + s1 * h3 + s2 * h4;
+    return TrackHelpers::AdjustHermiteResult(result);
+}
+
+template<typename T, int N>
+int Track<T, N>::SearchFrameIndex(float time) const
+{
+    // Last key at or before time, limited to keys that start a segment
+    int lo = 0;
+    int hi = (int)mFrames.size() - 2;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (mFrames[mid].mTime <= time)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+template<typename T, int N>
+int Track<T, N>::FrameIndex(float time, TrackCursor* cursor) const
+{
+    if (cursor == 0)
+    {
+        return SearchFrameIndex(time);
+    }
+
+    int last = (int)mFrames.size() - 2;
+    int frame = cursor->mFrame;
+    if (frame >= 0 && frame <= last && mFrames[frame].mTime <= time)
+    {
+        for (int step = 0; step <= TRACK_CURSOR_MAX_WALK; ++step)
+        {
+            if (frame == last || mFrames[frame + 1].mTime > time)
+            {
+                cursor->mFrame = frame;
+                return frame;
+            }
+            frame += 1;
+        }
+    }
+
+    frame = SearchFrameIndex(time);
+    cursor->mFrame = frame;
+    return frame;
+}
+
+template<typename T, int N>
+float Track<T, N>::AdjustTimeToFitTrack(float time, bool looping) const
+{
+    unsigned int size = (unsigned int)mFrames.size();
+    if (size <= 1)
+    {
+        return 0.0f;
+    }
+
+    float startTime = mFrames[0].mTime;
+    float endTime = mFrames[size - 1].mTime;
+    float duration = endTime - startTime;
+    if (duration <= 0.0f)
+    {
+        return startTime;
+    }
+
+    if (looping)
+    {
+        time = fmodf(time - startTime, duration);
+        if (time < 0.0f)
+        {
+            time += duration;
+        }
+        time = time + startTime;
+    }
+    else
+    {
+        if (time <= startTime)
+        {
+            time = startTime;
+        }
+        if (time >= endTime)
+        {
+            time = endTime;
+        }
+    }
+    return time;
+}
+
+template<> float Track<float, 1>::Cast(const float* value) const
+{
+    return value[0];
+}
+
+template<> vec3 Track<vec3, 3>::Cast(const float* value) const
+{
+    return vec3(value[0], value[1], value[2]);
+}
+
+template<> quat Track<quat, 4>::Cast(const float* value) const
+{
+    quat r = quat(value[0], value[1], value[2], value[3]);
+    return normalized(r);
+}
+
+template<typename T, int N>
+T Track<T, N>::SampleConstant(float time, int frame) const
+{
+    // The final key is only reached when time is clamped to the end
+    if (time >= mFrames[frame + 1].mTime)
+    {
+        return Cast(&mFrames[frame + 1].mValue[0]);
+    }
+    return Cast(&mFrames[frame].mValue[0]);
+}
+
+template<typename T, int N>
+T Track<T, N>::SampleLinear(float time, int frame) const
+{
+    int nextFrame = frame + 1;
+    float frameDelta = mFrames[nextFrame].mTime - mFrames[frame].mTime;
+    if (frameDelta <= 0.0f)
+    {
+        return Cast(&mFrames[frame].mValue[0]);
+    }
+
+    float t = (time - mFrames[frame].mTime) / frameDelta;
+    T start = Cast(&mFrames[frame].mValue[0]);
+    T end = Cast(&mFrames[nextFrame].mValue[0]);
+    return TrackHelpers::Interpolate(start, end, t);
+}
+
+template<typename T, int N>
+T Track<T, N>::SampleCubic(float time, int frame) const
+{
+    int nextFrame = frame + 1;
+    float frameDelta = mFrames[nextFrame].mTime - mFrames[frame].mTime;
+    if (frameDelta <= 0.0f)
+    {
+        return Cast(&mFrames[frame].mValue[0]);
+    }
+
+    float t = (time - mFrames[frame].mTime) / frameDelta;
+    size_t fltSize = sizeof(float);
+
+    // Tangents must not be normalized, so they bypass Cast
+    T point1 = Cast(&mFrames[frame].mValue[0]);
+    T slope1;
+    memcpy(&slope1, mFrames[frame].mOut, N * fltSize);
+    slope1 = slope1 * frameDelta;
+
+    T point2 = Cast(&mFrames[nextFrame].mValue[0]);
+    T slope2;
+    memcpy(&slope2, mFrames[nextFrame].mIn, N * fltSize);
+    slope2 = slope2 * frameDelta;
+
+    return Hermite(t, point1, slope1, point2, slope2);
+}
+
+template class Track<float, 1>;
+template class Track<vec3, 3>;
+template class Track<quat, 4>;
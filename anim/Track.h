@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include "../math/vec3.h"
+#include "../math/quat.h"
+
+enum class Interpolation
+{
+    Constant,
+    Linear,
+    Cubic
+};
+
+// One key. mIn / mOut are the incoming and outgoing tangents used by cubic tracks.
+template<unsigned int N>
+class Frame
+{
+public:
+    float mValue[N];
+    float mIn[N];
+    float mOut[N];
+    float mTime;
+};
+
+typedef Frame<1> ScalarFrame;
+typedef Frame<3> VectorFrame;
+typedef Frame<4> QuaternionFrame;
+
+// Per-instance playback position within a track. Forward playback walks the
+// cursor from the last key instead of searching, so sampling is O(1) amortized.
+// A seek (time moved backwards, looped, or jumped far ahead) falls back to a
+// binary search. One cursor per track per animated instance.
+struct TrackCursor
+{
+    int mFrame;
+
+    inline TrackCursor() : mFrame(-1) {}
+    inline void Reset() { mFrame = -1; }
+};
+
+template<typename T, int N>
+class Track
+{
+protected:
+    std::vector<Frame<N>> mFrames;
+    Interpolation mInterpolation;
+
+    T SampleConstant(float time, int frame) const;
+    T SampleLinear(float time, int frame) const;
+    T SampleCubic(float time, int frame) const;
+    T Hermite(float t, const T& p1, const T& s1, const T& p2, const T& s2) const;
+    // Index of the key at or before time (already fit to the track), using the cursor if given
+    int FrameIndex(float time, TrackCursor* cursor) const;
+    int SearchFrameIndex(float time) const;
+    float AdjustTimeToFitTrack(float time, bool looping) const;
+    T Cast(const float* value) const;
+
+public:
+    Track();
+    void Resize(unsigned int size);
+    unsigned int Size() const;
+    Interpolation GetInterpolation() const;
+    void SetInterpolation(Interpolation interpolation);
+    float GetStartTime() const;
+    float GetEndTime() const;
+
+    T Sample(float time, bool looping) const;
+    T Sample(float time, bool looping, TrackCursor& cursor) const;
+    Frame<N>& operator[](unsigned int index);
+    const Frame<N>& operator[](unsigned int index) const;
+};
+
+typedef Track<float, 1> ScalarTrack;
+typedef Track<vec3, 3> VectorTrack;
+typedef Track<quat, 4> QuaternionTrack;
@@ -0,0 +1,159 @@
+#include "TransformTrack.h"
+
+TransformTrack::TransformTrack()
+{
+    mId = 0;
+}
+
+unsigned int TransformTrack::GetId() const
+{
+    return mId;
+}
+
+void TransformTrack::SetId(unsigned int id)
+{
+    mId = id;
+}
+
+VectorTrack& TransformTrack::GetPositionTrack()
+{
+    return mPosition;
+}
+
+QuaternionTrack& TransformTrack::GetRotationTrack()
+{
+    return mRotation;
+}
+
+VectorTrack& TransformTrack::GetScaleTrack()
+{
+    return mScale;
+}
+
+const VectorTrack& TransformTrack::GetPositionTrack() const
+{
+    return mPosition;
+}
+
+const QuaternionTrack& TransformTrack::GetRotationTrack() const
+{
+    return mRotation;
+}
+
+const VectorTrack& TransformTrack::GetScaleTrack() const
+{
+    return mScale;
+}
+
+bool TransformTrack::IsValid() const
+{
+    return mPosition.Size() > 1 || mRotation.Size() > 1 || mScale.Size() > 1;
+}
+
+float TransformTrack::GetStartTime() const
+{
+    float result = 0.0f;
+    bool isSet = false;
+
+    if (mPosition.Size() > 1)
+    {
+        result = mPosition.GetStartTime();
+        isSet = true;
+    }
+    if (mRotation.Size() > 1)
+    {
+        float rotationStart = mRotation.GetStartTime();
+        if (rotationStart < result || !isSet)
+        {
+            result = rotationStart;
+            isSet = true;
+        }
+    }
+    if (mScale.Size() > 1)
+    {
+        float scaleStart = mScale.GetStartTime();
+        if (scaleStart < result || !isSet)
+        {
+            result = scaleStart;
+            isSet = true;
+        }
+    }
+
+    return result;
+}
+
+float TransformTrack::GetEndTime() const
+{
+    float result = 0.0f;
+    bool isSet = false;
+
+    if (mPosition.Size() > 1)
+    {
+        result = mPosition.GetEndTime();
+        isSet = true;
+    }
+    if (mRotation.Size() > 1)
+    {
+        float rotationEnd = mRotation.GetEndTime();
+        if (rotationEnd > result || !isSet)
+        {
+            result = rotationEnd;
+            isSet = true;
+        }
+    }
+    if (mScale.Size() > 1)
+    {
+        float scaleEnd = mScale.GetEndTime();
+        if (scaleEnd > result || !isSet)
+        {
+            result = scaleEnd;
+            isSet = true;
+        }
+    }
+
+    return result;
+}
+
+Transform TransformTrack::Sample(const Transform& ref, float time, bool looping) const
+{
+    Transform result = ref;
+    if (mPosition.Size() > 1)
+    {
+        result.position = mPosition.Sample(time, looping);
+    }
+    if (mRotation.Size() > 1)
+    {
+        result.rotation = mRotation.Sample(time, looping);
+    }
+    if (mScale.Size() > 1)
+    {
+        result.scale = mScale.Sample(time, looping);
+    }
+    return result;
+}
+
+Transform TransformTrack::Sample(const Transform& ref, float time, bool looping, TransformTrackCursor& cursor) const
+{
+    Transform result = ref;
+    if (mPosition.Size() > 1)
+    {
+        result.position = mPosition.Sample(time, looping, cursor.mPosition);
+    }
+    if (mRotation.Size() > 1)
+    {
+        result.rotation = mRotation.Sample(time, looping, cursor.mRotation);
+    }
+    if (mScale.Size() > 1)
+    {
+        result.scale = mScale.Sample(time, looping, cursor.mScale);
+    }
+    return result;
+}
+
+unsigned int TransformTrack::GetMemoryBytes() const
+{
+    return sizeof(TransformTrack) +
+        mPosition.Size() * sizeof(VectorFrame) +
+        mRotation.Size() * sizeof(QuaternionFrame) +
+        mScale.Size() * sizeof(VectorFrame);
+}
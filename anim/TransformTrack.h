@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Track.h"
+#include "../math/Transform.h"
+
+// Cursors for the three component tracks of one TransformTrack
+struct TransformTrackCursor
+{
+    TrackCursor mPosition;
+    TrackCursor mRotation;
+    TrackCursor mScale;
+};
+
+class TransformTrack
+{
+protected:
+    unsigned int mId;
+    VectorTrack mPosition;
+    QuaternionTrack mRotation;
+    VectorTrack mScale;
+
+public:
+    TransformTrack();
+    unsigned int GetId() const;
+    void SetId(unsigned int id);
+    VectorTrack& GetPositionTrack();
+    QuaternionTrack& GetRotationTrack();
+    VectorTrack& GetScaleTrack();
+    const VectorTrack& GetPositionTrack() const;
+    const QuaternionTrack& GetRotationTrack() const;
+    const VectorTrack& GetScaleTrack() const;
+    float GetStartTime() const;
+    float GetEndTime() const;
+    bool IsValid() const;
+    // Components without keys keep the value from ref
+    Transform Sample(const Transform& ref, float time, bool looping) const;
+    Transform Sample(const Transform& ref, float time, bool looping, TransformTrackCursor& cursor) const;
+    unsigned int GetMemoryBytes() const;
+};
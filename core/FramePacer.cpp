@@ -0,0 +1,183 @@
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "FramePacer.h"
+
+// Sleep is never trusted to be closer than this to the deadline
+#define FRAMEPACER_MIN_SPIN 0.0002
+// How quickly the overshoot estimate relaxes after a run of accurate sleeps
+#define FRAMEPACER_OVERSHOOT_DECAY 0.05
+
+double SystemFrameClock::Now()
+{
+    typedef std::chrono::steady_clock Clock;
+    static const Clock::time_point start = Clock::now();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void SystemFrameClock::Sleep(double inSeconds)
+{
+    std::this_thread::sleep_for(std::chrono::duration<double>(inSeconds));
+}
+
+void SystemFrameClock::Relax()
+{
+    std::this_thread::yield();
+}
+
+FramePacer::FramePacer(FrameClock* inClock)
+{
+    mClock = inClock;
+    mTargetFrameTime = 0.0;
+    mSleepOvershoot = 0.001;
+    mLastFrameEnd = mClock->Now();
+    mDeadline = mLastFrameEnd;
+    ResetStats();
+}
+
+void FramePacer::SetTargetRate(float inFramesPerSecond)
+{
+    if (inFramesPerSecond <= 0.0f)
+    {
+        mTargetFrameTime = 0.0;
+    }
+    else
+    {
+        mTargetFrameTime = 1.0 / (double)inFramesPerSecond;
+    }
+    mDeadline = mClock->Now() + mTargetFrameTime;
+}
+
+float FramePacer::GetTargetRate() const
+{
+    if (mTargetFrameTime <= 0.0)
+    {
+        return 0.0f;
+    }
+    return (float)(1.0 / mTargetFrameTime);
+}
+
+void FramePacer::Wait()
+{
+    double now = mClock->Now();
+
+    if (mTargetFrameTime > 0.0)
+    {
+        double waitStart = now;
+        double remaining = mDeadline - now;
+
+        if (remaining > mSleepOvershoot)
+        {
+            double request = remaining - mSleepOvershoot;
+            mClock->Sleep(request);
+            double woke = mClock->Now();
+
+            // Grow the estimate immediately on a late wakeup, shrink it slowly
+            double overshoot = (woke - now) - request;
+            if (overshoot > mSleepOvershoot)
+            {
+                mSleepOvershoot = overshoot;
+            }
+            else
+            {
+                mSleepOvershoot += (overshoot - mSleepOvershoot) * FRAMEPACER_OVERSHOOT_DECAY;
+            }
+            if (mSleepOvershoot < FRAMEPACER_MIN_SPIN)
+            {
+                mSleepOvershoot = FRAMEPACER_MIN_SPIN;
+            }
+            now = woke;
+        }
+
+        while (now < mDeadline)
+        {
+            mClock->Relax();
+            now = mClock->Now();
+        }
+
+        mWaitTime += now - waitStart;
+        mDeadline += mTargetFrameTime;
+        // A missed frame restarts the cadence instead of rushing to catch up
+        if (mDeadline < now)
+        {
+            mDeadline = now + mTargetFrameTime;
+        }
+    }
+
+    double interval = now - mLastFrameEnd;
+    mLastFrameEnd = now;
+
+    mFrames += 1;
+    mIntervalSum += interval;
+    mIntervalSumSq += interval * interval;
+    if (interval < mMinInterval)
+    {
+        mMinInterval = interval;
+    }
+    if (interval > mMaxInterval)
+    {
+        mMaxInterval = interval;
+    }
+    if (mTargetFrameTime > 0.0)
+    {
+        double deviation = interval - mTargetFrameTime;
+        mDeviationSumSq += deviation * deviation;
+        if (fabs(deviation) > mMaxDeviation)
+        {
+            mMaxDeviation = fabs(deviation);
+        }
+    }
+}
+
+FramePacerStats FramePacer::GetStats() const
+{
+    FramePacerStats result;
+    if (mFrames == 0)
+    {
+        return result;
+    }
+
+    double frames = (double)mFrames;
+    result.frames = mFrames;
+    result.averageFrameTime = mIntervalSum / frames;
+
+    if (mTargetFrameTime > 0.0)
+    {
+        result.jitter = sqrt(mDeviationSumSq / frames);
+        result.maxDeviation = mMaxDeviation;
+    }
+    else
+    {
+        double mean = result.averageFrameTime;
+        double variance = mIntervalSumSq / frames - mean * mean;
+        result.jitter = variance > 0.0 ? sqrt(variance) : 0.0;
+        result.maxDeviation = fmax(mMaxInterval - mean, mean - mMinInterval);
+    }
+
+    double elapsed = mLastFrameEnd - mStatsStart;
+    if (elapsed > 0.0)
+    {
+        result.cpuUtilisation = 1.0 - mWaitTime / elapsed;
+    }
+
+    return result;
+}
+
+void FramePacer::ResetStats()
+{
+    mStatsStart = mLastFrameEnd;
+    mWaitTime = 0.0;
+    mFrames = 0;
+    mIntervalSum = 0.0;
+    mIntervalSumSq = 0.0;
+    mDeviationSumSq = 0.0;
+    mMaxDeviation = 0.0;
+    mMinInterval = 1e30;
+    mMaxInterval = 0.0;
+}
+
+double FramePacer::GetSleepOvershoot() const
+{
+    return mSleepOvershoot;
+}
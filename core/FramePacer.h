@@ -0,0 +1,76 @@
+#pragma once
+
+// Time source used by the pacer. The default implementation wraps the OS clock;
+// a mock clock can be substituted to drive the pacer without a window or GPU.
+class FrameClock
+{
+public:
+    virtual ~FrameClock() = default;
+    // Monotonic time in seconds
+    virtual double Now() = 0;
+    // Coarse, OS scheduled sleep. May overshoot.
+    virtual void Sleep(double inSeconds) = 0;
+    // Gives up the remainder of the time slice while spin-waiting.
+    // (Not named Yield: windows.h defines Yield() as a macro.)
+    virtual void Relax() {}
+};
+
+class SystemFrameClock : public FrameClock
+{
+public:
+    double Now() override;
+    void Sleep(double inSeconds) override;
+    void Relax() override;
+};
+
+struct FramePacerStats
+{
+    unsigned int frames = 0;
+    double averageFrameTime = 0.0;
+    // RMS deviation of the frame interval from the target (or from the mean when unlimited)
+    double jitter = 0.0;
+    double maxDeviation = 0.0;
+    // Fraction of wall time the frame thread spent doing work instead of waiting
+    double cpuUtilisation = 0.0;
+};
+
+// Limits the frame rate with a hybrid sleep + spin wait. The thread sleeps until it
+// is within the expected sleep overshoot of the deadline and spins (yielding) for
+// the remainder, so the deadline is hit precisely without burning a whole core.
+class FramePacer
+{
+private:
+    FramePacer(const FramePacer&);
+    FramePacer& operator=(const FramePacer&);
+
+protected:
+    FrameClock* mClock;
+    double mTargetFrameTime;
+    double mSleepOvershoot;
+    double mDeadline;
+    double mLastFrameEnd;
+    double mStatsStart;
+    double mWaitTime;
+    unsigned int mFrames;
+    double mIntervalSum;
+    double mIntervalSumSq;
+    double mDeviationSumSq;
+    double mMaxDeviation;
+    double mMinInterval;
+    double mMaxInterval;
+
+public:
+    FramePacer(FrameClock* inClock);
+
+    // 0 disables limiting; Wait() then only records statistics.
+    void SetTargetRate(float inFramesPerSecond);
+    float GetTargetRate() const;
+
+    // Call once per frame after presenting. Blocks until the next frame is due.
+    void Wait();
+
+    FramePacerStats GetStats() const;
+    void ResetStats();
+    // Current estimate of how late the OS wakes the thread after a sleep
+    double GetSleepOvershoot() const;
+};
@@ -0,0 +1,353 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "JobSystem.h"
+
+// Failed searches for work before an idle worker sleeps
+#define JOBSYSTEM_IDLE_SPINS 64
+
+static_assert(sizeof(Job) == 2 * JOBSYSTEM_CACHE_LINE, "Job should fill two cache lines");
+
+namespace
+{
+    thread_local const JobSystem* sThreadSystem = 0;
+    thread_local unsigned int sThreadIndex = 0;
+}
+
+JobQueue::JobQueue()
+    : mJobs(new std::atomic<Job*>[JOBSYSTEM_MAX_JOBS]), mTop(0), mBottom(0)
+{
+    for (unsigned int i = 0; i < JOBSYSTEM_MAX_JOBS; ++i)
+    {
+        mJobs[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool JobQueue::Push(Job* job)
+{
+    long long bottom = mBottom.load(std::memory_order_relaxed);
+    long long top = mTop.load(std::memory_order_acquire);
+    if (bottom - top >= JOBSYSTEM_MAX_JOBS)
+    {
+        return false;
+    }
+    mJobs[bottom & (JOBSYSTEM_MAX_JOBS - 1)].store(job, std::memory_order_relaxed);
+    // Publishes the job contents to thieves that acquire mBottom
+    mBottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+Job* JobQueue::Pop()
+{
+    long long bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long top = mTop.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        // Empty
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    Job* job = mJobs[bottom & (JOBSYSTEM_MAX_JOBS - 1)].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last job: race any thief for it
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = 0;
+        }
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* JobQueue::Steal()
+{
+    long long top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long bottom = mBottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+    {
+        return 0;
+    }
+
+    Job* job = mJobs[top & (JOBSYSTEM_MAX_JOBS - 1)].load(std::memory_order_relaxed);
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return 0;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(unsigned int workerCount)
+    : mSleeping(0), mQuit(false)
+{
+    if (workerCount == 0)
+    {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    // Thread 0 is the creating thread
+    for (unsigned int i = 0; i <= workerCount; ++i)
+    {
+        std::unique_ptr<ThreadState> state(new ThreadState());
+        state->mJobStorage.reset(new unsigned char[JOBSYSTEM_MAX_JOBS * sizeof(Job) + JOBSYSTEM_CACHE_LINE - 1]);
+        uintptr_t address = (uintptr_t)state->mJobStorage.get();
+        address = (address + JOBSYSTEM_CACHE_LINE - 1) & ~(uintptr_t)(JOBSYSTEM_CACHE_LINE - 1);
+        state->mJobs = (Job*)address;
+        for (unsigned int j = 0; j < JOBSYSTEM_MAX_JOBS; ++j)
+        {
+            new (&state->mJobs[j]) Job();
+            state->mJobs[j].mUnfinished.store(0, std::memory_order_relaxed);
+        }
+        state->mRandom = 2654435761u * (i + 1);
+        mThreads.push_back(std::move(state));
+    }
+    sThreadSystem = this;
+    sThreadIndex = 0;
+
+    for (unsigned int i = 1; i <= workerCount; ++i)
+    {
+        mWorkers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    mQuit.store(true);
+    {
+        std::lock_guard<std::mutex> guard(mSleepLock);
+    }
+    mWake.notify_all();
+    for (unsigned int i = 0, size = (unsigned int)mWorkers.size(); i < size; ++i)
+    {
+        mWorkers[i].join();
+    }
+    if (sThreadSystem == this)
+    {
+        sThreadSystem = 0;
+    }
+}
+
+unsigned int JobSystem::GetWorkerCount() const
+{
+    return (unsigned int)mWorkers.size();
+}
+
+unsigned int JobSystem::ThreadIndex() const
+{
+    return sThreadSystem == this ? sThreadIndex : 0;
+}
+
+Job* JobSystem::Allocate(JobFunction function, const void* data, size_t size, Job* parent)
+{
+    if (size > JOBSYSTEM_JOB_DATA)
+    {
+        // Running the job without its data would silently skip work
+        std::cout << "ERROR: Job data of " << size << " bytes is larger than " << JOBSYSTEM_JOB_DATA << "\n";
+        std::cout.flush();
+        std::abort();
+    }
+
+    ThreadState& state = *mThreads[ThreadIndex()];
+    Job* job = &state.mJobs[state.mNextJob];
+    state.mNextJob = (state.mNextJob + 1) & (JOBSYSTEM_MAX_JOBS - 1);
+    // The ring has wrapped onto a job that is still alive: help until it finishes
+    Wait(job);
+
+    job->mFunction = function;
+    job->mParent = parent;
+    job->mUnfinished.store(1, std::memory_order_relaxed);
+    if (size > 0)
+    {
+        memcpy(job->mData, data, size);
+    }
+    if (parent != 0)
+    {
+        parent->mUnfinished.fetch_add(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* JobSystem::CreateJob(JobFunction function, const void* data, size_t size)
+{
+    return Allocate(function, data, size, 0);
+}
+
+Job* JobSystem::CreateChildJob(Job* parent, JobFunction function, const void* data, size_t size)
+{
+    return Allocate(function, data, size, parent);
+}
+
+void JobSystem::Run(Job* job)
+{
+    if (job == 0)
+    {
+        return;
+    }
+    if (!mThreads[ThreadIndex()]->mQueue.Push(job))
+    {
+        // Queue full: run it here rather than drop it
+        Execute(job);
+        return;
+    }
+    if (mSleeping.load(std::memory_order_relaxed) > 0)
+    {
+        mWake.notify_one();
+    }
+}
+
+Job* JobSystem::FindJob(unsigned int thread)
+{
+    ThreadState& state = *mThreads[thread];
+    Job* job = state.mQueue.Pop();
+    if (job != 0)
+    {
+        return job;
+    }
+
+    unsigned int count = (unsigned int)mThreads.size();
+    if (count < 2)
+    {
+        return 0;
+    }
+    // Start at a random victim so thieves spread out
+    state.mRandom ^= state.mRandom << 13;
+    state.mRandom ^= state.mRandom >> 17;
+    state.mRandom ^= state.mRandom << 5;
+    unsigned int start = state.mRandom % count;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int victim = (start + i) % count;
+        if (victim == thread)
+        {
+            continue;
+        }
+        job = mThreads[victim]->mQueue.Steal();
+        if (job != 0)
+        {
+            state.mStolen.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return 0;
+}
+
+void JobSystem::Execute(Job* job)
+{
+    job->mFunction(*this, job, job->mData);
+    mThreads[ThreadIndex()]->mExecuted.fetch_add(1, std::memory_order_relaxed);
+    Finish(job);
+}
+
+void JobSystem::Finish(Job* job)
+{
+    while (job != 0)
+    {
+        Job* parent = job->mParent;
+        if (job->mUnfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+        job = parent;
+    }
+}
+
+bool JobSystem::IsFinished(const Job* job) const
+{
+    return job == 0 || job->mUnfinished.load(std::memory_order_acquire) <= 0;
+}
+
+void JobSystem::Wait(const Job* job)
+{
+    unsigned int thread = ThreadIndex();
+    while (!IsFinished(job))
+    {
+        Job* next = FindJob(thread);
+        if (next != 0)
+        {
+            Execute(next);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerLoop(unsigned int thread)
+{
+    sThreadSystem = this;
+    sThreadIndex = thread;
+
+    unsigned int idle = 0;
+    while (!mQuit.load(std::memory_order_relaxed))
+    {
+        Job* job = FindJob(thread);
+        if (job != 0)
+        {
+            Execute(job);
+            idle = 0;
+            continue;
+        }
+
+        idle += 1;
+        if (idle < JOBSYSTEM_IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // The timeout covers a Run that checked mSleeping just before it was raised
+        mSleeping.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(mSleepLock);
+            if (!mQuit.load())
+            {
+                mWake.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+        mSleeping.fetch_sub(1);
+        idle = 0;
+    }
+}
+
+void JobSystem::RangeJob(JobSystem& system, Job* job, const void* data)
+{
+    RangeData range = *(const RangeData*)data;
+    // Hand off the upper half until the piece left is one grain
+    while (range.mEnd - range.mBegin > range.mGrain)
+    {
+        RangeData upper = range;
+        upper.mBegin = range.mBegin + (range.mEnd - range.mBegin) / 2;
+        range.mEnd = upper.mBegin;
+        system.Run(system.CreateChildJob(job, &JobSystem::RangeJob, &upper, sizeof(upper)));
+    }
+    range.mInvoke(range.mBody, range.mBegin, range.mEnd);
+}
+
+void JobSystem::RunRange(const RangeData& range)
+{
+    Job* root = CreateJob(&JobSystem::RangeJob, &range, sizeof(range));
+    Run(root);
+    Wait(root);
+}
+
+JobSystemStats JobSystem::GetStats() const
+{
+    JobSystemStats stats;
+    for (unsigned int i = 0, size = (unsigned int)mThreads.size(); i < size; ++i)
+    {
+        stats.executed += mThreads[i]->mExecuted.load(std::memory_order_relaxed);
+        stats.stolen += mThreads[i]->mStolen.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
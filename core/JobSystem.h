@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Jobs each thread can have alive at once. Job storage is a per thread ring;
+// when it wraps onto a job that has not finished, creating a job runs other jobs
+// until it has. A thread must not hold more than this many jobs it has created
+// but not yet run (or is itself inside), or that wait never ends.
+#define JOBSYSTEM_MAX_JOBS 4096
+// Bytes of user data copied into each job
+#define JOBSYSTEM_JOB_DATA 80
+#define JOBSYSTEM_CACHE_LINE 64
+
+class JobSystem;
+struct Job;
+
+typedef void (*JobFunction)(JobSystem& system, Job* job, const void* data);
+
+// Starts on a cache line and is padded to a whole number of them, so jobs written
+// by different threads don't share one. Job rings are allocated to match (see
+// JobSystem::ThreadState).
+struct alignas(JOBSYSTEM_CACHE_LINE) Job
+{
+    JobFunction mFunction;
+    Job* mParent;
+    // This job plus its unfinished children
+    std::atomic<int> mUnfinished;
+    unsigned char mData[JOBSYSTEM_JOB_DATA];
+};
+
+// Chase-Lev work-stealing deque. The owning thread pushes and pops at the
+// bottom, other threads steal from the top.
+class JobQueue
+{
+private:
+    JobQueue(const JobQueue&);
+    JobQueue& operator=(const JobQueue&);
+
+protected:
+    std::unique_ptr<std::atomic<Job*>[]> mJobs;
+    std::atomic<long long> mTop;
+    std::atomic<long long> mBottom;
+
+public:
+    JobQueue();
+    // Owner only. False when full.
+    bool Push(Job* job);
+    // Owner only
+    Job* Pop();
+    // Any thread
+    Job* Steal();
+};
+
+struct JobSystemStats
+{
+    unsigned long long executed = 0;
+    unsigned long long stolen = 0;
+};
+
+// Work-stealing job system. Every thread, the main thread included, owns a deque.
+// Jobs run where they were pushed unless an idle thread steals them. A job can
+// have children; it counts as finished only once they all have, so waiting on
+// the root of a tree waits for the tree. Waiting threads run jobs instead of
+// blocking.
+//
+// Only the thread that created the JobSystem and its workers may create, run
+// and wait on jobs.
+class JobSystem
+{
+private:
+    JobSystem(const JobSystem&);
+    JobSystem& operator=(const JobSystem&);
+
+protected:
+    struct ThreadState
+    {
+        JobQueue mQueue;
+        // new Job[] isn't guaranteed to honour Job's alignment before C++17, so
+        // the ring is placed on the first cache line inside a larger buffer
+        std::unique_ptr<unsigned char[]> mJobStorage;
+        Job* mJobs = 0;
+        unsigned int mNextJob = 0;
+        unsigned int mRandom = 0;
+        std::atomic<unsigned long long> mExecuted;
+        std::atomic<unsigned long long> mStolen;
+
+        ThreadState() : mExecuted(0), mStolen(0) {}
+    };
+
+    std::vector<std::unique_ptr<ThreadState>> mThreads;
+    std::vector<std::thread> mWorkers;
+    std::mutex mSleepLock;
+    std::condition_variable mWake;
+    std::atomic<int> mSleeping;
+    std::atomic<bool> mQuit;
+
+    unsigned int ThreadIndex() const;
+    Job* Allocate(JobFunction function, const void* data, size_t size, Job* parent);
+    Job* FindJob(unsigned int thread);
+    void Execute(Job* job);
+    void Finish(Job* job);
+    void WorkerLoop(unsigned int thread);
+
+    struct RangeData
+    {
+        void (*mInvoke)(const void* body, unsigned int begin, unsigned int end);
+        const void* mBody;
+        unsigned int mBegin;
+        unsigned int mEnd;
+        unsigned int mGrain;
+    };
+    static void RangeJob(JobSystem& system, Job* job, const void* data);
+
+    template <typename F>
+    static void InvokeRange(const void* body, unsigned int begin, unsigned int end)
+    {
+        (*(const F*)body)(begin, end);
+    }
+
+    void RunRange(const RangeData& range);
+
+public:
+    // 0 picks one worker per hardware thread, minus the calling thread
+    JobSystem(unsigned int workerCount = 0);
+    ~JobSystem();
+
+    unsigned int GetWorkerCount() const;
+
+    // data is copied into the job. More than JOBSYSTEM_JOB_DATA bytes is a fatal
+    // error.
+    Job* CreateJob(JobFunction function, const void* data = 0, size_t size = 0);
+    // parent does not finish until the child has; create children before running
+    // the parent or from inside it
+    Job* CreateChildJob(Job* parent, JobFunction function, const void* data = 0, size_t size = 0);
+    void Run(Job* job);
+    // Runs other jobs until job and its children have finished
+    void Wait(const Job* job);
+    bool IsFinished(const Job* job) const;
+
+    // Calls body(begin, end) over [0, count) in parallel and waits. The range is
+    // split in halves down to a grain sized from the count and the thread count
+    // (never below minChunk), so idle threads steal large pieces first.
+    template <typename F>
+    void ParallelFor(unsigned int count, const F& body, unsigned int minChunk = 1)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        RangeData range;
+        range.mInvoke = &InvokeRange<F>;
+        range.mBody = &body;
+        range.mBegin = 0;
+        range.mEnd = count;
+        unsigned int pieces = (unsigned int)mThreads.size() * 4;
+        range.mGrain = (count + pieces - 1) / pieces;
+        if (range.mGrain < minChunk)
+        {
+            range.mGrain = minChunk;
+        }
+        if (range.mGrain < 1)
+        {
+            range.mGrain = 1;
+        }
+        RunRange(range);
+    }
+
+    JobSystemStats GetStats() const;
+};
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <string.h>
+#include "glad_lazy.h"
+
+static GLADloadproc glad_lazy_loader = NULL;
+static int glad_lazy_resolved = 0;
+static int glad_lazy_missing = 0;
+
+static void* glad_lazy_resolve(const char *name) {
+    void* result = NULL;
+    if(glad_lazy_loader != NULL) {
+        result = glad_lazy_loader(name);
+    }
+    if(result != NULL) {
+        glad_lazy_resolved++;
+    } else {
+        glad_lazy_missing++;
+    }
+    return result;
+}
+
+/*
+    One resolved-pointer cache and one trampoline per listed function. The
+    trampoline only patches the glad pointer if it still points at the stub, so
+    a layer wrapped around it (see GLTrace) keeps working; it then calls
+    through the cache and never resolves twice.
+*/
+#define GLAD_LAZY_PROC(ret, name, type, params, args) \
+    static type glad_lazy_real_##name = NULL; \
+    static ret APIENTRY glad_lazy_stub_##name params { \
+        if(glad_lazy_real_##name == NULL) { \
+            glad_lazy_real_##name = (type)glad_lazy_resolve(#name); \
+            if(glad_##name == glad_lazy_stub_##name) glad_##name = glad_lazy_real_##name; \
+        } \
+        return glad_lazy_real_##name args; \
+    }
+#define GLAD_LAZY_VOID(name, type, params, args) \
+    static type glad_lazy_real_##name = NULL; \
+    static void APIENTRY glad_lazy_stub_##name params { \
+        if(glad_lazy_real_##name == NULL) { \
+            glad_lazy_real_##name = (type)glad_lazy_resolve(#name); \
+            if(glad_##name == glad_lazy_stub_##name) glad_##name = glad_lazy_real_##name; \
+        } \
+        glad_lazy_real_##name args; \
+    }
+#include "glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+static int glad_lazy_begin(GLADloadproc load) {
+    const char *version;
+    int major = 0;
+    int minor = 0;
+
+    glad_lazy_loader = load;
+    glad_lazy_resolved = 0;
+    glad_lazy_missing = 0;
+    /* Forget anything resolved against a previous context */
+#define GLAD_LAZY_PROC(ret, name, type, params, args) glad_lazy_real_##name = NULL;
+#define GLAD_LAZY_VOID(name, type, params, args) glad_lazy_real_##name = NULL;
+#include "glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+    GLVersion.major = 0; GLVersion.minor = 0;
+    glad_lazy_real_glGetString = (PFNGLGETSTRINGPROC)glad_lazy_resolve("glGetString");
+    glad_glGetString = glad_lazy_real_glGetString;
+    if(glad_glGetString == NULL) return 0;
+
+    version = (const char*) glad_glGetString(GL_VERSION);
+    if(version == NULL) return 0;
+
+#ifdef _MSC_VER
+    sscanf_s(version, "%d.%d", &major, &minor);
+#else
+    sscanf(version, "%d.%d", &major, &minor);
+#endif
+    GLVersion.major = major; GLVersion.minor = minor;
+    return major != 0 || minor != 0;
+}
+
+int gladLoadGLLazy(GLADloadproc load) {
+    if(!glad_lazy_begin(load)) return 0;
+
+#define GLAD_LAZY_PROC(ret, name, type, params, args) \
+    if(glad_lazy_real_##name == NULL) glad_##name = glad_lazy_stub_##name;
+#define GLAD_LAZY_VOID(name, type, params, args) \
+    if(glad_lazy_real_##name == NULL) glad_##name = glad_lazy_stub_##name;
+#include "glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+    return 1;
+}
+
+int gladLoadGLAllowList(GLADloadproc load) {
+    if(!glad_lazy_begin(load)) return 0;
+
+#define GLAD_LAZY_PROC(ret, name, type, params, args) \
+    if(glad_lazy_real_##name == NULL) glad_lazy_real_##name = (type)glad_lazy_resolve(#name); \
+    glad_##name = glad_lazy_real_##name;
+#define GLAD_LAZY_VOID(name, type, params, args) \
+    if(glad_lazy_real_##name == NULL) glad_lazy_real_##name = (type)glad_lazy_resolve(#name); \
+    glad_##name = glad_lazy_real_##name;
+#include "glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+    return 1;
+}
+
+int gladLazyResolvedCount(void) {
+    return glad_lazy_resolved;
+}
+
+int gladLazyMissingCount(void) {
+    return glad_lazy_missing;
+}
+
+int gladLazyListSize(void) {
+    int count = 0;
+#define GLAD_LAZY_PROC(ret, name, type, params, args) count++;
+#define GLAD_LAZY_VOID(name, type, params, args) count++;
+#include "glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+    return count;
+}
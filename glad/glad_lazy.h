@@ -0,0 +1,36 @@
+#ifndef __glad_lazy_h_
+#define __glad_lazy_h_
+
+#include "glad.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Alternatives to gladLoadGL/gladLoadGLLoader that only touch the entry points
+    listed in glad_lazy_list.h (regenerate it with tools/gen_glad_allowlist.py).
+    Functions outside the list are left unloaded.
+
+    gladLoadGLLazy installs trampoline stubs. The first call through a stub
+    resolves the real function with the loader, patches the glad pointer and
+    forwards the call, so startup resolves nothing but glGetString.
+
+    gladLoadGLAllowList resolves every listed function immediately.
+
+    The loader must stay valid for as long as lazy stubs may be called.
+*/
+GLAPI int gladLoadGLLazy(GLADloadproc load);
+GLAPI int gladLoadGLAllowList(GLADloadproc load);
+
+/* Number of entry points resolved so far, and the number the loader could not find */
+GLAPI int gladLazyResolvedCount(void);
+GLAPI int gladLazyMissingCount(void);
+/* Number of entry points in the allow-list */
+GLAPI int gladLazyListSize(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
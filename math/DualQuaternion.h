@@ -0,0 +1,38 @@
+#pragma once
+
+#include "quat.h"
+#include "Transform.h"
+
+// Rigid transform (rotation + translation, no scale) in 8 floats. Composes and
+// blends without the volume loss of blended matrices.
+// No float v[8] union: quat has constructors, which an anonymous struct cannot
+// hold portably. The assert below guarantees the two halves are contiguous.
+struct DualQuaternion {
+    quat real;
+    quat dual;
+
+    inline DualQuaternion() : real(0, 0, 0, 1), dual(0, 0, 0, 0) {}
+    inline DualQuaternion(const quat& r, const quat& d) : real(r), dual(d) {}
+};
+
+static_assert(sizeof(DualQuaternion) == 8 * sizeof(float), "DualQuaternion must be eight packed floats");
+
+DualQuaternion operator+(const DualQuaternion& l, const DualQuaternion& r);
+DualQuaternion operator*(const DualQuaternion& dq, float f);
+// Same order as quat and combine: l is applied first, then r
+DualQuaternion operator*(const DualQuaternion& l, const DualQuaternion& r);
+bool operator==(const DualQuaternion& l, const DualQuaternion& r);
+bool operator!=(const DualQuaternion& l, const DualQuaternion& r);
+
+float dot(const DualQuaternion& l, const DualQuaternion& r);
+// The inverse of a unit dual quaternion
+DualQuaternion conjugate(const DualQuaternion& dq);
+DualQuaternion normalized(const DualQuaternion& dq);
+void normalize(DualQuaternion& dq);
+
+// Scale is dropped
+DualQuaternion transformToDualQuat(const Transform& t);
+Transform dualQuatToTransform(const DualQuaternion& dq);
+
+vec3 transformVector(const DualQuaternion& dq, const vec3& v);
+vec3 transformPoint(const DualQuaternion& dq, const vec3& v);
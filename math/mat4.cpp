@@ -0,0 +1,230 @@
+#include <cmath>
+#include <iostream>
+
+#include "mat4.h"
+
+bool operator==(const mat4& a, const mat4& b)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        if (fabsf(a.v[i] - b.v[i]) > MAT4_EPSILON)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool operator!=(const mat4& a, const mat4& b)
+{
+    return !(a == b);
+}
+
+mat4 operator+(const mat4& a, const mat4& b)
+{
+    mat4 result;
+    for (int i = 0; i < 16; ++i)
+    {
+        result.v[i] = a.v[i] + b.v[i];
+    }
+    return result;
+}
+
+mat4 operator*(const mat4& m, float f)
+{
+    mat4 result;
+    for (int i = 0; i < 16; ++i)
+    {
+        result.v[i] = m.v[i] * f;
+    }
+    return result;
+}
+
+// Row of a times column of b
+#define M4D(aRow, bCol) \
+    a.v[0 * 4 + aRow] * b.v[bCol * 4 + 0] + \
+    a.v[1 * 4 + aRow] * b.v[bCol * 4 + 1] + \
+    a.v[2 * 4 + aRow] * b.v[bCol * 4 + 2] + \
+    a.v[3 * 4 + aRow] * b.v[bCol * 4 + 3]
+
+mat4 operator*(const mat4& a, const mat4& b)
+{
+    return mat4(
+        M4D(0, 0), M4D(1, 0), M4D(2, 0), M4D(3, 0), // Column 0
+        M4D(0, 1), M4D(1, 1), M4D(2, 1), M4D(3, 1), // Column 1
+        M4D(0, 2), M4D(1, 2), M4D(2, 2), M4D(3, 2), // Column 2
+        M4D(0, 3), M4D(1, 3), M4D(2, 3), M4D(3, 3)  // Column 3
+    );
+}
+
+#define M4V3D(mRow, x, y, z, w) \
+    x * m.v[0 * 4 + mRow] + \
+    y * m.v[1 * 4 + mRow] + \
+    z * m.v[2 * 4 + mRow] + \
+    w * m.v[3 * 4 + mRow]
+
+vec3 transformVector(const mat4& m, const vec3& v)
+{
+    return vec3(
+        M4V3D(0, v.x, v.y, v.z, 0.0f),
+        M4V3D(1, v.x, v.y, v.z, 0.0f),
+        M4V3D(2, v.x, v.y, v.z, 0.0f)
+    );
+}
+
+vec3 transformPoint(const mat4& m, const vec3& v)
+{
+    return vec3(
+        M4V3D(0, v.x, v.y, v.z, 1.0f),
+        M4V3D(1, v.x, v.y, v.z, 1.0f),
+        M4V3D(2, v.x, v.y, v.z, 1.0f)
+    );
+}
+
+#define M4SWAP(x, y) \
+    {float t = x; x = y; y = t; }
+
+void transpose(mat4& m)
+{
+    M4SWAP(m.yx, m.xy);
+    M4SWAP(m.zx, m.xz);
+    M4SWAP(m.tx, m.xw);
+    M4SWAP(m.zy, m.yz);
+    M4SWAP(m.ty, m.yw);
+    M4SWAP(m.tz, m.zw);
+}
+
+mat4 transposed(const mat4& m)
+{
+    return mat4(
+        m.xx, m.yx, m.zx, m.tx,
+        m.xy, m.yy, m.zy, m.ty,
+        m.xz, m.yz, m.zz, m.tz,
+        m.xw, m.yw, m.zw, m.tw
+    );
+}
+
+// Minor of the element at (r, c), found from the 3x3 left after removing row r, column c
+#define M4_3X3MINOR(c0, c1, c2, r0, r1, r2) \
+    (m.v[c0 * 4 + r0] * (m.v[c1 * 4 + r1] * m.v[c2 * 4 + r2] - m.v[c1 * 4 + r2] * m.v[c2 * 4 + r1]) - \
+     m.v[c1 * 4 + r0] * (m.v[c0 * 4 + r1] * m.v[c2 * 4 + r2] - m.v[c0 * 4 + r2] * m.v[c2 * 4 + r1]) + \
+     m.v[c2 * 4 + r0] * (m.v[c0 * 4 + r1] * m.v[c1 * 4 + r2] - m.v[c0 * 4 + r2] * m.v[c1 * 4 + r1]))
+
+float determinant(const mat4& m)
+{
+    return m.v[0] * M4_3X3MINOR(1, 2, 3, 1, 2, 3)
+        - m.v[4] * M4_3X3MINOR(0, 2, 3, 1, 2, 3)
+        + m.v[8] * M4_3X3MINOR(0, 1, 3, 1, 2, 3)
+        - m.v[12] * M4_3X3MINOR(0, 1, 2, 1, 2, 3);
+}
+
+mat4 adjugate(const mat4& m)
+{
+    // Cofactor(M[i, j]) = Minor(M[i, j]] * pow(-1, i + j)
+    mat4 cofactor;
+
+    cofactor.v[0] = M4_3X3MINOR(1, 2, 3, 1, 2, 3);
+    cofactor.v[1] = -M4_3X3MINOR(1, 2, 3, 0, 2, 3);
+    cofactor.v[2] = M4_3X3MINOR(1, 2, 3, 0, 1, 3);
+    cofactor.v[3] = -M4_3X3MINOR(1, 2, 3, 0, 1, 2);
+
+    cofactor.v[4] = -M4_3X3MINOR(0, 2, 3, 1, 2, 3);
+    cofactor.v[5] = M4_3X3MINOR(0, 2, 3, 0, 2, 3);
+    cofactor.v[6] = -M4_3X3MINOR(0, 2, 3, 0, 1, 3);
+    cofactor.v[7] = M4_3X3MINOR(0, 2, 3, 0, 1, 2);
+
+    cofactor.v[8] = M4_3X3MINOR(0, 1, 3, 1, 2, 3);
+    cofactor.v[9] = -M4_3X3MINOR(0, 1, 3, 0, 2, 3);
+    cofactor.v[10] = M4_3X3MINOR(0, 1, 3, 0, 1, 3);
+    cofactor.v[11] = -M4_3X3MINOR(0, 1, 3, 0, 1, 2);
+
+    cofactor.v[12] = -M4_3X3MINOR(0, 1, 2, 1, 2, 3);
+    cofactor.v[13] = M4_3X3MINOR(0, 1, 2, 0, 2, 3);
+    cofactor.v[14] = -M4_3X3MINOR(0, 1, 2, 0, 1, 3);
+    cofactor.v[15] = M4_3X3MINOR(0, 1, 2, 0, 1, 2);
+
+    return transposed(cofactor);
+}
+
+mat4 inverse(const mat4& m)
+{
+    float det = determinant(m);
+
+    if (det == 0.0f)
+    {
+        std::cout << "WARNING: Trying to invert a matrix with a zero determinant\n";
+        return mat4();
+    }
+    mat4 adj = adjugate(m);
+
+    return adj * (1.0f / det);
+}
+
+void invert(mat4& m)
+{
+    m = inverse(m);
+}
+
+mat4 frustum(float l, float r, float b, float t, float n, float f)
+{
+    if (l == r || t == b || n == f)
+    {
+        std::cout << "WARNING: Trying to create invalid frustum\n";
+        return mat4();
+    }
+    return mat4(
+        (2.0f * n) / (r - l), 0, 0, 0,
+        0, (2.0f * n) / (t - b), 0, 0,
+        (r + l) / (r - l), (t + b) / (t - b), (-(f + n)) / (f - n), -1,
+        0, 0, (-2 * f * n) / (f - n), 0
+    );
+}
+
+mat4 perspective(float fov, float aspect, float znear, float zfar)
+{
+    float ymax = znear * tanf(fov * 3.14159265359f / 360.0f);
+    float xmax = ymax * aspect;
+
+    return frustum(-xmax, xmax, -ymax, ymax, znear, zfar);
+}
+
+mat4 ortho(float l, float r, float b, float t, float n, float f)
+{
+    if (l == r || t == b || n == f)
+    {
+        return mat4();
+    }
+    return mat4(
+        2.0f / (r - l), 0, 0, 0,
+        0, 2.0f / (t - b), 0, 0,
+        0, 0, -2.0f / (f - n), 0,
+        -((r + l) / (r - l)), -((t + b) / (t - b)), -((f + n) / (f - n)), 1
+    );
+}
+
+mat4 lookAt(const vec3& position, const vec3& target, const vec3& up)
+{
+    // Forward is negative z
+    vec3 f = normalized(target - position) * -1.0f;
+    vec3 r = cross(up, f);
+    if (r == vec3(0, 0, 0))
+    {
+        return mat4();
+    }
+    normalize(r);
+    vec3 u = normalized(cross(f, r));
+
+    vec3 t = vec3(
+        -dot(r, position),
+        -dot(u, position),
+        -dot(f, position)
+    );
+
+    return mat4(
+        // Transpose upper 3x3 matrix to invert it
+        r.x, u.x, f.x, 0,
+        r.y, u.y, f.y, 0,
+        r.z, u.z, f.z, 0,
+        t.x, t.y, t.z, 1
+    );
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vec3.h"
+
+#define MAT4_EPSILON 0.000001f
+
+// Column major. xx, xy, xz, xw is the first column (the basis right vector),
+// tx, ty, tz, tw the last (the translation).
+struct mat4 {
+    union {
+        float v[16];
+        struct {
+            float xx; float xy; float xz; float xw;
+            float yx; float yy; float yz; float yw;
+            float zx; float zy; float zz; float zw;
+            float tx; float ty; float tz; float tw;
+        };
+    };
+
+    inline mat4() :
+        xx(1), xy(0), xz(0), xw(0),
+        yx(0), yy(1), yz(0), yw(0),
+        zx(0), zy(0), zz(1), zw(0),
+        tx(0), ty(0), tz(0), tw(1) {}
+
+    inline mat4(const float* fv) :
+        xx(fv[0]), xy(fv[1]), xz(fv[2]), xw(fv[3]),
+        yx(fv[4]), yy(fv[5]), yz(fv[6]), yw(fv[7]),
+        zx(fv[8]), zy(fv[9]), zz(fv[10]), zw(fv[11]),
+        tx(fv[12]), ty(fv[13]), tz(fv[14]), tw(fv[15]) {}
+
+    inline mat4(
+        float _00, float _01, float _02, float _03,
+        float _10, float _11, float _12, float _13,
+        float _20, float _21, float _22, float _23,
+        float _30, float _31, float _32, float _33) :
+        xx(_00), xy(_01), xz(_02), xw(_03),
+        yx(_10), yy(_11), yz(_12), yw(_13),
+        zx(_20), zy(_21), zz(_22), zw(_23),
+        tx(_30), ty(_31), tz(_32), tw(_33) {}
+};
+
+bool operator==(const mat4& a, const mat4& b);
+bool operator!=(const mat4& a, const mat4& b);
+mat4 operator+(const mat4& a, const mat4& b);
+mat4 operator*(const mat4& m, float f);
+mat4 operator*(const mat4& a, const mat4& b);
+
+// w = 0
+vec3 transformVector(const mat4& m, const vec3& v);
+// w = 1
+vec3 transformPoint(const mat4& m, const vec3& v);
+
+void transpose(mat4& m);
+mat4 transposed(const mat4& m);
+float determinant(const mat4& m);
+mat4 adjugate(const mat4& m);
+mat4 inverse(const mat4& m);
+void invert(mat4& m);
+
+mat4 frustum(float l, float r, float b, float t, float n, float f);
+mat4 perspective(float fov, float aspect, float znear, float zfar);
+mat4 ortho(float l, float r, float b, float t, float n, float f);
+mat4 lookAt(const vec3& position, const vec3& target, const vec3& up);
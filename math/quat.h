@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vec3.h"
+#include "mat4.h"
+
+#define QUAT_EPSILON 0.000001f
+
+struct quat {
+    union {
+        struct {
+            float x;
+            float y;
+            float z;
+            float w;
+        };
+        float v[4];
+    };
+
+    inline quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+    inline quat(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+};
+
+// Construction
+
+quat angleAxis(float angle, const vec3& axis);
+quat fromTo(const vec3& from, const vec3& to);
+vec3 getAxis(const quat& q);
+float getAngle(const quat& q);
+
+// Component wise operations
+
+quat operator+(const quat& a, const quat& b);
+quat operator-(const quat& a, const quat& b);
+quat operator*(const quat& a, float b);
+quat operator-(const quat& q);
+bool operator==(const quat& left, const quat& right);
+bool operator!=(const quat& a, const quat& b);
+// True if both quaternions represent the same rotation (q and -q)
+bool sameOrientation(const quat& left, const quat& right);
+
+float dot(const quat& a, const quat& b);
+float lenSq(const quat& q);
+float len(const quat& q);
+
+void normalize(quat& q);
+quat normalized(const quat& q);
+quat conjugate(const quat& q);
+quat inverse(const quat& q);
+
+// Rotations compose left to right: q1 * q2 applies q1 first, then q2
+quat operator*(const quat& Q1, const quat& Q2);
+vec3 operator*(const quat& q, const vec3& v);
+
+// Interpolation. Callers are responsible for the neighborhood (dot < 0) check.
+quat mix(const quat& from, const quat& to, float t);
+quat nlerp(const quat& from, const quat& to, float t);
+quat operator^(const quat& q, float f);
+quat slerp(const quat& start, const quat& end, float t);
+
+quat lookRotation(const vec3& direction, const vec3& up);
+
+mat4 quatToMat4(const quat& q);
+// Expects an orthogonal, unscaled rotation in the upper 3x3
+quat mat4ToQuat(const mat4& m);
@@ -0,0 +1,10 @@
+#pragma once
+
+// SSE is baseline on every platform the project targets (x64, and Win32 where
+// MSVC defaults to /arch:SSE2). Kernels keep a scalar path for anything else.
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MATH_SSE 1
+#include <emmintrin.h>
+#else
+#define MATH_SSE 0
+#endif
@@ -0,0 +1,270 @@
+#include <iostream>
+#include "../glad/glad.h"
+#include "DebugDraw.h"
+#include "Shader.h"
+
+static const char* sDebugVertexSource =
+    "#version 330 core\n"
+    "uniform mat4 viewProjection;\n"
+    "in vec3 position;\n"
+    "in vec3 color;\n"
+    "out vec3 vertexColor;\n"
+    "void main() {\n"
+    "    vertexColor = color;\n"
+    "    gl_Position = viewProjection * vec4(position, 1.0);\n"
+    "}\n";
+
+static const char* sDebugFragmentSource =
+    "#version 330 core\n"
+    "in vec3 vertexColor;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    FragColor = vec4(vertexColor, 1.0);\n"
+    "}\n";
+
+DebugDraw::DebugDraw(unsigned int maxPoints, unsigned int maxLineVertices)
+    : mPointCount(0), mLineCount(0), mDropped(0)
+{
+    // Lines are always whole
+    maxLineVertices &= ~1u;
+    mPoints.resize(maxPoints);
+    mLines.resize(maxLineVertices);
+    mDroppedLastFlush = 0;
+    mVertexBuffer = 0;
+    mShader = 0;
+    mPositionSlot = -1;
+    mColorSlot = -1;
+    mViewProjectionSlot = -1;
+    mWarnedMissingAttributes = false;
+}
+
+DebugDraw::~DebugDraw()
+{
+    // GL resources must be released with Release() while the context is current
+}
+
+void DebugDraw::Initialize()
+{
+    mShader = new Shader(sDebugVertexSource, sDebugFragmentSource);
+    mPositionSlot = mShader->GetAttribute(Shader::Intern("position"));
+    mColorSlot = mShader->GetAttribute(Shader::Intern("color"));
+    mViewProjectionSlot = mShader->GetUniform(Shader::Intern("viewProjection"));
+
+    // One buffer for the frame: points first, lines after. Sized once, orphaned every flush.
+    glGenBuffers(1, &mVertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (mPoints.size() + mLines.size()) * sizeof(DebugVertex), 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DebugDraw::Release()
+{
+    if (mVertexBuffer != 0)
+    {
+        glDeleteBuffers(1, &mVertexBuffer);
+        mVertexBuffer = 0;
+    }
+    delete mShader;
+    mShader = 0;
+}
+
+// Claims count slots below capacity. The counter only advances when the whole
+// range fits, so it never passes the last slot handed out and everything below
+// it is written by the frame's producers.
+static bool Reserve(std::atomic<unsigned int>& counter, unsigned int capacity, unsigned int count, unsigned int& outStart)
+{
+    unsigned int start = counter.load(std::memory_order_relaxed);
+    do
+    {
+        if (count > capacity - start)
+        {
+            return false;
+        }
+    } while (!counter.compare_exchange_weak(start, start + count, std::memory_order_relaxed));
+    outStart = start;
+    return true;
+}
+
+DebugVertex* DebugDraw::ReservePoints(unsigned int count)
+{
+    unsigned int start = 0;
+    if (!Reserve(mPointCount, (unsigned int)mPoints.size(), count, start))
+    {
+        mDropped.fetch_add(count, std::memory_order_relaxed);
+        return 0;
+    }
+    return &mPoints[start];
+}
+
+DebugVertex* DebugDraw::ReserveLines(unsigned int vertexCount)
+{
+    unsigned int start = 0;
+    if (!Reserve(mLineCount, (unsigned int)mLines.size(), vertexCount, start))
+    {
+        mDropped.fetch_add(vertexCount / 2, std::memory_order_relaxed);
+        return 0;
+    }
+    return &mLines[start];
+}
+
+void DebugDraw::Point(const vec3& position, const vec3& color)
+{
+    DebugVertex* out = ReservePoints(1);
+    if (out != 0)
+    {
+        out->position = position;
+        out->color = color;
+    }
+}
+
+void DebugDraw::Line(const vec3& from, const vec3& to, const vec3& color)
+{
+    DebugVertex* out = ReserveLines(2);
+    if (out != 0)
+    {
+        out[0].position = from;
+        out[0].color = color;
+        out[1].position = to;
+        out[1].color = color;
+    }
+}
+
+void DebugDraw::Box(const vec3& min, const vec3& max, const vec3& color)
+{
+    DebugVertex* out = ReserveLines(24);
+    if (out == 0)
+    {
+        return;
+    }
+
+    vec3 corners[8];
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        corners[i] = vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+    }
+    static const unsigned char edges[24] = {
+        0, 1, 2, 3, 4, 5, 6, 7, // along x
+        0, 2, 1, 3, 4, 6, 5, 7, // along y
+        0, 4, 1, 5, 2, 6, 3, 7  // along z
+    };
+    for (unsigned int i = 0; i < 24; ++i)
+    {
+        out[i].position = corners[edges[i]];
+        out[i].color = color;
+    }
+}
+
+void DebugDraw::BoneChain(const vec3* positions, const int* parents, unsigned int count, const vec3& color)
+{
+    unsigned int bones = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (parents[i] >= 0)
+        {
+            bones += 1;
+        }
+    }
+
+    DebugVertex* joints = ReservePoints(count);
+    if (joints != 0)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            joints[i].position = positions[i];
+            joints[i].color = color;
+        }
+    }
+
+    DebugVertex* lines = bones > 0 ? ReserveLines(bones * 2) : 0;
+    if (lines != 0)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (parents[i] < 0)
+            {
+                continue;
+            }
+            lines[0].position = positions[parents[i]];
+            lines[0].color = color;
+            lines[1].position = positions[i];
+            lines[1].color = color;
+            lines += 2;
+        }
+    }
+}
+
+void DebugDraw::Flush(const float* viewProjection)
+{
+    // Counters only cover successful reservations, see Reserve
+    unsigned int points = mPointCount.load(std::memory_order_relaxed);
+    unsigned int lines = mLineCount.load(std::memory_order_relaxed);
+    mPointCount.store(0, std::memory_order_relaxed);
+    mLineCount.store(0, std::memory_order_relaxed);
+    mDroppedLastFlush = mDropped.exchange(0, std::memory_order_relaxed);
+
+    if ((points == 0 && lines == 0) || mShader == 0)
+    {
+        return;
+    }
+    // A driver that optimised an attribute away reports -1, which GL rejects
+    if (mPositionSlot < 0 || mColorSlot < 0)
+    {
+        if (!mWarnedMissingAttributes)
+        {
+            std::cout << "WARNING: Debug draw shader is missing the position or color attribute, nothing will be drawn\n";
+            mWarnedMissingAttributes = true;
+        }
+        return;
+    }
+
+    GLsizeiptr lineOffset = (GLsizeiptr)(mPoints.size() * sizeof(DebugVertex));
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    // Orphan last frame's storage so the upload never waits on the GPU
+    glBufferData(GL_ARRAY_BUFFER, lineOffset + mLines.size() * sizeof(DebugVertex), 0, GL_STREAM_DRAW);
+    if (points > 0)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, points * sizeof(DebugVertex), &mPoints[0]);
+    }
+    if (lines > 0)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, lineOffset, lines * sizeof(DebugVertex), &mLines[0]);
+    }
+
+    mShader->Bind();
+    glUniformMatrix4fv(mViewProjectionSlot, 1, GL_FALSE, viewProjection);
+    glEnableVertexAttribArray(mPositionSlot);
+    glEnableVertexAttribArray(mColorSlot);
+    glVertexAttribPointer(mPositionSlot, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)0);
+    glVertexAttribPointer(mColorSlot, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)sizeof(vec3));
+
+    // The attribute pointers stay at offset 0, so the lines start at vertex maxPoints
+    if (points > 0)
+    {
+        glDrawArrays(GL_POINTS, 0, points);
+    }
+    if (lines > 0)
+    {
+        glDrawArrays(GL_LINES, (GLint)mPoints.size(), lines);
+    }
+
+    glDisableVertexAttribArray(mPositionSlot);
+    glDisableVertexAttribArray(mColorSlot);
+    mShader->UnBind();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int DebugDraw::GetPointCount() const
+{
+    return mPointCount.load(std::memory_order_relaxed);
+}
+
+unsigned int DebugDraw::GetLineCount() const
+{
+    return mLineCount.load(std::memory_order_relaxed) / 2;
+}
+
+unsigned int DebugDraw::GetDroppedCount() const
+{
+    return mDroppedLastFlush;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "../math/vec3.h"
+
+class Shader;
+
+struct DebugVertex
+{
+    vec3 position;
+    vec3 color;
+};
+
+// Immediate mode debug drawing. Primitives from any thread are accumulated into
+// fixed capacity per-frame arrays (a slot range is claimed with a compare and
+// swap, no locks) and Flush uploads them into one persistent vertex buffer and issues a
+// single draw per primitive type. Primitives past capacity are dropped and counted.
+class DebugDraw
+{
+private:
+    DebugDraw(const DebugDraw&);
+    DebugDraw& operator=(const DebugDraw&);
+
+protected:
+    std::vector<DebugVertex> mPoints;
+    std::vector<DebugVertex> mLines;
+    std::atomic<unsigned int> mPointCount;
+    std::atomic<unsigned int> mLineCount;
+    std::atomic<unsigned int> mDropped;
+    unsigned int mDroppedLastFlush;
+    unsigned int mVertexBuffer;
+    Shader* mShader;
+    int mPositionSlot;
+    int mColorSlot;
+    int mViewProjectionSlot;
+    // Set once Flush has warned about a shader without the vertex attributes
+    bool mWarnedMissingAttributes;
+
+    DebugVertex* ReservePoints(unsigned int count);
+    DebugVertex* ReserveLines(unsigned int vertexCount);
+
+public:
+    DebugDraw(unsigned int maxPoints = 16384, unsigned int maxLineVertices = 65536);
+    ~DebugDraw();
+
+    // GL resources. Call with a current context.
+    void Initialize();
+    void Release();
+
+    // Thread safe, lock free
+    void Point(const vec3& position, const vec3& color);
+    void Line(const vec3& from, const vec3& to, const vec3& color);
+    void Box(const vec3& min, const vec3& max, const vec3& color);
+    // One line from every joint to its parent (parents[i] < 0 for roots) and a point per joint
+    void BoneChain(const vec3* positions, const int* parents, unsigned int count, const vec3& color);
+
+    // Main thread only, after every producer for the frame has finished.
+    // viewProjection is a column major 4x4 matrix. Empties the frame.
+    void Flush(const float* viewProjection);
+
+    unsigned int GetPointCount() const;
+    unsigned int GetLineCount() const;
+    // Primitives dropped for lack of capacity in the frame drawn by the last Flush
+    unsigned int GetDroppedCount() const;
+};
@@ -0,0 +1,86 @@
+#include "FrameFences.h"
+
+// One second, in nanoseconds. The wait loops so a slow frame never deadlocks.
+#define FRAMEFENCES_WAIT_TIMEOUT 1000000000ull
+
+FrameFences::FrameFences()
+{
+    for (unsigned int i = 0; i < FRAMEFENCES_MAX_IN_FLIGHT; ++i)
+    {
+        mFences[i] = 0;
+    }
+    mMaxInFlight = 2;
+    mHead = 0;
+    mCount = 0;
+    mStalls = 0;
+}
+
+FrameFences::~FrameFences()
+{
+    // Fences belong to the context, which is usually gone by now.
+    // Call Release() while it is still current.
+}
+
+void FrameFences::SetMaxFramesInFlight(unsigned int inMaxFrames)
+{
+    if (inMaxFrames < 1)
+    {
+        inMaxFrames = 1;
+    }
+    if (inMaxFrames > FRAMEFENCES_MAX_IN_FLIGHT)
+    {
+        inMaxFrames = FRAMEFENCES_MAX_IN_FLIGHT;
+    }
+    mMaxInFlight = inMaxFrames;
+}
+
+unsigned int FrameFences::GetMaxFramesInFlight() const
+{
+    return mMaxInFlight;
+}
+
+void FrameFences::EndFrame()
+{
+    while (mCount >= mMaxInFlight)
+    {
+        unsigned int oldest = (mHead + FRAMEFENCES_MAX_IN_FLIGHT - mCount) % FRAMEFENCES_MAX_IN_FLIGHT;
+        GLsync fence = mFences[oldest];
+
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            mStalls += 1;
+            do
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAMEFENCES_WAIT_TIMEOUT);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fence);
+        mFences[oldest] = 0;
+        mCount -= 1;
+    }
+
+    mFences[mHead] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mHead = (mHead + 1) % FRAMEFENCES_MAX_IN_FLIGHT;
+    mCount += 1;
+}
+
+unsigned int FrameFences::GetStallCount() const
+{
+    return mStalls;
+}
+
+void FrameFences::Release()
+{
+    for (unsigned int i = 0; i < FRAMEFENCES_MAX_IN_FLIGHT; ++i)
+    {
+        if (mFences[i] != 0)
+        {
+            glDeleteSync(mFences[i]);
+            mFences[i] = 0;
+        }
+    }
+    mHead = 0;
+    mCount = 0;
+}
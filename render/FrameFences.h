@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../glad/glad.h"
+
+#define FRAMEFENCES_MAX_IN_FLIGHT 4
+
+// Bounds how many frames the CPU may queue ahead of the GPU using fence sync
+// objects. Unlike glFinish this only blocks when the queue is actually full, and
+// only until the oldest frame retires instead of until the GPU drains.
+class FrameFences
+{
+private:
+    FrameFences(const FrameFences&);
+    FrameFences& operator=(const FrameFences&);
+
+protected:
+    GLsync mFences[FRAMEFENCES_MAX_IN_FLIGHT];
+    unsigned int mMaxInFlight;
+    unsigned int mHead;
+    unsigned int mCount;
+    unsigned int mStalls;
+
+public:
+    FrameFences();
+    ~FrameFences();
+
+    // Clamped to [1, FRAMEFENCES_MAX_IN_FLIGHT]
+    void SetMaxFramesInFlight(unsigned int inMaxFrames);
+    unsigned int GetMaxFramesInFlight() const;
+
+    // Call right after SwapBuffers. Waits for the oldest frame if the queue is full,
+    // then fences the frame that was just submitted.
+    void EndFrame();
+    // Number of EndFrame calls that had to block on the GPU
+    unsigned int GetStallCount() const;
+    // Deletes all pending fences. Call before the context goes away.
+    void Release();
+};
@@ -0,0 +1,184 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "GLTrace.h"
+
+#if GL_TRACE
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../glad/glad.h"
+
+/*
+    Capture format, little endian:
+        header  "GLTR", u32 version, u8 pointer size, u16 function count,
+                then per function: u8 name length, name bytes
+        call    u16 function id, u8 payload size, arguments packed back to back
+        frame   u16 0xFFFF, u8 4, u32 frame index
+*/
+#define GLTRACE_VERSION 1
+#define GLTRACE_FRAME_ID 0xFFFF
+
+enum GLTraceFunction
+{
+#define GLAD_LAZY_PROC(ret, name, type, params, args) kTrace_##name,
+#define GLAD_LAZY_VOID(name, type, params, args) kTrace_##name,
+#include "../glad/glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+    kTraceFunctionCount
+};
+
+static const char* sTraceNames[] = {
+#define GLAD_LAZY_PROC(ret, name, type, params, args) #name,
+#define GLAD_LAZY_VOID(name, type, params, args) #name,
+#include "../glad/glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+};
+
+static FILE* sTraceFile = 0;
+static std::vector<unsigned char> sTraceBuffer;
+static unsigned int sTraceFrame = 0;
+
+template <typename T>
+static void TraceWrite(const T& value)
+{
+    const unsigned char* bytes = (const unsigned char*)&value;
+    sTraceBuffer.insert(sTraceBuffer.end(), bytes, bytes + sizeof(T));
+}
+
+static void TraceArgs()
+{
+}
+
+template <typename T, typename... Rest>
+static void TraceArgs(T first, Rest... rest)
+{
+    TraceWrite(first);
+    TraceArgs(rest...);
+}
+
+static size_t TraceCallBegin(unsigned short id)
+{
+    TraceWrite(id);
+    TraceWrite((unsigned char)0);
+    return sTraceBuffer.size();
+}
+
+// Patches the payload size once the arguments are written
+static void TraceCallEnd(size_t payloadStart)
+{
+    sTraceBuffer[payloadStart - 1] = (unsigned char)(sTraceBuffer.size() - payloadStart);
+}
+
+// The real (or lazily resolving) pointer each wrapper forwards to
+#define GLAD_LAZY_PROC(ret, name, type, params, args) \
+    static type sTraceReal_##name = 0; \
+    static ret APIENTRY Trace_##name params \
+    { \
+        size_t payload = TraceCallBegin((unsigned short)kTrace_##name); \
+        TraceArgs args; \
+        TraceCallEnd(payload); \
+        return sTraceReal_##name args; \
+    }
+#define GLAD_LAZY_VOID(name, type, params, args) \
+    static type sTraceReal_##name = 0; \
+    static void APIENTRY Trace_##name params \
+    { \
+        size_t payload = TraceCallBegin((unsigned short)kTrace_##name); \
+        TraceArgs args; \
+        TraceCallEnd(payload); \
+        sTraceReal_##name args; \
+    }
+#include "../glad/glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+bool GLTraceBegin(const char* inPath)
+{
+    if (sTraceFile != 0)
+    {
+        return false;
+    }
+    sTraceFile = fopen(inPath, "wb");
+    if (sTraceFile == 0)
+    {
+        return false;
+    }
+
+    sTraceBuffer.clear();
+    sTraceBuffer.reserve(64 * 1024);
+    sTraceFrame = 0;
+
+    sTraceBuffer.push_back('G');
+    sTraceBuffer.push_back('L');
+    sTraceBuffer.push_back('T');
+    sTraceBuffer.push_back('R');
+    TraceWrite((unsigned int)GLTRACE_VERSION);
+    TraceWrite((unsigned char)sizeof(void*));
+    TraceWrite((unsigned short)kTraceFunctionCount);
+    for (unsigned int i = 0; i < kTraceFunctionCount; ++i)
+    {
+        unsigned char length = (unsigned char)strlen(sTraceNames[i]);
+        TraceWrite(length);
+        sTraceBuffer.insert(sTraceBuffer.end(), sTraceNames[i], sTraceNames[i] + length);
+    }
+
+#define GLAD_LAZY_PROC(ret, name, type, params, args) \
+    sTraceReal_##name = glad_##name; \
+    if (glad_##name != 0) glad_##name = Trace_##name;
+#define GLAD_LAZY_VOID(name, type, params, args) \
+    sTraceReal_##name = glad_##name; \
+    if (glad_##name != 0) glad_##name = Trace_##name;
+#include "../glad/glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+    return true;
+}
+
+void GLTraceFrame()
+{
+    if (sTraceFile == 0)
+    {
+        return;
+    }
+    TraceWrite((unsigned short)GLTRACE_FRAME_ID);
+    TraceWrite((unsigned char)sizeof(unsigned int));
+    TraceWrite(sTraceFrame);
+    sTraceFrame += 1;
+
+    fwrite(&sTraceBuffer[0], 1, sTraceBuffer.size(), sTraceFile);
+    sTraceBuffer.clear();
+}
+
+void GLTraceEnd()
+{
+    if (sTraceFile == 0)
+    {
+        return;
+    }
+
+#define GLAD_LAZY_PROC(ret, name, type, params, args) \
+    if (glad_##name == Trace_##name) glad_##name = sTraceReal_##name;
+#define GLAD_LAZY_VOID(name, type, params, args) \
+    if (glad_##name == Trace_##name) glad_##name = sTraceReal_##name;
+#include "../glad/glad_lazy_list.h"
+#undef GLAD_LAZY_PROC
+#undef GLAD_LAZY_VOID
+
+    if (!sTraceBuffer.empty())
+    {
+        fwrite(&sTraceBuffer[0], 1, sTraceBuffer.size(), sTraceFile);
+    }
+    fclose(sTraceFile);
+    sTraceFile = 0;
+    sTraceBuffer.clear();
+}
+
+bool GLTraceIsActive()
+{
+    return sTraceFile != 0;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+// GL call tracing. Only compiled into debug builds: release builds see none of the
+// functions below and the glad pointers are never wrapped, so there is no cost.
+// Define GL_TRACE to 0 or 1 to override.
+#ifndef GL_TRACE
+#if defined(_DEBUG)
+#define GL_TRACE 1
+#else
+#define GL_TRACE 0
+#endif
+#endif
+
+#if GL_TRACE
+
+// Wraps every function in glad/glad_lazy_list.h so each call and its arguments are
+// appended to a binary capture at inPath. Call after GL is loaded. Use
+// tools/gltrace_analyze.cpp to read the capture.
+bool GLTraceBegin(const char* inPath);
+// Writes a frame marker and flushes the calls recorded since the last one
+void GLTraceFrame();
+// Restores the original glad pointers and closes the capture
+void GLTraceEnd();
+bool GLTraceIsActive();
+
+#endif
@@ -0,0 +1,350 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <unordered_map>
+
+#include "../glad/glad.h"
+#include "Shader.h"
+
+struct ShaderNameTable
+{
+    std::mutex lock;
+    std::unordered_map<std::string, unsigned int> ids;
+    // deque so references returned by GetName survive growth
+    std::deque<std::string> names;
+};
+
+// Function local so ids can be interned from static initializers
+static ShaderNameTable& GetNameTable()
+{
+    static ShaderNameTable table;
+    return table;
+}
+
+static bool FindName(const std::string& name, unsigned int& outId)
+{
+    ShaderNameTable& table = GetNameTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    std::unordered_map<std::string, unsigned int>::const_iterator it = table.ids.find(name);
+    if (it == table.ids.end())
+    {
+        return false;
+    }
+    outId = it->second;
+    return true;
+}
+
+Shader::Shader()
+{
+    mHandle = glCreateProgram();
+    mLookupsAvoided = 0;
+}
+
+Shader::Shader(const std::string& vertex, const std::string& fragment)
+{
+    mHandle = glCreateProgram();
+    mLookupsAvoided = 0;
+    Load(vertex, fragment);
+}
+
+Shader::~Shader()
+{
+    glDeleteProgram(mHandle);
+}
+
+unsigned int Shader::Intern(const std::string& name)
+{
+    ShaderNameTable& table = GetNameTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    std::unordered_map<std::string, unsigned int>::const_iterator it = table.ids.find(name);
+    if (it != table.ids.end())
+    {
+        return it->second;
+    }
+    unsigned int id = (unsigned int)table.names.size();
+    table.names.push_back(name);
+    table.ids[name] = id;
+    return id;
+}
+
+const std::string& Shader::GetName(unsigned int id)
+{
+    ShaderNameTable& table = GetNameTable();
+    std::lock_guard<std::mutex> guard(table.lock);
+    return table.names[id];
+}
+
+std::string Shader::ReadFile(const std::string& path)
+{
+    std::ifstream file;
+    file.open(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    file.close();
+    return contents.str();
+}
+
+unsigned int Shader::CompileVertexShader(const std::string& vertex)
+{
+    unsigned int v = glCreateShader(GL_VERTEX_SHADER);
+    const char* v_source = vertex.c_str();
+    glShaderSource(v, 1, &v_source, NULL);
+    glCompileShader(v);
+    int success = 0;
+    glGetShaderiv(v, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetShaderInfoLog(v, 512, NULL, infoLog);
+        std::cout << "Vertex compilation failed.\n";
+        std::cout << "\t" << infoLog << "\n";
+        glDeleteShader(v);
+        return 0;
+    }
+    return v;
+}
+
+unsigned int Shader::CompileFragmentShader(const std::string& fragment)
+{
+    unsigned int f = glCreateShader(GL_FRAGMENT_SHADER);
+    const char* f_source = fragment.c_str();
+    glShaderSource(f, 1, &f_source, NULL);
+    glCompileShader(f);
+    int success = 0;
+    glGetShaderiv(f, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetShaderInfoLog(f, 512, NULL, infoLog);
+        std::cout << "Fragment compilation failed.\n";
+        std::cout << "\t" << infoLog << "\n";
+        glDeleteShader(f);
+        return 0;
+    }
+    return f;
+}
+
+bool Shader::LinkShaders(unsigned int vertex, unsigned int fragment)
+{
+    glAttachShader(mHandle, vertex);
+    glAttachShader(mHandle, fragment);
+    glLinkProgram(mHandle);
+    int success = 0;
+    glGetProgramiv(mHandle, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(mHandle, 512, NULL, infoLog);
+        std::cout << "ERROR: Shader linking failed.\n";
+        std::cout << "\t" << infoLog << "\n";
+    }
+    glDetachShader(mHandle, vertex);
+    glDetachShader(mHandle, fragment);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return success != 0;
+}
+
+void Shader::SetSlot(std::vector<int>& slots, const std::string& name, int location)
+{
+    unsigned int id = Intern(name);
+    if (id >= slots.size())
+    {
+        slots.resize(id + 1, -1);
+    }
+    slots[id] = location;
+}
+
+void Shader::PopulateAttributes()
+{
+    int count = -1;
+    int length;
+    char name[128];
+    int size;
+    GLenum type;
+
+    glUseProgram(mHandle);
+    glGetProgramiv(mHandle, GL_ACTIVE_ATTRIBUTES, &count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        memset(name, 0, sizeof(char) * 128);
+        glGetActiveAttrib(mHandle, (GLuint)i, 128, &length, &size, &type, name);
+        int attrib = glGetAttribLocation(mHandle, name);
+        if (attrib >= 0)
+        {
+            SetSlot(mAttributes, name, attrib);
+        }
+    }
+
+    glUseProgram(0);
+}
+
+void Shader::PopulateUniforms()
+{
+    int count = -1;
+    int length;
+    char name[128];
+    int size;
+    GLenum type;
+    char testName[256];
+
+    glUseProgram(mHandle);
+    glGetProgramiv(mHandle, GL_ACTIVE_UNIFORMS, &count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        memset(name, 0, sizeof(char) * 128);
+        glGetActiveUniform(mHandle, (GLuint)i, 128, &length, &size, &type, name);
+
+        int uniform = glGetUniformLocation(mHandle, name);
+        if (uniform < 0)
+        {
+            continue;
+        }
+
+        // Arrays report as "name[0]". Register the bare name and every element.
+        std::string uniformName = name;
+        std::size_t found = uniformName.find('[');
+        if (found == std::string::npos)
+        {
+            SetSlot(mUniforms, uniformName, uniform);
+            continue;
+        }
+
+        uniformName.erase(uniformName.begin() + found, uniformName.end());
+        SetSlot(mUniforms, uniformName, uniform);
+        for (int element = 0; element < size; ++element)
+        {
+            memset(testName, 0, sizeof(char) * 256);
+            sprintf(testName, "%s[%d]", uniformName.c_str(), element);
+            int elementLocation = glGetUniformLocation(mHandle, testName);
+            if (elementLocation < 0)
+            {
+                break;
+            }
+            SetSlot(mUniforms, testName, elementLocation);
+        }
+    }
+
+    glUseProgram(0);
+}
+
+void Shader::Load(const std::string& vertex, const std::string& fragment)
+{
+    std::ifstream f(vertex.c_str());
+    bool vertFile = f.good();
+    f.close();
+
+    f = std::ifstream(fragment.c_str());
+    bool fragFile = f.good();
+    f.close();
+
+    std::string v_source = vertex;
+    if (vertFile)
+    {
+        v_source = ReadFile(vertex);
+    }
+
+    std::string f_source = fragment;
+    if (fragFile)
+    {
+        f_source = ReadFile(fragment);
+    }
+
+    mAttributes.clear();
+    mUniforms.clear();
+
+    unsigned int v = CompileVertexShader(v_source);
+    unsigned int fr = CompileFragmentShader(f_source);
+    if (v == 0 || fr == 0)
+    {
+        if (v != 0)
+        {
+            glDeleteShader(v);
+        }
+        if (fr != 0)
+        {
+            glDeleteShader(fr);
+        }
+        return;
+    }
+
+    if (LinkShaders(v, fr))
+    {
+        PopulateAttributes();
+        PopulateUniforms();
+    }
+}
+
+void Shader::Bind()
+{
+    glUseProgram(mHandle);
+}
+
+void Shader::UnBind()
+{
+    glUseProgram(0);
+}
+
+int Shader::GetAttribute(unsigned int nameId) const
+{
+    mLookupsAvoided += 1;
+    if (nameId >= mAttributes.size())
+    {
+        return -1;
+    }
+    return mAttributes[nameId];
+}
+
+int Shader::GetUniform(unsigned int nameId) const
+{
+    mLookupsAvoided += 1;
+    if (nameId >= mUniforms.size())
+    {
+        return -1;
+    }
+    return mUniforms[nameId];
+}
+
+int Shader::GetAttribute(const std::string& name) const
+{
+    unsigned int id = 0;
+    if (!FindName(name, id))
+    {
+        mLookupsAvoided += 1;
+        return -1;
+    }
+    return GetAttribute(id);
+}
+
+int Shader::GetUniform(const std::string& name) const
+{
+    unsigned int id = 0;
+    if (!FindName(name, id))
+    {
+        mLookupsAvoided += 1;
+        return -1;
+    }
+    return GetUniform(id);
+}
+
+unsigned int Shader::GetHandle() const
+{
+    return mHandle;
+}
+
+unsigned int Shader::GetLookupsAvoided() const
+{
+    return mLookupsAvoided;
+}
+
+void Shader::ResetLookupsAvoided()
+{
+    mLookupsAvoided = 0;
+}
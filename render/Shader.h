@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A linked GLSL program. All active attributes and uniforms are reflected once at
+// link time into tables indexed by interned name id, so per-frame lookups are a
+// bounds check and an array read instead of a glGet*Location string search.
+class Shader
+{
+private:
+    Shader(const Shader&);
+    Shader& operator=(const Shader&);
+
+protected:
+    unsigned int mHandle;
+    // Indexed by interned name id, -1 where the program has no such input
+    std::vector<int> mAttributes;
+    std::vector<int> mUniforms;
+    mutable unsigned int mLookupsAvoided;
+
+    std::string ReadFile(const std::string& path);
+    unsigned int CompileVertexShader(const std::string& vertex);
+    unsigned int CompileFragmentShader(const std::string& fragment);
+    bool LinkShaders(unsigned int vertex, unsigned int fragment);
+    void PopulateAttributes();
+    void PopulateUniforms();
+    static void SetSlot(std::vector<int>& slots, const std::string& name, int location);
+
+public:
+    Shader();
+    Shader(const std::string& vertex, const std::string& fragment);
+    ~Shader();
+
+    // Each argument is either a path to a file or the shader source itself
+    void Load(const std::string& vertex, const std::string& fragment);
+
+    void Bind();
+    void UnBind();
+
+    // Returns a process-wide id for name. Intern once (at init) and keep the id.
+    static unsigned int Intern(const std::string& name);
+    static const std::string& GetName(unsigned int id);
+
+    // -1 if the program has no active input with that name
+    int GetAttribute(unsigned int nameId) const;
+    int GetUniform(unsigned int nameId) const;
+    int GetAttribute(const std::string& name) const;
+    int GetUniform(const std::string& name) const;
+    unsigned int GetHandle() const;
+
+    // Number of location lookups served from the tables, each of which would
+    // otherwise have been a glGet*Location call
+    unsigned int GetLookupsAvoided() const;
+    void ResetLookupsAvoided();
+};
@@ -0,0 +1,652 @@
+// Micro benchmarks for the animation runtime on procedurally generated data, so
+// results compare between machines and changes. Standalone, build from the
+// repository root with any C++14 compiler:
+//     g++ -std=c++14 -O2 -msse2 -I. tools/anim_benchmark.cpp anim/*.cpp core/JobSystem.cpp math/*.cpp -o anim_benchmark -lpthread
+//     anim_benchmark [section...]
+// Sections: clips, compression, curves, graph, ik, motion, skinning.
+// With no arguments every section runs. Times are the best of several runs.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "anim/AnimationGraph.h"
+#include "anim/BakedClip.h"
+#include "anim/Blending.h"
+#include "anim/MotionDatabase.h"
+#include "anim/Clip.h"
+#include "anim/CompressedClip.h"
+#include "anim/CurveCompression.h"
+#include "anim/FABRIKBatch.h"
+#include "anim/FABRIKSolver.h"
+#include "anim/Pose.h"
+#include "anim/Skinning.h"
+
+#define BENCHMARK_RUNS 5
+#define BENCHMARK_JOINTS 64
+#define BENCHMARK_CLIP_SECONDS 4.0f
+// Keys per second of the generated source clips. Key times are jittered so the
+// key-searching tracks can't assume a uniform rate.
+#define BENCHMARK_KEY_RATE 60.0f
+
+// Keeps results alive so the optimizer can't drop the work being timed
+static volatile float sSink = 0.0f;
+
+// Seconds per iteration of body(i) over iterations, best of BENCHMARK_RUNS after
+// a warm up run
+template <typename F>
+double Time(unsigned int iterations, const F& body)
+{
+    double best = 0.0;
+    for (unsigned int run = 0; run <= BENCHMARK_RUNS; ++run)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i)
+        {
+            body(i);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / iterations;
+        if (run == 1 || (run > 1 && seconds < best))
+        {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+static void PrintHeader(const char* section)
+{
+    printf("\n%s\n%-48s %12s %12s\n", section, "", "us/call", "bytes");
+}
+
+static void PrintRow(const char* name, double seconds, unsigned int bytes)
+{
+    if (bytes > 0)
+    {
+        printf("%-48s %12.3f %12u\n", name, seconds * 1000000.0, bytes);
+    }
+    else
+    {
+        printf("%-48s %12.3f %12s\n", name, seconds * 1000000.0, "-");
+    }
+}
+
+static bool Wanted(int argc, char** argv, const char* section)
+{
+    if (argc < 2)
+    {
+        return true;
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], section) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A branching skeleton: a spine of a quarter of the joints with limbs of four
+// joints hanging off it
+static void MakeRestPose(Pose& outPose, unsigned int jointCount)
+{
+    outPose.Resize(jointCount);
+    unsigned int spine = jointCount / 4;
+    for (unsigned int j = 0; j < jointCount; ++j)
+    {
+        int parent = (int)j - 1;
+        if (j > spine && (j - spine) % 4 == 1)
+        {
+            parent = (int)((j - spine) / 4 % spine);
+        }
+        outPose.SetParent(j, j == 0 ? -1 : parent);
+        outPose.SetLocalTransform(j, Transform(vec3(0.0f, 0.1f, 0.0f), quat(0.0f, 0.0f, 0.0f, 1.0f), vec3(1.0f, 1.0f, 1.0f)));
+    }
+}
+
+// Looping clip with a rotation track on every joint and a position track on the
+// root, keyed at BENCHMARK_KEY_RATE with jittered key times. Clips with different
+// phases move differently.
+static void MakeClip(Clip& outClip, unsigned int jointCount, float duration, float phase = 0.0f)
+{
+    unsigned int keys = (unsigned int)(duration * BENCHMARK_KEY_RATE) + 1;
+    unsigned int random = 12345;
+    for (unsigned int j = 0; j < jointCount; ++j)
+    {
+        TransformTrack& track = outClip[j];
+        QuaternionTrack& rotation = track.GetRotationTrack();
+        rotation.Resize(keys);
+        rotation.SetInterpolation(Interpolation::Linear);
+        VectorTrack* position = j == 0 ? &track.GetPositionTrack() : 0;
+        if (position != 0)
+        {
+            position->Resize(keys);
+            position->SetInterpolation(Interpolation::Linear);
+        }
+        for (unsigned int k = 0; k < keys; ++k)
+        {
+            random = random * 1664525u + 1013904223u;
+            float jitter = (k > 0 && k + 1 < keys) ? ((float)(random >> 8) / 16777216.0f - 0.5f) * 0.5f : 0.0f;
+            float time = duration * ((float)k + jitter) / (float)(keys - 1);
+            quat q = angleAxis(0.8f * sinf(time * 3.0f + (float)j + phase), normalized(vec3(1.0f, 0.3f * (float)(j % 5), 0.2f)));
+            rotation[k].mTime = time;
+            memcpy(rotation[k].mValue, &q, sizeof(rotation[k].mValue));
+            if (position != 0)
+            {
+                vec3 p(sinf(time + phase) * 2.0f, 1.0f, time * (1.0f + 0.1f * phase));
+                (*position)[k].mTime = time;
+                memcpy((*position)[k].mValue, &p, sizeof((*position)[k].mValue));
+            }
+        }
+    }
+    outClip.SetLooping(true);
+    outClip.RecalculateDuration();
+}
+
+// Clip (key search), Clip with per instance cursors and BakedClip (direct index),
+// playing forward a frame at a time at 60 Hz as a character would
+static void BenchmarkClips()
+{
+    Pose rest;
+    MakeRestPose(rest, BENCHMARK_JOINTS);
+    Clip clip;
+    MakeClip(clip, BENCHMARK_JOINTS, BENCHMARK_CLIP_SECONDS);
+    BakedClip baked;
+    baked.Bake(clip, rest);
+
+    const unsigned int iterations = 2000;
+    const float step = 1.0f / 60.0f;
+    Pose pose = rest;
+    std::vector<TransformTrackCursor> cursors(clip.Size());
+
+    char title[128];
+    snprintf(title, sizeof(title), "clips: %u joints, %.0f s, %.0f keys/s source, %.0f Hz baked",
+        BENCHMARK_JOINTS, BENCHMARK_CLIP_SECONDS, BENCHMARK_KEY_RATE, BAKEDCLIP_DEFAULT_RATE);
+    PrintHeader(title);
+
+    double search = Time(iterations, [&](unsigned int i) {
+        clip.Sample(pose, (float)i * step);
+        sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+    });
+    PrintRow("Clip::Sample (key search)", search, clip.GetMemoryBytes());
+
+    double cursor = Time(iterations, [&](unsigned int i) {
+        clip.Sample(pose, (float)i * step, &cursors[0]);
+        sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+    });
+    PrintRow("Clip::Sample (cursors)", cursor, clip.GetMemoryBytes());
+
+    double direct = Time(iterations, [&](unsigned int i) {
+        baked.Sample(pose, (float)i * step);
+        sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+    });
+    PrintRow("BakedClip::Sample (direct index)", direct, baked.GetMemoryBytes());
+}
+
+// CompressedClip against the BakedClip it was built from: the size ratio, the
+// worst world space error Compress measured and Sample playing forward at 60 Hz.
+// On the benchmark skeleton and on a single 40 joint chain, where rotation
+// errors add up down the chain.
+static void BenchmarkCompression()
+{
+    const unsigned int iterations = 2000;
+    const float step = 1.0f / 60.0f;
+    const char* names[2] = { "skeleton", "40 joint chain" };
+    const unsigned int jointCounts[2] = { BENCHMARK_JOINTS, 40 };
+
+    char title[128];
+    snprintf(title, sizeof(title), "compression: %.0f s, %.0f Hz baked", BENCHMARK_CLIP_SECONDS, BAKEDCLIP_DEFAULT_RATE);
+    PrintHeader(title);
+
+    for (unsigned int c = 0; c < 2; ++c)
+    {
+        Pose rest;
+        MakeRestPose(rest, jointCounts[c]);
+        if (c == 1)
+        {
+            for (unsigned int j = 1; j < jointCounts[c]; ++j)
+            {
+                rest.SetParent(j, (int)j - 1);
+            }
+        }
+        Clip clip;
+        MakeClip(clip, jointCounts[c], BENCHMARK_CLIP_SECONDS);
+        BakedClip baked;
+        baked.Bake(clip, rest);
+        CompressedClip compressed;
+        compressed.Compress(baked, rest);
+        Pose pose = rest;
+
+        double direct = Time(iterations, [&](unsigned int i) {
+            baked.Sample(pose, (float)i * step);
+            sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+        });
+        double decode = Time(iterations, [&](unsigned int i) {
+            compressed.Sample(pose, (float)i * step);
+            sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+        });
+
+        char name[64];
+        snprintf(name, sizeof(name), "BakedClip::Sample, %s", names[c]);
+        PrintRow(name, direct, baked.GetMemoryBytes());
+        snprintf(name, sizeof(name), "CompressedClip::Sample (%.1fx, %.2f mm worst)",
+            compressed.GetCompressionRatio(), compressed.GetMaxError() * 1000.0f);
+        PrintRow(name, decode, compressed.GetMemoryBytes());
+    }
+}
+
+// FitCurves at a few tolerances: the size against the baked source, the worst
+// world space error it measured and CurveClip::Sample with per instance cursors,
+// playing forward at 60 Hz against BakedClip::Sample
+static void BenchmarkCurves()
+{
+    Pose rest;
+    MakeRestPose(rest, BENCHMARK_JOINTS);
+    Clip clip;
+    MakeClip(clip, BENCHMARK_JOINTS, BENCHMARK_CLIP_SECONDS);
+    BakedClip baked;
+    baked.Bake(clip, rest);
+
+    const unsigned int iterations = 2000;
+    const float step = 1.0f / 60.0f;
+    Pose pose = rest;
+
+    char title[128];
+    snprintf(title, sizeof(title), "curves: %u joints, %.0f s, %.0f Hz baked source",
+        BENCHMARK_JOINTS, BENCHMARK_CLIP_SECONDS, BAKEDCLIP_DEFAULT_RATE);
+    PrintHeader(title);
+
+    double direct = Time(iterations, [&](unsigned int i) {
+        baked.Sample(pose, (float)i * step);
+        sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+    });
+    PrintRow("BakedClip::Sample", direct, baked.GetMemoryBytes());
+
+    const float tolerances[3] = { 0.01f, 0.001f, 0.0001f };
+    for (float tolerance : tolerances)
+    {
+        CurveClip curves;
+        CurveCompressionReport report = FitCurves(baked, rest, curves, tolerance);
+        std::vector<TrackCursor> cursors(curves.GetChannelCount());
+        double seconds = Time(iterations, [&](unsigned int i) {
+            curves.Sample(pose, (float)i * step, cursors.empty() ? 0 : &cursors[0]);
+            sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "CurveClip::Sample %.1f mm (%.1fx, %.2f mm worst)",
+            tolerance * 1000.0f, report.GetCompressionRatio(), report.mMaxError * 1000.0f);
+        PrintRow(name, seconds, report.mBytes);
+    }
+}
+
+// AnimationGraph::Evaluate per character for a typical locomotion graph: a state
+// machine choosing between idle and a walk/run blend, with an upper body layer
+// masked on top. Measured settled in each state, so the skipped branch shows.
+static void BenchmarkGraph()
+{
+    Pose rest;
+    MakeRestPose(rest, BENCHMARK_JOINTS);
+    BakedClip baked[4];
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        Clip clip;
+        MakeClip(clip, BENCHMARK_JOINTS, BENCHMARK_CLIP_SECONDS, (float)i);
+        baked[i].Bake(clip, rest);
+    }
+
+    AnimationGraphDesc desc;
+    unsigned int speed = desc.AddParameter("speed");
+    unsigned int run = desc.AddParameter("run", 0.5f);
+    unsigned int wave = desc.AddParameter("wave", 1.0f);
+    unsigned int idle = desc.AddClip(&baked[0]);
+    unsigned int locomotion = desc.AddBlend(desc.AddClip(&baked[1]), desc.AddClip(&baked[2]), run);
+    unsigned int machine = desc.AddStateMachine();
+    desc.AddState(machine, "idle", idle);
+    desc.AddState(machine, "move", locomotion);
+    AnimationTransition start;
+    start.mFrom = 0;
+    start.mTo = 1;
+    start.mParameter = speed;
+    start.mThreshold = 0.5f;
+    desc.AddTransition(machine, start);
+    AnimationTransition stop = start;
+    stop.mFrom = 1;
+    stop.mTo = 0;
+    stop.mCondition = AnimationCondition::Less;
+    desc.AddTransition(machine, stop);
+    std::vector<float> upperBody;
+    MakeBoneMask(rest, BENCHMARK_JOINTS / 8, upperBody);
+    unsigned int output = desc.AddBlend(machine, desc.AddClip(&baked[3]), wave, upperBody);
+
+    AnimationGraph graph;
+    if (!graph.Compile(desc, output, rest))
+    {
+        printf("graph: could not compile\n");
+        return;
+    }
+    AnimationGraphInstance instance;
+    graph.CreateInstance(instance);
+    Pose pose = rest;
+
+    const unsigned int iterations = 2000;
+    char title[128];
+    snprintf(title, sizeof(title), "graph: %u joints, %u instructions, %u slots",
+        BENCHMARK_JOINTS, graph.GetInstructionCount(), graph.GetSlotCount());
+    PrintHeader(title);
+
+    const char* names[2] = { "Evaluate, idle", "Evaluate, walk/run blend" };
+    for (unsigned int state = 0; state < 2; ++state)
+    {
+        instance.SetParameter(speed, (float)state);
+        // Finish the transition before timing
+        for (unsigned int i = 0; i < 60; ++i)
+        {
+            graph.Evaluate(instance, 1.0f / 60.0f, pose);
+        }
+        instance.ResetStats();
+        double seconds = Time(iterations, [&](unsigned int) {
+            graph.Evaluate(instance, 1.0f / 60.0f, pose);
+            sSink = sSink + pose.GetLocalTransforms()[1].rotation.x;
+        });
+        const AnimationGraphStats& stats = instance.GetStats();
+        char name[64];
+        snprintf(name, sizeof(name), "%s (%.1f run, %.1f skipped)", names[state],
+            (double)stats.instructionsRun / (double)stats.evaluations, (double)stats.instructionsSkipped / (double)stats.evaluations);
+        PrintRow(name, seconds, 0);
+    }
+}
+
+// End effector of a chain in the FABRIK layout
+static vec3 ChainEnd(const Transform* chain, unsigned int jointCount)
+{
+    Transform world = chain[0];
+    for (unsigned int j = 1; j < jointCount; ++j)
+    {
+        world = combine(world, chain[j]);
+    }
+    return world.position;
+}
+
+// FABRIKBatch against FABRIKSolver on the same 1000 five joint chains with random
+// bends and goals, one in ten out of reach. Both start from the rest chains every
+// solve; the results must match to within a tenth of a millimetre.
+static void BenchmarkIK()
+{
+    const unsigned int chainCount = 1000;
+    const unsigned int jointCount = 5;
+    const float bone = 0.2f;
+    const unsigned int iterations = 20;
+
+    std::vector<Transform> chains(chainCount * jointCount);
+    std::vector<vec3> targets(chainCount);
+    unsigned int random = 4242;
+    for (unsigned int c = 0; c < chainCount; ++c)
+    {
+        float r[4];
+        for (unsigned int j = 0; j < jointCount; ++j)
+        {
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                random = random * 1664525u + 1013904223u;
+                r[i] = (float)(random >> 8) / 16777216.0f - 0.5f;
+            }
+            Transform& t = chains[c * jointCount + j];
+            t = Transform();
+            t.position = j == 0 ? vec3(0.0f, 0.0f, 0.0f) : vec3(0.0f, bone, 0.0f);
+            t.rotation = angleAxis(r[3] * 1.5f, normalized(vec3(r[0], r[1], r[2] + 0.01f)));
+        }
+        // Within 0.7 of the reach, or out at 1.5 times it
+        float reach = bone * (float)(jointCount - 1) * (c % 10 == 9 ? 1.5f : 0.7f);
+        targets[c] = normalized(vec3(r[0], r[1] + 0.6f, r[2])) * reach;
+    }
+
+    FABRIKSolver solver;
+    solver.Resize(jointCount);
+    FABRIKBatch batch;
+    batch.Resize(jointCount, chainCount);
+
+    // One solve each to compare results and iterations
+    unsigned long long scalarIterations = 0;
+    unsigned int scalarConverged = 0;
+    std::vector<vec3> scalarEnds(chainCount);
+    for (unsigned int c = 0; c < chainCount; ++c)
+    {
+        for (unsigned int j = 0; j < jointCount; ++j)
+        {
+            solver.SetLocalTransform(j, chains[c * jointCount + j]);
+        }
+        scalarConverged += solver.Solve(Transform(targets[c], quat(), vec3(1, 1, 1))) ? 1 : 0;
+        scalarIterations += solver.GetStats().iterations;
+        scalarEnds[c] = solver.GetGlobalTransform(jointCount - 1).position;
+    }
+    for (unsigned int c = 0; c < chainCount; ++c)
+    {
+        memcpy(batch.GetChain(c), &chains[c * jointCount], sizeof(Transform) * jointCount);
+        batch.SetTarget(c, targets[c]);
+    }
+    unsigned int batchConverged = batch.Solve();
+    float maxDifference = 0.0f;
+    for (unsigned int c = 0; c < chainCount; ++c)
+    {
+        maxDifference = fmaxf(maxDifference, len(ChainEnd(batch.GetChain(c), jointCount) - scalarEnds[c]));
+    }
+
+    double scalar = Time(iterations, [&](unsigned int) {
+        for (unsigned int c = 0; c < chainCount; ++c)
+        {
+            for (unsigned int j = 0; j < jointCount; ++j)
+            {
+                solver.SetLocalTransform(j, chains[c * jointCount + j]);
+            }
+            solver.Solve(Transform(targets[c], quat(), vec3(1, 1, 1)));
+            sSink = sSink + solver.GetLocalTransform(1).rotation.x;
+        }
+    });
+    double batched = Time(iterations, [&](unsigned int) {
+        for (unsigned int c = 0; c < chainCount; ++c)
+        {
+            memcpy(batch.GetChain(c), &chains[c * jointCount], sizeof(Transform) * jointCount);
+        }
+        batch.Solve();
+        sSink = sSink + batch.GetChain(0)[1].rotation.x;
+    });
+
+    char title[128];
+    snprintf(title, sizeof(title), "ik: %u chains of %u joints, %s (%.4f mm apart, %u/%u converged)",
+        chainCount, jointCount, maxDifference < 0.0001f && batchConverged == scalarConverged ? "results match" : "RESULTS DIFFER",
+        maxDifference * 1000.0f, batchConverged, scalarConverged);
+    PrintHeader(title);
+
+    char name[64];
+    snprintf(name, sizeof(name), "FABRIKSolver::Solve (%.2f iterations)", (double)scalarIterations / chainCount);
+    PrintRow(name, scalar / chainCount, 0);
+    snprintf(name, sizeof(name), "FABRIKBatch::Solve per chain (%.2f iterations)",
+        (double)batch.GetStats().iterations / chainCount);
+    PrintRow(name, batched / chainCount, 0);
+}
+
+// MotionDatabase::Search per character over 18000 frames (60 ten second clips at
+// 30 Hz), brute force against the KD-tree. Queries are frames of the database
+// with noise added, as the pose playing now is close to the data.
+static void BenchmarkMotionMatching()
+{
+    Pose rest;
+    MakeRestPose(rest, BENCHMARK_JOINTS);
+    const unsigned int clipCount = 60;
+    std::vector<BakedClip> clips(clipCount);
+    std::vector<RootMotion> rootMotion(clipCount);
+    for (unsigned int i = 0; i < clipCount; ++i)
+    {
+        Clip clip;
+        MakeClip(clip, BENCHMARK_JOINTS, 10.0f, (float)i * 0.1f);
+        clips[i].Bake(clip, rest);
+        rootMotion[i].Extract(clips[i], 0);
+    }
+
+    MotionDatabase database;
+    MotionFeatureConfig config;
+    config.mBones.push_back(BENCHMARK_JOINTS - 1);
+    config.mBones.push_back(BENCHMARK_JOINTS - 5);
+    database.SetConfig(config);
+    for (unsigned int i = 0; i < clipCount; ++i)
+    {
+        database.AddClip(clips[i], rest, &rootMotion[i]);
+    }
+    database.Build();
+
+    const unsigned int queryCount = 1000;
+    unsigned int dimensions = database.GetDimensions();
+    std::vector<float> queries(queryCount * dimensions);
+    unsigned int random = 54321;
+    for (unsigned int i = 0; i < queryCount; ++i)
+    {
+        random = random * 1664525u + 1013904223u;
+        database.GetFrameFeatures((random >> 8) % database.GetFrameCount(), &queries[i * dimensions]);
+        for (unsigned int d = 0; d < dimensions; ++d)
+        {
+            random = random * 1664525u + 1013904223u;
+            queries[i * dimensions + d] += ((float)(random >> 8) / 16777216.0f - 0.5f) * 0.1f;
+        }
+    }
+    std::vector<MotionMatch> matches(queryCount);
+
+    char title[128];
+    snprintf(title, sizeof(title), "motion: %u frames, %u dimensions, %u tree nodes",
+        database.GetFrameCount(), dimensions, database.GetNodeCount());
+    PrintHeader(title);
+
+    const char* names[2] = { "Search, brute force", "Search, KD-tree" };
+    const MotionSearch methods[2] = { MotionSearch::BruteForce, MotionSearch::KDTree };
+    for (unsigned int m = 0; m < 2; ++m)
+    {
+        double seconds = Time(1, [&](unsigned int) {
+            database.SearchBatch(&queries[0], queryCount, &matches[0], methods[m]);
+            sSink = sSink + matches[0].mCost;
+        });
+        PrintRow(names[m], seconds / queryCount, m == 0 ? database.GetMemoryBytes() : 0);
+    }
+}
+
+// CPUSkinMesh on one core (no job system), linear blend and dual quaternion, for
+// a mesh whose vertices all have 4 or all have 8 influences on random joints
+static void BenchmarkSkinning()
+{
+    Pose rest;
+    MakeRestPose(rest, BENCHMARK_JOINTS);
+    Clip clip;
+    MakeClip(clip, BENCHMARK_JOINTS, BENCHMARK_CLIP_SECONDS);
+    Pose pose = rest;
+    clip.Sample(pose, 1.0f);
+
+    std::vector<mat4> invBindPose(BENCHMARK_JOINTS);
+    for (unsigned int j = 0; j < BENCHMARK_JOINTS; ++j)
+    {
+        invBindPose[j] = inverse(transformToMat4(rest.GetGlobalTransform(j)));
+    }
+    std::vector<DualQuaternion> invBindDualQuats;
+    CPUSkinMesh::BuildInvBindDualQuats(rest, invBindDualQuats);
+    std::vector<mat4> palette;
+    std::vector<DualQuaternion> dualQuatPalette;
+    CPUSkinMesh::BuildPalette(pose, invBindPose, palette);
+    CPUSkinMesh::BuildDualQuatPalette(pose, invBindDualQuats, dualQuatPalette);
+
+    const unsigned int vertexCount = 65536;
+    const unsigned int iterations = 50;
+    std::vector<vec3> positions(vertexCount);
+    std::vector<vec3> normals(vertexCount);
+    std::vector<vec3> outPositions(vertexCount);
+    std::vector<vec3> outNormals(vertexCount);
+    unsigned int random = 777;
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        float c[3];
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            random = random * 1664525u + 1013904223u;
+            c[i] = (float)(random >> 8) / 16777216.0f - 0.5f;
+        }
+        positions[v] = vec3(c[0], c[1] * 2.0f + 1.0f, c[2]);
+        normals[v] = normalized(vec3(c[0], c[1], c[2] + 0.01f));
+    }
+
+    char title[128];
+    snprintf(title, sizeof(title), "skinning: %u vertices, %u joints, one core", vertexCount, BENCHMARK_JOINTS);
+    PrintHeader(title);
+
+    const unsigned int influenceCounts[2] = { 4, 8 };
+    for (unsigned int influences : influenceCounts)
+    {
+        std::vector<int> joints(vertexCount * influences);
+        std::vector<float> weights(vertexCount * influences);
+        for (unsigned int v = 0; v < vertexCount; ++v)
+        {
+            float total = 0.0f;
+            for (unsigned int i = 0; i < influences; ++i)
+            {
+                random = random * 1664525u + 1013904223u;
+                joints[v * influences + i] = (int)((random >> 8) % BENCHMARK_JOINTS);
+                weights[v * influences + i] = 0.1f + (float)((random >> 4) & 15);
+                total += weights[v * influences + i];
+            }
+            for (unsigned int i = 0; i < influences; ++i)
+            {
+                weights[v * influences + i] /= total;
+            }
+        }
+        CPUSkinMesh mesh;
+        mesh.Set(&positions[0], &normals[0], vertexCount, &joints[0], &weights[0], influences);
+
+        double linear = Time(iterations, [&](unsigned int) {
+            mesh.Skin(&palette[0], (unsigned int)palette.size(), &outPositions[0], &outNormals[0]);
+            sSink = sSink + outPositions[0].x;
+        });
+        double dualQuat = Time(iterations, [&](unsigned int) {
+            mesh.SkinDualQuat(&dualQuatPalette[0], (unsigned int)dualQuatPalette.size(), &outPositions[0], &outNormals[0]);
+            sSink = sSink + outPositions[0].x;
+        });
+
+        char name[64];
+        snprintf(name, sizeof(name), "Skin, linear, %u influences (%.1f M vertices/s)",
+            influences, (double)vertexCount / linear / 1000000.0);
+        PrintRow(name, linear, 0);
+        snprintf(name, sizeof(name), "SkinDualQuat, %u influences (%.1f M vertices/s)",
+            influences, (double)vertexCount / dualQuat / 1000000.0);
+        PrintRow(name, dualQuat, 0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (Wanted(argc, argv, "clips"))
+    {
+        BenchmarkClips();
+    }
+    if (Wanted(argc, argv, "compression"))
+    {
+        BenchmarkCompression();
+    }
+    if (Wanted(argc, argv, "curves"))
+    {
+        BenchmarkCurves();
+    }
+    if (Wanted(argc, argv, "graph"))
+    {
+        BenchmarkGraph();
+    }
+    if (Wanted(argc, argv, "ik"))
+    {
+        BenchmarkIK();
+    }
+    if (Wanted(argc, argv, "motion"))
+    {
+        BenchmarkMotionMatching();
+    }
+    if (Wanted(argc, argv, "skinning"))
+    {
+        BenchmarkSkinning();
+    }
+    return 0;
+}
@@ -0,0 +1,322 @@
+// Checks render/DebugDraw.cpp: four threads overfill the per-frame arrays and every
+// slot the counters cover must be written by a whole primitive, the arrays must end
+// exactly full and every primitive past capacity must be counted as dropped. Then
+// Flush against a stub GL, with and without the shader's vertex attributes. Needs
+// no GL context. Standalone, build from the repository root with any C++14 compiler:
+//     g++ -std=c++14 -O2 -I. tools/debug_draw_test.cpp render/DebugDraw.cpp render/Shader.cpp glad/glad.c -o debug_draw_test -lpthread -ldl
+//     debug_draw_test
+// Add -fsanitize=thread to check the reservations for races. Exits with 1 on the
+// first mismatch.
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "glad/glad.h"
+#include "render/DebugDraw.h"
+
+#define TEST_THREADS 4
+#define TEST_MAX_POINTS 4096
+#define TEST_MAX_LINE_VERTICES 16384
+// Per thread, enough that the threads together ask for about twice the capacity
+#define TEST_POINTS 2048
+#define TEST_BOXES 128
+#define TEST_LINES 2560
+#define TEST_STUB_PROGRAM 1
+
+// Exposes the frame's arrays and counters
+class TestDebugDraw : public DebugDraw
+{
+public:
+    TestDebugDraw() : DebugDraw(TEST_MAX_POINTS, TEST_MAX_LINE_VERTICES) {}
+    const DebugVertex* GetPoints() const { return &mPoints[0]; }
+    const DebugVertex* GetLines() const { return &mLines[0]; }
+    unsigned int GetLineVertexCount() const { return mLineCount.load(); }
+};
+
+// Every primitive a thread draws has color (thread, primitive, 0), so the arrays
+// show who wrote each slot. Boxes are 24 vertices of one color, lines 2.
+static void Produce(DebugDraw& draw, unsigned int thread)
+{
+    float id = (float)(thread + 1);
+    for (unsigned int i = 0; i < TEST_POINTS; ++i)
+    {
+        draw.Point(vec3((float)i, 0.0f, 0.0f), vec3(id, (float)i, 0.0f));
+    }
+    for (unsigned int i = 0; i < TEST_BOXES; ++i)
+    {
+        draw.Box(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f), vec3(id, (float)i, 24.0f));
+        draw.Line(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(id, (float)i, 2.0f));
+    }
+    // Lines last, so the line array fills to its last pair whatever the boxes left
+    for (unsigned int i = TEST_BOXES; i < TEST_LINES; ++i)
+    {
+        draw.Line(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(id, (float)i, 2.0f));
+    }
+}
+
+static bool Expect(const char* what, unsigned int got, unsigned int expected)
+{
+    if (got != expected)
+    {
+        printf("FAIL: %s is %u, expected %u\n", what, got, expected);
+        return false;
+    }
+    return true;
+}
+
+static bool Written(const DebugVertex& vertex)
+{
+    return vertex.color.x >= 1.0f && vertex.color.x <= (float)TEST_THREADS;
+}
+
+static bool SameColor(const DebugVertex& a, const DebugVertex& b)
+{
+    return memcmp(&a.color, &b.color, sizeof(a.color)) == 0;
+}
+
+static bool CheckOverflow()
+{
+    TestDebugDraw draw;
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < TEST_THREADS; ++t)
+    {
+        threads.push_back(std::thread(Produce, std::ref(draw), t));
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    unsigned int points = draw.GetPointCount();
+    unsigned int lineVertices = draw.GetLineVertexCount();
+    if (!Expect("points", points, TEST_MAX_POINTS) || !Expect("line vertices", lineVertices, TEST_MAX_LINE_VERTICES))
+    {
+        return false;
+    }
+    for (unsigned int i = 0; i < points; ++i)
+    {
+        if (!Written(draw.GetPoints()[i]))
+        {
+            printf("FAIL: point %u was never written\n", i);
+            return false;
+        }
+    }
+    // Walk the primitives: each starts with its length in the color's z
+    unsigned int boxes = 0;
+    const DebugVertex* lines = draw.GetLines();
+    for (unsigned int i = 0; i < lineVertices;)
+    {
+        unsigned int length = (unsigned int)lines[i].color.z;
+        if (!Written(lines[i]) || (length != 2 && length != 24) || i + length > lineVertices)
+        {
+            printf("FAIL: line vertex %u doesn't start a primitive\n", i);
+            return false;
+        }
+        for (unsigned int v = 1; v < length; ++v)
+        {
+            if (!SameColor(lines[i], lines[i + v]))
+            {
+                printf("FAIL: primitive at line vertex %u is torn at %u\n", i, i + v);
+                return false;
+            }
+        }
+        boxes += length == 24 ? 1 : 0;
+        i += length;
+    }
+
+    // Dropped boxes count their 12 lines
+    unsigned int requested = TEST_THREADS * (TEST_POINTS + TEST_BOXES * 12 + TEST_LINES);
+    unsigned int drawn = points + lineVertices / 2;
+    draw.Flush(0);
+    if (!Expect("dropped", draw.GetDroppedCount(), requested - drawn) ||
+        !Expect("points after flush", draw.GetPointCount(), 0) ||
+        !Expect("lines after flush", draw.GetLineCount(), 0))
+    {
+        return false;
+    }
+    printf("%u threads filled %u points and %u line vertices (%u boxes), %u dropped\n",
+        TEST_THREADS, points, lineVertices, boxes, draw.GetDroppedCount());
+    return true;
+}
+
+// A stub GL for Flush: a program whose active attributes are sAttributeCount of
+// position and color, and counters of the draws issued
+static unsigned int sAttributeCount = 2;
+static unsigned int sDrawCalls = 0;
+static unsigned int sVerticesDrawn = 0;
+static const char* sAttributeNames[2] = { "position", "color" };
+
+static GLuint APIENTRY StubCreateProgram() { return TEST_STUB_PROGRAM; }
+static GLuint APIENTRY StubCreateShader(GLenum type) { return type == GL_VERTEX_SHADER ? 2 : 3; }
+static void APIENTRY StubShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+static void APIENTRY StubObject(GLuint) {}
+static void APIENTRY StubAttach(GLuint, GLuint) {}
+static void APIENTRY StubInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log)
+{
+    log[0] = '\0';
+    if (length != 0)
+    {
+        *length = 0;
+    }
+}
+
+static void APIENTRY StubGetShaderiv(GLuint, GLenum, GLint* params)
+{
+    *params = GL_TRUE;
+}
+
+static void APIENTRY StubGetProgramiv(GLuint, GLenum pname, GLint* params)
+{
+    if (pname == GL_ACTIVE_ATTRIBUTES)
+    {
+        *params = (GLint)sAttributeCount;
+    }
+    else if (pname == GL_ACTIVE_UNIFORMS)
+    {
+        *params = 1;
+    }
+    else
+    {
+        *params = GL_TRUE;
+    }
+}
+
+static void APIENTRY StubGetActiveAttrib(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    snprintf(name, (size_t)bufSize, "%s", sAttributeNames[index]);
+    if (length != 0)
+    {
+        *length = (GLsizei)strlen(name);
+    }
+    *size = 1;
+    *type = GL_FLOAT_VEC3;
+}
+
+static void APIENTRY StubGetActiveUniform(GLuint, GLuint, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    snprintf(name, (size_t)bufSize, "viewProjection");
+    if (length != 0)
+    {
+        *length = (GLsizei)strlen(name);
+    }
+    *size = 1;
+    *type = GL_FLOAT_MAT4;
+}
+
+static GLint APIENTRY StubGetAttribLocation(GLuint, const GLchar* name)
+{
+    for (unsigned int i = 0; i < sAttributeCount; ++i)
+    {
+        if (strcmp(sAttributeNames[i], name) == 0)
+        {
+            return (GLint)i;
+        }
+    }
+    return -1;
+}
+
+static GLint APIENTRY StubGetUniformLocation(GLuint, const GLchar* name)
+{
+    return strcmp(name, "viewProjection") == 0 ? 0 : -1;
+}
+
+static void APIENTRY StubBuffers(GLsizei n, GLuint* buffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        buffers[i] = 1;
+    }
+}
+
+static void APIENTRY StubDeleteBuffers(GLsizei, const GLuint*) {}
+static void APIENTRY StubBindBuffer(GLenum, GLuint) {}
+static void APIENTRY StubBufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+static void APIENTRY StubBufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) {}
+static void APIENTRY StubUniformMatrix(GLint, GLsizei, GLboolean, const GLfloat*) {}
+static void APIENTRY StubVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+
+static void APIENTRY StubDrawArrays(GLenum, GLint, GLsizei count)
+{
+    sDrawCalls += 1;
+    sVerticesDrawn += (unsigned int)count;
+}
+
+static void InstallStubs()
+{
+    glad_glCreateProgram = StubCreateProgram;
+    glad_glDeleteProgram = StubObject;
+    glad_glCreateShader = StubCreateShader;
+    glad_glShaderSource = StubShaderSource;
+    glad_glCompileShader = StubObject;
+    glad_glDeleteShader = StubObject;
+    glad_glGetShaderiv = StubGetShaderiv;
+    glad_glGetShaderInfoLog = StubInfoLog;
+    glad_glAttachShader = StubAttach;
+    glad_glDetachShader = StubAttach;
+    glad_glLinkProgram = StubObject;
+    glad_glGetProgramiv = StubGetProgramiv;
+    glad_glGetProgramInfoLog = StubInfoLog;
+    glad_glUseProgram = StubObject;
+    glad_glGetActiveAttrib = StubGetActiveAttrib;
+    glad_glGetActiveUniform = StubGetActiveUniform;
+    glad_glGetAttribLocation = StubGetAttribLocation;
+    glad_glGetUniformLocation = StubGetUniformLocation;
+    glad_glGenBuffers = StubBuffers;
+    glad_glDeleteBuffers = StubDeleteBuffers;
+    glad_glBindBuffer = StubBindBuffer;
+    glad_glBufferData = StubBufferData;
+    glad_glBufferSubData = StubBufferSubData;
+    glad_glUniformMatrix4fv = StubUniformMatrix;
+    glad_glEnableVertexAttribArray = StubObject;
+    glad_glDisableVertexAttribArray = StubObject;
+    glad_glVertexAttribPointer = StubVertexAttribPointer;
+    glad_glDrawArrays = StubDrawArrays;
+}
+
+// A frame of a point and a line through Flush, with attributeCount of the
+// shader's attributes active. Returns the draw calls issued.
+static unsigned int FlushFrame(unsigned int attributeCount)
+{
+    sAttributeCount = attributeCount;
+    sDrawCalls = 0;
+    sVerticesDrawn = 0;
+    DebugDraw draw(16, 16);
+    draw.Initialize();
+    const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    for (unsigned int frame = 0; frame < 2; ++frame)
+    {
+        draw.Point(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f));
+        draw.Line(vec3(0.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f));
+        draw.Flush(identity);
+    }
+    draw.Release();
+    return sDrawCalls;
+}
+
+static bool CheckFlush()
+{
+    InstallStubs();
+    if (!Expect("draw calls for two frames", FlushFrame(2), 4) ||
+        !Expect("vertices drawn", sVerticesDrawn, 6))
+    {
+        return false;
+    }
+    // Without color the slot is -1: no draws, one warning
+    if (!Expect("draw calls without the color attribute", FlushFrame(1), 0))
+    {
+        return false;
+    }
+    printf("Flush draws with both attributes and skips the draw without one\n");
+    return true;
+}
+
+int main()
+{
+    if (!CheckOverflow() || !CheckFlush())
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+// Checks core/FramePacer.cpp against a scripted FrameClock: frames end on the target
+// cadence, each wait sleeps until the overshoot estimate before the deadline and
+// spins the rest, the estimate follows the scripted wakeups, and the statistics
+// match the ones worked out by hand for a scripted run of frame times. Runs in
+// simulated time. Standalone, build from the repository root with any C++14 compiler:
+//     g++ -std=c++14 -O2 -I. tools/frame_pacer_test.cpp core/FramePacer.cpp -o frame_pacer_test -lpthread
+//     frame_pacer_test
+// Exits with 1 on the first mismatch.
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "core/FramePacer.h"
+
+// Simulated time a Relax() call takes
+#define TEST_SPIN_STEP 0.000001
+// Times compare to within a few spin steps
+#define TEST_TIME_TOLERANCE 0.000005
+// FramePacer's starting overshoot estimate, its floor and decay
+#define TEST_INITIAL_OVERSHOOT 0.001
+#define TEST_MIN_SPIN 0.0002
+#define TEST_OVERSHOOT_DECAY 0.05
+
+// Simulated clock. Sleeps wake late by the next scripted overshoot (the last one
+// repeats), Relax() advances by TEST_SPIN_STEP and work is added by the test.
+class MockFrameClock : public FrameClock
+{
+public:
+    double mTime = 0.0;
+    std::vector<double> mOvershoots;
+    unsigned int mSleeps = 0;
+    double mLastRequest = 0.0;
+    unsigned int mRelaxes = 0;
+
+    double Now() override
+    {
+        return mTime;
+    }
+
+    void Sleep(double inSeconds) override
+    {
+        double overshoot = 0.0;
+        if (!mOvershoots.empty())
+        {
+            overshoot = mOvershoots[mSleeps < mOvershoots.size() ? mSleeps : mOvershoots.size() - 1];
+        }
+        mSleeps += 1;
+        mLastRequest = inSeconds;
+        mTime += inSeconds + overshoot;
+    }
+
+    void Relax() override
+    {
+        mRelaxes += 1;
+        mTime += TEST_SPIN_STEP;
+    }
+};
+
+static bool ExpectNear(const char* what, unsigned int frame, double got, double expected, double tolerance)
+{
+    if (fabs(got - expected) > tolerance)
+    {
+        printf("FAIL: frame %u %s is %.7f, expected %.7f\n", frame, what, got, expected);
+        return false;
+    }
+    return true;
+}
+
+// 100 Hz with varying work and wakeups inside the estimate: every frame ends on
+// the deadline, which stays on multiples of the target from SetTargetRate
+static bool CheckCadence()
+{
+    MockFrameClock clock;
+    clock.mOvershoots = { 0.0005, 0.0002, 0.0008, 0.0 };
+    FramePacer pacer(&clock);
+    pacer.SetTargetRate(100.0f);
+
+    const double work[8] = { 0.002, 0.005, 0.0085, 0.0, 0.009, 0.001, 0.004, 0.007 };
+    double start = clock.mTime;
+    for (unsigned int frame = 0; frame < 8; ++frame)
+    {
+        clock.mTime += work[frame];
+        pacer.Wait();
+        if (!ExpectNear("end", frame, clock.mTime, start + 0.01 * (frame + 1), TEST_TIME_TOLERANCE))
+        {
+            return false;
+        }
+    }
+    printf("Cadence: 8 frames at 100 Hz each ended within %.0f us of its deadline\n", TEST_TIME_TOLERANCE * 1e6);
+    return true;
+}
+
+// Every wait sleeps for the time to the deadline less the overshoot estimate and
+// spins the remainder; the estimate jumps to a late wakeup, decays towards
+// accurate ones and never goes under its floor
+static bool CheckSleepSpinSplit()
+{
+    MockFrameClock clock;
+    clock.mOvershoots = { 0.0005, 0.0005, 0.003, 0.0005, 0.0, 0.0, 0.0 };
+    FramePacer pacer(&clock);
+    pacer.SetTargetRate(100.0f);
+
+    double deadline = clock.mTime + 0.01;
+    double estimate = TEST_INITIAL_OVERSHOOT;
+    if (!ExpectNear("initial estimate", 0, pacer.GetSleepOvershoot(), estimate, 1e-12))
+    {
+        return false;
+    }
+    for (unsigned int frame = 0; frame < (unsigned int)clock.mOvershoots.size(); ++frame)
+    {
+        clock.mTime += 0.004;
+        double remaining = deadline - clock.mTime;
+        unsigned int sleeps = clock.mSleeps;
+        clock.mRelaxes = 0;
+        pacer.Wait();
+
+        if (clock.mSleeps != sleeps + 1)
+        {
+            printf("FAIL: frame %u slept %u times\n", frame, clock.mSleeps - sleeps);
+            return false;
+        }
+        double overshoot = clock.mOvershoots[frame];
+        double woke = deadline - remaining + clock.mLastRequest + overshoot;
+        if (!ExpectNear("sleep", frame, clock.mLastRequest, remaining - estimate, 1e-12))
+        {
+            return false;
+        }
+
+        // Spun from the wakeup to the deadline, or not at all when woken late
+        double spin = deadline - woke;
+        unsigned int spins = spin > 0.0 ? (unsigned int)ceil(spin / TEST_SPIN_STEP - 1e-6) : 0;
+        if (clock.mRelaxes + 1 < spins || clock.mRelaxes > spins + 1)
+        {
+            printf("FAIL: frame %u spun %u times, expected %u\n", frame, clock.mRelaxes, spins);
+            return false;
+        }
+
+        estimate = overshoot > estimate ? overshoot : estimate + (overshoot - estimate) * TEST_OVERSHOOT_DECAY;
+        estimate = estimate < TEST_MIN_SPIN ? TEST_MIN_SPIN : estimate;
+        if (!ExpectNear("estimate", frame, pacer.GetSleepOvershoot(), estimate, 1e-12))
+        {
+            return false;
+        }
+
+        // A late wakeup misses the deadline, the next stays on the cadence
+        // unless it has passed too
+        deadline += 0.01;
+        deadline = deadline < woke ? woke + 0.01 : deadline;
+    }
+    printf("Sleep/spin split: sleeps stop at the overshoot estimate, which jumped to a 3 ms wakeup and decayed to %.3f ms\n",
+        pacer.GetSleepOvershoot() * 1000.0);
+    return true;
+}
+
+// Scripted work at 100 Hz with an exact clock. By hand, frames end at 10, 20, 34,
+// 40, 64 and 74 ms: the 14 ms frame is caught up on the next, the 24 ms one
+// restarts the cadence. Intervals 10, 10, 14, 6, 24, 10 ms deviate by 0, 0, 4, -4,
+// 14, 0 ms, and 20 ms of the 74 are spent waiting.
+static bool CheckStats()
+{
+    MockFrameClock clock;
+    FramePacer pacer(&clock);
+    pacer.SetTargetRate(100.0f);
+    pacer.ResetStats();
+
+    const double work[6] = { 0.004, 0.004, 0.014, 0.004, 0.024, 0.004 };
+    const double ends[6] = { 0.010, 0.020, 0.034, 0.040, 0.064, 0.074 };
+    for (unsigned int frame = 0; frame < 6; ++frame)
+    {
+        clock.mTime += work[frame];
+        pacer.Wait();
+        if (!ExpectNear("end", frame, clock.mTime, ends[frame], TEST_TIME_TOLERANCE))
+        {
+            return false;
+        }
+    }
+
+    FramePacerStats stats = pacer.GetStats();
+    if (stats.frames != 6 ||
+        !ExpectNear("average frame time", 6, stats.averageFrameTime, 0.074 / 6.0, TEST_TIME_TOLERANCE) ||
+        !ExpectNear("jitter", 6, stats.jitter, sqrt(0.000228 / 6.0), TEST_TIME_TOLERANCE) ||
+        !ExpectNear("max deviation", 6, stats.maxDeviation, 0.014, TEST_TIME_TOLERANCE) ||
+        !ExpectNear("cpu utilisation", 6, stats.cpuUtilisation, 1.0 - 0.020 / 0.074, 0.001))
+    {
+        return false;
+    }
+
+    // Unlimited: deviations are from the mean interval and nothing waits
+    MockFrameClock freeClock;
+    FramePacer unlimited(&freeClock);
+    const double intervals[3] = { 0.010, 0.020, 0.030 };
+    for (unsigned int frame = 0; frame < 3; ++frame)
+    {
+        freeClock.mTime += intervals[frame];
+        unlimited.Wait();
+    }
+    FramePacerStats free = unlimited.GetStats();
+    if (freeClock.mSleeps != 0 || freeClock.mRelaxes != 0 ||
+        !ExpectNear("unlimited average", 3, free.averageFrameTime, 0.020, 1e-9) ||
+        !ExpectNear("unlimited jitter", 3, free.jitter, sqrt(0.0002 / 3.0), 1e-9) ||
+        !ExpectNear("unlimited max deviation", 3, free.maxDeviation, 0.010, 1e-9) ||
+        !ExpectNear("unlimited cpu utilisation", 3, free.cpuUtilisation, 1.0, 1e-9))
+    {
+        return false;
+    }
+
+    printf("Stats: jitter %.3f ms, max deviation %.3f ms, cpu %.1f%% for the scripted run\n",
+        stats.jitter * 1000.0, stats.maxDeviation * 1000.0, stats.cpuUtilisation * 100.0);
+    return true;
+}
+
+int main()
+{
+    if (!CheckCadence() || !CheckSleepSpinSplit() || !CheckStats())
+    {
+        return 1;
+    }
+    return 0;
+}
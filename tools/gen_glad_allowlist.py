@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Generates glad/glad_lazy_list.h, the allow-list of GL entry points the
+application actually calls. The lazy loader and the GL trace layer only
+install stubs for functions in this list.
+
+Run from anywhere after adding calls to new GL functions:
+    python tools/gen_glad_allowlist.py
+
+With --check nothing is written; it exits with 1 if the list is out of date
+with the sources (for CI, or before building with a lazy or allow-list loader).
+"""
+
+import os
+import re
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+GLAD_HEADER = os.path.join(ROOT, "glad", "glad.h")
+OUTPUT = os.path.join(ROOT, "glad", "glad_lazy_list.h")
+SKIP_DIRS = {"glad", "tools", ".git", ".idea"}
+SOURCE_EXTENSIONS = (".cpp", ".h", ".c")
+# Needed by the loader itself to fill in GLVersion
+ALWAYS = {"glGetString"}
+
+TYPEDEF = re.compile(r"typedef (.+?) \(APIENTRYP (PFNGL\w+PROC)\)\((.*)\);")
+POINTER = re.compile(r"GLAPI (PFNGL\w+PROC) glad_(gl\w+);")
+CALL = re.compile(r"\b(gl[A-Z]\w*)\s*\(")
+
+
+def parse_glad():
+    typedefs = {}
+    functions = {}
+    with open(GLAD_HEADER) as header:
+        for line in header:
+            match = TYPEDEF.match(line)
+            if match:
+                typedefs[match.group(2)] = (match.group(1).strip(), match.group(3).strip())
+                continue
+            match = POINTER.match(line)
+            if match:
+                functions[match.group(2)] = match.group(1)
+    return typedefs, functions
+
+
+def argument_names(params):
+    if params in ("", "void"):
+        return []
+    names = []
+    for param in params.split(","):
+        names.append(re.findall(r"\w+", param)[-1])
+    return names
+
+
+def used_functions(known):
+    used = set(ALWAYS)
+    for directory, subdirs, files in os.walk(ROOT):
+        subdirs[:] = [d for d in subdirs if d not in SKIP_DIRS]
+        for name in files:
+            if not name.endswith(SOURCE_EXTENSIONS):
+                continue
+            with open(os.path.join(directory, name), errors="ignore") as source:
+                for match in CALL.finditer(source.read()):
+                    if match.group(1) in known:
+                        used.add(match.group(1))
+    return sorted(used)
+
+
+def main():
+    typedefs, functions = parse_glad()
+    lines = [
+        "/* Generated by tools/gen_glad_allowlist.py. Do not edit by hand. */",
+        "/* GLAD_LAZY_PROC(return type, name, pointer type, parameters, arguments) */",
+        "/* GLAD_LAZY_VOID(name, pointer type, parameters, arguments) */",
+        "",
+    ]
+    for function in used_functions(functions):
+        pointer = functions[function]
+        result, params = typedefs[pointer]
+        args = ", ".join(argument_names(params))
+        if result == "void":
+            lines.append("GLAD_LAZY_VOID(%s, %s, (%s), (%s))" % (function, pointer, params, args))
+        else:
+            lines.append("GLAD_LAZY_PROC(%s, %s, %s, (%s), (%s))" % (result, function, pointer, params, args))
+
+    text = "\n".join(lines) + "\n"
+    relative = os.path.relpath(OUTPUT, ROOT)
+    if "--check" in sys.argv[1:]:
+        current = ""
+        if os.path.exists(OUTPUT):
+            with open(OUTPUT, newline="") as existing:
+                current = existing.read()
+        if current != text:
+            print("%s is out of date, run tools/gen_glad_allowlist.py" % relative)
+            return 1
+        print("%s is up to date" % relative)
+        return 0
+
+    with open(OUTPUT, "w", newline="\n") as output:
+        output.write(text)
+    print("%s: %d functions" % (relative, len(lines) - 4))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
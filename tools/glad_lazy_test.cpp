@@ -0,0 +1,232 @@
+// Checks glad/glad_lazy.c against a fake loader that counts every lookup by name.
+// gladLoadGLLazy must resolve nothing but glGetString at load, resolve a function
+// once on its first call, patch the glad pointer so later calls go direct and leave
+// a wrapper installed over the stub in place. gladLoadGLAllowList must resolve every
+// listed function exactly once, at load. Needs no GL context. Standalone, build from
+// the repository root with any C++14 compiler:
+//     g++ -std=c++14 -O2 -I. tools/glad_lazy_test.cpp glad/glad.c glad/glad_lazy.c -o glad_lazy_test -ldl
+//     glad_lazy_test
+// Exits with 1 on the first mismatch.
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "glad/glad_lazy.h"
+
+// The one listed function the fake loader can't find
+#define TEST_MISSING "glDeleteSync"
+
+static std::map<std::string, int> sLookups;
+static int sLookupCount = 0;
+static int sClearCalls = 0;
+static GLbitfield sClearMask = 0;
+static int sViewportCalls = 0;
+static int sWrapperCalls = 0;
+static PFNGLVIEWPORTPROC sWrapped = 0;
+
+static const GLubyte* APIENTRY FakeGetString(GLenum name)
+{
+    return (const GLubyte*)(name == GL_VERSION ? "3.3 fake" : "fake");
+}
+
+static void APIENTRY FakeClear(GLbitfield mask)
+{
+    sClearCalls += 1;
+    sClearMask = mask;
+}
+
+static GLuint APIENTRY FakeCreateShader(GLenum type)
+{
+    return type == GL_VERTEX_SHADER ? 7 : 8;
+}
+
+static void APIENTRY FakeViewport(GLint, GLint, GLsizei, GLsizei)
+{
+    sViewportCalls += 1;
+}
+
+// Everything else the loader hands out; the test never calls them
+static void APIENTRY FakeUnused()
+{
+}
+
+static void* FakeLoad(const char* name)
+{
+    sLookups[name] += 1;
+    sLookupCount += 1;
+    if (strcmp(name, "glGetString") == 0)
+    {
+        return (void*)FakeGetString;
+    }
+    if (strcmp(name, "glClear") == 0)
+    {
+        return (void*)FakeClear;
+    }
+    if (strcmp(name, "glCreateShader") == 0)
+    {
+        return (void*)FakeCreateShader;
+    }
+    if (strcmp(name, "glViewport") == 0)
+    {
+        return (void*)FakeViewport;
+    }
+    if (strcmp(name, TEST_MISSING) == 0)
+    {
+        return 0;
+    }
+    return (void*)FakeUnused;
+}
+
+// Stands in for a layer like GLTrace that wraps whatever glad points at
+static void APIENTRY WrapViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    sWrapperCalls += 1;
+    sWrapped(x, y, width, height);
+}
+
+static void ResetLookups()
+{
+    sLookups.clear();
+    sLookupCount = 0;
+}
+
+static bool Expect(const char* what, int got, int expected)
+{
+    if (got != expected)
+    {
+        printf("FAIL: %s is %d, expected %d\n", what, got, expected);
+        return false;
+    }
+    return true;
+}
+
+static bool ExpectTrue(const char* what, bool value)
+{
+    if (!value)
+    {
+        printf("FAIL: %s\n", what);
+    }
+    return value;
+}
+
+static bool CheckLazy()
+{
+    ResetLookups();
+    if (!Expect("gladLoadGLLazy", gladLoadGLLazy(FakeLoad), 1) ||
+        !Expect("lookups at load", sLookupCount, 1) ||
+        !Expect("glGetString lookups at load", sLookups["glGetString"], 1) ||
+        !Expect("resolved at load", gladLazyResolvedCount(), 1) ||
+        !Expect("GL major version", GLVersion.major, 3) ||
+        !ExpectTrue("glClear points at a stub after load", glad_glClear != FakeClear))
+    {
+        return false;
+    }
+
+    // First call resolves and forwards, second goes direct
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!Expect("glClear lookups after the first call", sLookups["glClear"], 1) ||
+        !Expect("glClear calls", sClearCalls, 1) ||
+        !Expect("glClear mask", (int)sClearMask, GL_COLOR_BUFFER_BIT) ||
+        !ExpectTrue("glClear is patched to the real function", glad_glClear == FakeClear) ||
+        !Expect("resolved after glClear", gladLazyResolvedCount(), 2))
+    {
+        return false;
+    }
+    glClear(GL_DEPTH_BUFFER_BIT);
+    if (!Expect("glClear lookups after the second call", sLookups["glClear"], 1) ||
+        !Expect("glClear calls", sClearCalls, 2))
+    {
+        return false;
+    }
+
+    // A function with a result returns it through the stub
+    if (!Expect("glCreateShader through the stub", (int)glCreateShader(GL_VERTEX_SHADER), 7) ||
+        !Expect("glCreateShader direct", (int)glCreateShader(GL_FRAGMENT_SHADER), 8) ||
+        !Expect("glCreateShader lookups", sLookups["glCreateShader"], 1))
+    {
+        return false;
+    }
+
+    // A wrapper over the stub stays installed, and the stub it calls resolves once
+    sWrapped = glad_glViewport;
+    glad_glViewport = WrapViewport;
+    glViewport(0, 0, 640, 480);
+    glViewport(0, 0, 640, 480);
+    if (!Expect("glViewport lookups", sLookups["glViewport"], 1) ||
+        !Expect("glViewport calls", sViewportCalls, 2) ||
+        !Expect("wrapper calls", sWrapperCalls, 2) ||
+        !ExpectTrue("the wrapper is still installed", glad_glViewport == WrapViewport))
+    {
+        return false;
+    }
+
+    if (!Expect("lookups in total", sLookupCount, 4) ||
+        !Expect("resolved in total", gladLazyResolvedCount(), 4) ||
+        !Expect("missing", gladLazyMissingCount(), 0))
+    {
+        return false;
+    }
+
+    // Loading again forgets the old context: stubs back in, resolved afresh
+    ResetLookups();
+    gladLoadGLLazy(FakeLoad);
+    if (!ExpectTrue("glClear points at a stub after reloading", glad_glClear != FakeClear) ||
+        !Expect("resolved after reloading", gladLazyResolvedCount(), 1))
+    {
+        return false;
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!Expect("glClear lookups after reloading", sLookups["glClear"], 1))
+    {
+        return false;
+    }
+
+    printf("gladLoadGLLazy: 1 lookup at load, 1 per function on first call, patched after\n");
+    return true;
+}
+
+static bool CheckAllowList()
+{
+    ResetLookups();
+    int listSize = gladLazyListSize();
+    if (!Expect("gladLoadGLAllowList", gladLoadGLAllowList(FakeLoad), 1) ||
+        !Expect("lookups at load", sLookupCount, listSize) ||
+        !Expect("functions looked up", (int)sLookups.size(), listSize) ||
+        !Expect("resolved at load", gladLazyResolvedCount(), listSize - 1) ||
+        !Expect("missing at load", gladLazyMissingCount(), 1))
+    {
+        return false;
+    }
+    for (const std::pair<const std::string, int>& lookup : sLookups)
+    {
+        if (!Expect(lookup.first.c_str(), lookup.second, 1))
+        {
+            return false;
+        }
+    }
+
+    // Everything is direct already
+    int clearCalls = sClearCalls;
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!ExpectTrue("glClear is the real function", glad_glClear == FakeClear) ||
+        !Expect("glClear calls", sClearCalls - clearCalls, 1) ||
+        !Expect("lookups after calling", sLookupCount, listSize))
+    {
+        return false;
+    }
+
+    printf("gladLoadGLAllowList: %d listed functions, each looked up once at load, %d missing\n",
+        listSize, gladLazyMissingCount());
+    return true;
+}
+
+int main()
+{
+    if (!CheckLazy() || !CheckAllowList())
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+// Offline analyzer for captures written by render/GLTrace.cpp.
+// Standalone, build with any C++14 compiler:
+//     g++ -std=c++14 -O2 tools/gltrace_analyze.cpp -o gltrace_analyze
+//     gltrace_analyze gltrace.bin
+// Reports calls per frame, state sets that did not change any state, and bind churn.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#define GLTRACE_VERSION 1
+#define GLTRACE_FRAME_ID 0xFFFF
+
+// How a function touches GL state. Keyed functions hold one value per first argument
+// (per target or capability); the others hold a single value.
+enum StateKind
+{
+    kStateNone,
+    kStateWhole,
+    kStateKeyed,
+    kStateEnable,
+    kStateDisable
+};
+
+struct StateFunction
+{
+    const char* name;
+    StateKind kind;
+    bool bind;
+};
+
+static const StateFunction sStateFunctions[] = {
+    { "glEnable", kStateEnable, false },
+    { "glDisable", kStateDisable, false },
+    { "glPointSize", kStateWhole, false },
+    { "glLineWidth", kStateWhole, false },
+    { "glClearColor", kStateWhole, false },
+    { "glClearDepth", kStateWhole, false },
+    { "glViewport", kStateWhole, false },
+    { "glScissor", kStateWhole, false },
+    { "glDepthFunc", kStateWhole, false },
+    { "glDepthMask", kStateWhole, false },
+    { "glColorMask", kStateWhole, false },
+    { "glBlendFunc", kStateWhole, false },
+    { "glCullFace", kStateWhole, false },
+    { "glFrontFace", kStateWhole, false },
+    { "glPolygonMode", kStateWhole, false },
+    { "glActiveTexture", kStateWhole, false },
+    { "glUseProgram", kStateWhole, true },
+    { "glBindVertexArray", kStateWhole, true },
+    { "glBindBuffer", kStateKeyed, true },
+    { "glBindTexture", kStateKeyed, true },
+    { "glBindFramebuffer", kStateKeyed, true },
+    { "glBindRenderbuffer", kStateKeyed, true },
+};
+
+struct FunctionInfo
+{
+    std::string name;
+    const StateFunction* state = 0;
+    unsigned long long calls = 0;
+    unsigned long long redundant = 0;
+};
+
+struct FrameInfo
+{
+    unsigned int calls = 0;
+    unsigned int stateSets = 0;
+    unsigned int redundant = 0;
+    unsigned int binds = 0;
+    unsigned int redundantBinds = 0;
+};
+
+class Reader
+{
+protected:
+    std::vector<unsigned char> mData;
+    size_t mCursor = 0;
+
+public:
+    bool Load(const char* path)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == 0)
+        {
+            return false;
+        }
+        unsigned char chunk[64 * 1024];
+        size_t read = 0;
+        while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            mData.insert(mData.end(), chunk, chunk + read);
+        }
+        fclose(file);
+        return true;
+    }
+
+    bool Has(size_t bytes) const
+    {
+        return mCursor + bytes <= mData.size();
+    }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        memcpy(&value, &mData[mCursor], sizeof(T));
+        mCursor += sizeof(T);
+        return value;
+    }
+
+    std::string ReadBytes(size_t count)
+    {
+        std::string result((const char*)&mData[mCursor], count);
+        mCursor += count;
+        return result;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <capture>\n", argv[0]);
+        return 1;
+    }
+
+    Reader reader;
+    if (!reader.Load(argv[1]))
+    {
+        printf("Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    if (!reader.Has(11) || reader.ReadBytes(4) != "GLTR" || reader.Read<unsigned int>() != GLTRACE_VERSION)
+    {
+        printf("%s is not a GL trace capture\n", argv[1]);
+        return 1;
+    }
+    unsigned int pointerSize = reader.Read<unsigned char>();
+    unsigned int functionCount = reader.Read<unsigned short>();
+
+    std::vector<FunctionInfo> functions(functionCount);
+    for (unsigned int i = 0; i < functionCount; ++i)
+    {
+        if (!reader.Has(1))
+        {
+            printf("Truncated function table\n");
+            return 1;
+        }
+        unsigned int length = reader.Read<unsigned char>();
+        if (!reader.Has(length))
+        {
+            printf("Truncated function table\n");
+            return 1;
+        }
+        functions[i].name = reader.ReadBytes(length);
+        for (const StateFunction& state : sStateFunctions)
+        {
+            if (functions[i].name == state.name)
+            {
+                functions[i].state = &state;
+            }
+        }
+    }
+
+    // Current GL state as last set by the trace. Enable/disable share the capability key.
+    std::map<std::string, std::string> state;
+    std::vector<FrameInfo> frames(1);
+    std::map<std::string, unsigned long long> bindTargets;
+
+    while (reader.Has(3))
+    {
+        unsigned int id = reader.Read<unsigned short>();
+        unsigned int size = reader.Read<unsigned char>();
+        if (!reader.Has(size))
+        {
+            printf("Capture truncated mid call\n");
+            break;
+        }
+        std::string payload = reader.ReadBytes(size);
+
+        if (id == GLTRACE_FRAME_ID)
+        {
+            frames.push_back(FrameInfo());
+            continue;
+        }
+        if (id >= functionCount)
+        {
+            printf("Unknown function id %u, stopping\n", id);
+            break;
+        }
+
+        FunctionInfo& function = functions[id];
+        FrameInfo& frame = frames.back();
+        function.calls += 1;
+        frame.calls += 1;
+
+        const StateFunction* kind = function.state;
+        if (kind == 0)
+        {
+            continue;
+        }
+
+        std::string key;
+        std::string value;
+        switch (kind->kind)
+        {
+        case kStateEnable:
+        case kStateDisable:
+            key = "cap:" + payload;
+            value = kind->kind == kStateEnable ? "1" : "0";
+            break;
+        case kStateKeyed:
+            key = function.name + ":" + payload.substr(0, 4);
+            value = payload.substr(4);
+            break;
+        default:
+            key = function.name;
+            value = payload;
+            break;
+        }
+
+        frame.stateSets += 1;
+        bool redundant = false;
+        std::map<std::string, std::string>::iterator current = state.find(key);
+        if (current != state.end() && current->second == value)
+        {
+            redundant = true;
+        }
+        else
+        {
+            state[key] = value;
+        }
+
+        if (redundant)
+        {
+            function.redundant += 1;
+            frame.redundant += 1;
+        }
+        if (kind->bind)
+        {
+            frame.binds += 1;
+            bindTargets[key] += 1;
+            if (redundant)
+            {
+                frame.redundantBinds += 1;
+            }
+        }
+    }
+
+    // The last frame holds calls after the final marker (shutdown); report it separately
+    FrameInfo tail = frames.back();
+    frames.pop_back();
+
+    printf("Capture: %s (%u byte pointers, %u traced functions)\n", argv[1], pointerSize, functionCount);
+    printf("Frames: %zu\n", frames.size());
+    if (!frames.empty())
+    {
+        unsigned long long totalCalls = 0;
+        unsigned long long totalSets = 0;
+        unsigned long long totalRedundant = 0;
+        unsigned long long totalBinds = 0;
+        unsigned long long totalRedundantBinds = 0;
+        unsigned int minCalls = frames[0].calls;
+        unsigned int maxCalls = frames[0].calls;
+        for (const FrameInfo& frame : frames)
+        {
+            totalCalls += frame.calls;
+            totalSets += frame.stateSets;
+            totalRedundant += frame.redundant;
+            totalBinds += frame.binds;
+            totalRedundantBinds += frame.redundantBinds;
+            minCalls = std::min(minCalls, frame.calls);
+            maxCalls = std::max(maxCalls, frame.calls);
+        }
+        double count = (double)frames.size();
+        printf("Calls per frame: %.1f average, %u min, %u max\n", totalCalls / count, minCalls, maxCalls);
+        printf("State sets per frame: %.1f, redundant: %.1f (%.1f%%)\n", totalSets / count, totalRedundant / count,
+            totalSets > 0 ? 100.0 * totalRedundant / totalSets : 0.0);
+        printf("Binds per frame: %.1f, redundant: %.1f\n", totalBinds / count, totalRedundantBinds / count);
+    }
+    if (tail.calls > 0)
+    {
+        printf("Calls after the last frame: %u\n", tail.calls);
+    }
+
+    std::vector<const FunctionInfo*> sorted;
+    for (const FunctionInfo& function : functions)
+    {
+        if (function.calls > 0)
+        {
+            sorted.push_back(&function);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const FunctionInfo* a, const FunctionInfo* b) {
+        return a->calls > b->calls;
+    });
+
+    printf("\n%-28s %12s %12s\n", "Function", "Calls", "Redundant");
+    for (const FunctionInfo* function : sorted)
+    {
+        printf("%-28s %12llu %12llu\n", function->name.c_str(), function->calls, function->redundant);
+    }
+
+    if (!bindTargets.empty())
+    {
+        printf("\nBind churn (binds per frame by target):\n");
+        for (const auto& target : bindTargets)
+        {
+            std::string label = target.first.substr(0, target.first.find(':'));
+            if (target.first.size() > label.size() + 1)
+            {
+                unsigned int binding = 0;
+                memcpy(&binding, target.first.data() + label.size() + 1, sizeof(binding));
+                char suffix[32];
+                snprintf(suffix, sizeof(suffix), "(0x%04X)", binding);
+                label += suffix;
+            }
+            printf("  %-32s %.1f\n", label.c_str(), frames.empty() ? 0.0 : target.second / (double)frames.size());
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,259 @@
+// Checks render/Shader.cpp's link-time reflection against a stub GL that reports a
+// fixed program, and counts the location lookups a frame of draws avoids. Needs no
+// GL context. Standalone, build from the repository root with any C++14 compiler:
+//     g++ -std=c++14 -O2 -I. tools/shader_reflection_test.cpp render/Shader.cpp glad/glad.c -o shader_reflection_test -lpthread -ldl
+//     shader_reflection_test
+// Exits with 1 on the first mismatch.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "glad/glad.h"
+#include "render/Shader.h"
+
+#define STUB_PROGRAM 1
+#define STUB_POSE_SIZE 120
+#define TEST_DRAWS_PER_FRAME 100
+
+struct StubInput
+{
+    const char* name;
+    GLint size;
+    GLint location;
+};
+
+// What the stub program reports as active. Array uniforms are named "name[0]"
+// like a real driver; element n is at location + n.
+static const StubInput sAttributes[] = {
+    { "position", 1, 0 },
+    { "normal", 1, 1 },
+    { "texCoord", 1, 2 },
+    { "weights", 1, 3 },
+    { "joints", 1, 4 },
+};
+static const StubInput sUniforms[] = {
+    { "model", 1, 0 },
+    { "view", 1, 1 },
+    { "projection", 1, 2 },
+    { "light", 1, 3 },
+    { "pose[0]", STUB_POSE_SIZE, 10 },
+};
+
+static unsigned int sLocationCalls = 0;
+
+static GLint FindLocation(const StubInput* inputs, unsigned int count, const char* name)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (strcmp(inputs[i].name, name) == 0)
+        {
+            return inputs[i].location;
+        }
+        const char* bracket = strchr(inputs[i].name, '[');
+        if (bracket == 0)
+        {
+            continue;
+        }
+        // "pose" or "pose[n]"
+        size_t length = (size_t)(bracket - inputs[i].name);
+        if (strncmp(inputs[i].name, name, length) != 0)
+        {
+            continue;
+        }
+        if (name[length] == '\0')
+        {
+            return inputs[i].location;
+        }
+        int element = -1;
+        if (sscanf(name + length, "[%d]", &element) == 1 && element >= 0 && element < inputs[i].size)
+        {
+            return inputs[i].location + element;
+        }
+    }
+    return -1;
+}
+
+static void CopyName(const char* name, GLsizei bufSize, GLsizei* length, GLchar* out)
+{
+    size_t size = strlen(name);
+    if ((GLsizei)size >= bufSize)
+    {
+        size = (size_t)bufSize - 1;
+    }
+    memcpy(out, name, size);
+    out[size] = '\0';
+    if (length != 0)
+    {
+        *length = (GLsizei)size;
+    }
+}
+
+static GLuint APIENTRY StubCreateProgram() { return STUB_PROGRAM; }
+static GLuint APIENTRY StubCreateShader(GLenum type) { return type == GL_VERTEX_SHADER ? 2 : 3; }
+static void APIENTRY StubShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+static void APIENTRY StubShader(GLuint) {}
+static void APIENTRY StubProgramShader(GLuint, GLuint) {}
+static void APIENTRY StubInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log)
+{
+    CopyName("", 1, length, log);
+}
+
+static void APIENTRY StubGetShaderiv(GLuint, GLenum, GLint* params)
+{
+    *params = GL_TRUE;
+}
+
+static void APIENTRY StubGetProgramiv(GLuint, GLenum pname, GLint* params)
+{
+    if (pname == GL_ACTIVE_ATTRIBUTES)
+    {
+        *params = (GLint)(sizeof(sAttributes) / sizeof(sAttributes[0]));
+    }
+    else if (pname == GL_ACTIVE_UNIFORMS)
+    {
+        *params = (GLint)(sizeof(sUniforms) / sizeof(sUniforms[0]));
+    }
+    else
+    {
+        *params = GL_TRUE;
+    }
+}
+
+static void APIENTRY StubGetActiveAttrib(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    CopyName(sAttributes[index].name, bufSize, length, name);
+    *size = sAttributes[index].size;
+    *type = GL_FLOAT_VEC4;
+}
+
+static void APIENTRY StubGetActiveUniform(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    CopyName(sUniforms[index].name, bufSize, length, name);
+    *size = sUniforms[index].size;
+    *type = GL_FLOAT_MAT4;
+}
+
+static GLint APIENTRY StubGetAttribLocation(GLuint, const GLchar* name)
+{
+    sLocationCalls += 1;
+    return FindLocation(sAttributes, sizeof(sAttributes) / sizeof(sAttributes[0]), name);
+}
+
+static GLint APIENTRY StubGetUniformLocation(GLuint, const GLchar* name)
+{
+    sLocationCalls += 1;
+    return FindLocation(sUniforms, sizeof(sUniforms) / sizeof(sUniforms[0]), name);
+}
+
+static void InstallStubs()
+{
+    glad_glCreateProgram = StubCreateProgram;
+    glad_glDeleteProgram = StubShader;
+    glad_glCreateShader = StubCreateShader;
+    glad_glShaderSource = StubShaderSource;
+    glad_glCompileShader = StubShader;
+    glad_glDeleteShader = StubShader;
+    glad_glGetShaderiv = StubGetShaderiv;
+    glad_glGetShaderInfoLog = StubInfoLog;
+    glad_glAttachShader = StubProgramShader;
+    glad_glDetachShader = StubProgramShader;
+    glad_glLinkProgram = StubShader;
+    glad_glGetProgramiv = StubGetProgramiv;
+    glad_glGetProgramInfoLog = StubInfoLog;
+    glad_glUseProgram = StubShader;
+    glad_glGetActiveAttrib = StubGetActiveAttrib;
+    glad_glGetActiveUniform = StubGetActiveUniform;
+    glad_glGetAttribLocation = StubGetAttribLocation;
+    glad_glGetUniformLocation = StubGetUniformLocation;
+}
+
+static bool Expect(const char* what, int got, int expected)
+{
+    if (got != expected)
+    {
+        printf("FAIL: %s is %d, expected %d\n", what, got, expected);
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    InstallStubs();
+    Shader shader("void main() {}", "void main() {}");
+    unsigned int loadCalls = sLocationCalls;
+
+    // Every reflected input, by id and by name
+    for (const StubInput& attribute : sAttributes)
+    {
+        unsigned int id = Shader::Intern(attribute.name);
+        if (!Expect(attribute.name, shader.GetAttribute(id), attribute.location) ||
+            !Expect(attribute.name, shader.GetAttribute(attribute.name), attribute.location))
+        {
+            return 1;
+        }
+    }
+    for (const StubInput& uniform : sUniforms)
+    {
+        std::string name = uniform.name;
+        name = name.substr(0, name.find('['));
+        if (!Expect(name.c_str(), shader.GetUniform(Shader::Intern(name)), uniform.location) ||
+            !Expect(name.c_str(), shader.GetUniform(name), uniform.location))
+        {
+            return 1;
+        }
+    }
+    char element[32];
+    for (int i = 0; i < STUB_POSE_SIZE; ++i)
+    {
+        snprintf(element, sizeof(element), "pose[%d]", i);
+        if (!Expect(element, shader.GetUniform(element), 10 + i))
+        {
+            return 1;
+        }
+    }
+    if (!Expect("unknown uniform", shader.GetUniform("missing"), -1) ||
+        !Expect("unknown id", shader.GetUniform(Shader::Intern("alsoMissing")), -1) ||
+        !Expect("uniform as attribute", shader.GetAttribute("model"), -1) ||
+        !Expect("pose past its size", shader.GetUniform("pose[120]"), -1))
+    {
+        return 1;
+    }
+
+    // A frame of skinned draws: camera, light and model per draw plus the pose
+    // palette, each looked up through an id interned at init
+    unsigned int ids[4] = { Shader::Intern("model"), Shader::Intern("view"), Shader::Intern("projection"), Shader::Intern("light") };
+    unsigned int poseIds[STUB_POSE_SIZE];
+    for (int i = 0; i < STUB_POSE_SIZE; ++i)
+    {
+        snprintf(element, sizeof(element), "pose[%d]", i);
+        poseIds[i] = Shader::Intern(element);
+    }
+    shader.ResetLookupsAvoided();
+    unsigned int frameCalls = sLocationCalls;
+    int checksum = 0;
+    for (unsigned int draw = 0; draw < TEST_DRAWS_PER_FRAME; ++draw)
+    {
+        for (unsigned int id : ids)
+        {
+            checksum += shader.GetUniform(id);
+        }
+        for (unsigned int id : poseIds)
+        {
+            checksum += shader.GetUniform(id);
+        }
+    }
+    if (!Expect("glGet*Location calls during the frame", (int)(sLocationCalls - frameCalls), 0) ||
+        !Expect("lookups avoided", (int)shader.GetLookupsAvoided(), TEST_DRAWS_PER_FRAME * (4 + STUB_POSE_SIZE)) ||
+        !Expect("checksum", checksum, TEST_DRAWS_PER_FRAME * (0 + 1 + 2 + 3 + STUB_POSE_SIZE * 10 + STUB_POSE_SIZE * (STUB_POSE_SIZE - 1) / 2)))
+    {
+        return 1;
+    }
+
+    printf("Reflection matches the stub: %u attributes, %u uniform locations\n",
+        (unsigned int)(sizeof(sAttributes) / sizeof(sAttributes[0])), (unsigned int)(4 + 1 + STUB_POSE_SIZE));
+    printf("glGet*Location calls at load: %u, per frame: 0\n", loadCalls);
+    printf("Lookups avoided per frame of %u draws: %u\n", TEST_DRAWS_PER_FRAME, shader.GetLookupsAvoided());
+    return 0;
+}